@@ -1199,6 +1199,11 @@ static const setting_t gconf_defaults[] =
     .type = "i",
     .def  = G_STRINGIFY(MCE_DEFAULT_DISPLAY_NEVER_BLANK),
   },
+  {
+    .key  = MCE_SETTING_DISPLAY_SPECULATIVE_POWER_UP,
+    .type = "b",
+    .def  = G_STRINGIFY(MCE_DEFAULT_DISPLAY_SPECULATIVE_POWER_UP),
+  },
   {
     .key  = MCE_SETTING_DISPLAY_BRIGHTNESS,
     .type = "i",
@@ -1771,6 +1776,21 @@ static const setting_t gconf_defaults[] =
     .type = "i",
     .def  = G_STRINGIFY(MCE_DEFAULT_MEMNOTIFY_CRITICAL_ACTIVE)
   },
+  {
+    .key = MCE_SETTING_MEMNOTIFY_WARNING_STALL,
+    .type = "i",
+    .def  = G_STRINGIFY(MCE_DEFAULT_MEMNOTIFY_WARNING_STALL)
+  },
+  {
+    .key = MCE_SETTING_MEMNOTIFY_CRITICAL_STALL,
+    .type = "i",
+    .def  = G_STRINGIFY(MCE_DEFAULT_MEMNOTIFY_CRITICAL_STALL)
+  },
+  {
+    .key = MCE_SETTING_MEMNOTIFY_STALL_WINDOW,
+    .type = "i",
+    .def  = G_STRINGIFY(MCE_DEFAULT_MEMNOTIFY_STALL_WINDOW)
+  },
   {
     .key  = MCE_SETTING_TK_EXCEPT_LEN_CALL_IN,
     .type = "i",
@@ -2043,6 +2063,21 @@ static void gconf_client_mark_defaults(GConfClient *self)
   }
 }
 
+/** Release memory used for change broadcast book keeping
+ *
+ * Values are cached only for suppressing repeated broadcasts,
+ * so they can be dropped at any time.
+ */
+void gconf_client_trim(GConfClient *self)
+{
+  (void)self;
+
+  if( gconf_signal_sent )
+  {
+    g_hash_table_remove_all(gconf_signal_sent);
+  }
+}
+
 /** Reset to configured default values
  */
 int gconf_client_reset_defaults(GConfClient *self, const char *keyish)
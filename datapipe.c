@@ -25,11 +25,20 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-conf.h"
 
 #include <mce/mode-names.h>
 
 #include <linux/input.h>
 
+#include <sys/time.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
 /* Available datapipes */
 
 /** LED brightness */
@@ -238,6 +247,9 @@ datapipe_struct music_playback_pipe;
 /** proximity blanking; read only */
 datapipe_struct proximity_blank_pipe;
 
+/** memory pressure level; read only */
+datapipe_struct memnotify_level_pipe;
+
 /** wrist gesture; read only */
 datapipe_struct wristgesture_sensor_pipe;
 /**
@@ -360,6 +372,14 @@ EXIT:
 	return;
 }
 
+/** Datapipe execution nesting level */
+static guint datapipe_recorder_depth = 0;
+
+static void datapipe_recorder_add(const datapipe_struct *datapipe,
+				  gconstpointer indata,
+				  const data_source_t use_cache,
+				  const caching_policy_t cache_indata);
+
 /**
  * Execute the datapipe
  *
@@ -389,6 +409,9 @@ gconstpointer execute_datapipe(datapipe_struct *const datapipe,
 	if( use_cache == USE_CACHE )
 		indata = datapipe->cached_data;
 
+	datapipe_recorder_add(datapipe, indata, use_cache, cache_indata);
+	++datapipe_recorder_depth;
+
 	/* Optionally cache the value at the input stage */
 	if( cache_indata & (CACHE_INDATA|CACHE_OUTDATA) ) {
 		if( datapipe->free_cache == FREE_CACHE &&
@@ -416,9 +439,27 @@ gconstpointer execute_datapipe(datapipe_struct *const datapipe,
 		datapipe->cached_data = (gpointer)outdata;
 	}
 
+	/* Skip output value callbacks if nothing would change. Explicit
+	 * re-execution of cached value is assumed to be done on purpose
+	 * and is always passed through. */
+	if( datapipe->change_only == NOTIFY_ON_CHANGE &&
+	    use_cache == USE_INDATA && datapipe->have_outdata &&
+	    datapipe->last_outdata == outdata ) {
+		datapipe->suppressed += 1;
+		goto LEAVE;
+	}
+
+	/* Update before executing triggers, so that nested executions
+	 * are compared against the value that is being notified */
+	datapipe->have_outdata = TRUE;
+	datapipe->last_outdata = outdata;
+
 	/* Execute output value callbacks */
 	execute_datapipe_output_triggers(datapipe, outdata, USE_INDATA);
 
+LEAVE:
+	--datapipe_recorder_depth;
+
 EXIT:
 	return outdata;
 }
@@ -659,6 +700,10 @@ EXIT:
  *                  READ_WRITE if it's read/write
  * @param free_cache FREE_CACHE if the cached data needs to be freed,
  *                   DONT_FREE_CACHE if the cache data should not be freed
+ * @param change_only NOTIFY_ON_CHANGE if output triggers should be
+ *                    skipped when they would get the same value as
+ *                    the previous time, NOTIFY_ALWAYS if output
+ *                    triggers should be executed every time
  * @param datasize Pass size of memory to copy,
  *		   or 0 if only passing pointers or data as pointers
  * @param initial_data Initial cache content
@@ -666,6 +711,7 @@ EXIT:
 void setup_datapipe(datapipe_struct *const datapipe,
 		    const read_only_policy_t read_only,
 		    const cache_free_policy_t free_cache,
+		    const change_policy_t change_only,
 		    const gsize datasize, gpointer initial_data)
 {
 	if (datapipe == NULL) {
@@ -682,6 +728,24 @@ void setup_datapipe(datapipe_struct *const datapipe,
 	datapipe->read_only = read_only;
 	datapipe->free_cache = free_cache;
 	datapipe->cached_data = initial_data;
+	datapipe->change_only = change_only;
+	datapipe->have_outdata = FALSE;
+	datapipe->last_outdata = NULL;
+	datapipe->suppressed = 0;
+	datapipe->recorder_id = 0;
+
+	/* Comparing pointers to dynamically allocated data is not
+	 * meaningful, and filters could yield different output from
+	 * identical input - allow change only policy just for read
+	 * only pipes that pass values as pointers */
+	if (change_only == NOTIFY_ON_CHANGE &&
+	    (read_only != READ_ONLY || free_cache == FREE_CACHE ||
+	     datasize != 0)) {
+		mce_log(LL_ERR,
+			"setup_datapipe() called "
+			"with unsupported change only policy");
+		datapipe->change_only = NOTIFY_ALWAYS;
+	}
 
 EXIT:
 	return;
@@ -720,6 +784,13 @@ void free_datapipe(datapipe_struct *const datapipe)
 			"still has registered output_trigger(s)");
 	}
 
+	if (datapipe->suppressed != 0) {
+		mce_log(LL_DEBUG,
+			"free_datapipe() called on a datapipe that "
+			"skipped %u unchanged notification(s)",
+			datapipe->suppressed);
+	}
+
 	if (datapipe->free_cache == FREE_CACHE) {
 		g_free(datapipe->cached_data);
 	}
@@ -728,147 +799,752 @@ EXIT:
 	return;
 }
 
+/* ========================================================================= *
+ * EXECUTION RECORDER
+ * ========================================================================= */
+
+/** Magic bytes at the start of recording files */
+#define DATAPIPE_RECORDING_MAGIC "MCEDPREC"
+
+/** Recording file format version */
+#define DATAPIPE_RECORDING_VERSION 1
+
+/** Space reserved for datapipe names in recording files */
+#define DATAPIPE_RECORDING_NAME_SIZE 32
+
+/** Record flag: execution used cached value as input */
+#define DATAPIPE_RECORD_USE_CACHE (1<<0)
+
+/** Record flag: execution was made from within datapipe callback */
+#define DATAPIPE_RECORD_NESTED    (1<<1)
+
+/** How datapipe values can be recorded */
+typedef enum {
+	/** Values passed as pointers; can be recorded and replayed */
+	DATAPIPE_KIND_VALUE,
+	/** Pointer to input event pointer; event content is recorded */
+	DATAPIPE_KIND_EVENT,
+	/** Pointer to other data; only the fact of execution is recorded */
+	DATAPIPE_KIND_OPAQUE,
+} datapipe_kind_t;
+
+/** Recordable datapipe details */
+typedef struct {
+	/** Datapipe name, used for matching pipes on replay */
+	const char      *name;
+	/** Datapipe object */
+	datapipe_struct *pipe;
+	/** How data is passed through the datapipe */
+	datapipe_kind_t  kind;
+} datapipe_recorder_entry_t;
+
+/** Recording file header */
+typedef struct {
+	/** DATAPIPE_RECORDING_MAGIC */
+	char     magic[8];
+	/** DATAPIPE_RECORDING_VERSION */
+	uint32_t version;
+	/** Number of datapipe names following the header */
+	uint32_t pipes;
+	/** Number of records following the datapipe names */
+	uint32_t records;
+	/** Size of each datapipe name, DATAPIPE_RECORDING_NAME_SIZE */
+	uint32_t name_size;
+} datapipe_recording_header_t;
+
+/** One recorded datapipe execution */
+typedef struct {
+	/** Time since recorder start [ms] */
+	uint32_t tick;
+	/** Recorder pipe id, i.e. 1-based index to datapipe names */
+	uint16_t pipe;
+	/** DATAPIPE_RECORD_xxx bits */
+	uint8_t  flags;
+	/** Caching policy used for the execution */
+	uint8_t  cache;
+	/** Input value, or packed input event type / code / value */
+	int64_t  value;
+} datapipe_record_t;
+
+/** Helper for filling in datapipe lookup table */
+#define DATAPIPE_ENTRY(pipe_, kind_) { #pipe_, &pipe_, DATAPIPE_KIND_##kind_ }
+
+/** Datapipes that are included in recordings */
+static const datapipe_recorder_entry_t datapipe_recorder_lut[] =
+{
+	DATAPIPE_ENTRY(led_brightness_pipe, VALUE),
+	DATAPIPE_ENTRY(lpm_brightness_pipe, VALUE),
+	DATAPIPE_ENTRY(device_inactive_state_pipe, VALUE),
+	DATAPIPE_ENTRY(device_inactive_event_pipe, VALUE),
+	DATAPIPE_ENTRY(led_pattern_activate_pipe, OPAQUE),
+	DATAPIPE_ENTRY(led_pattern_deactivate_pipe, OPAQUE),
+	DATAPIPE_ENTRY(device_resumed_pipe, VALUE),
+	DATAPIPE_ENTRY(user_activity_pipe, OPAQUE),
+	DATAPIPE_ENTRY(display_state_pipe, VALUE),
+	DATAPIPE_ENTRY(display_state_req_pipe, VALUE),
+	DATAPIPE_ENTRY(display_state_next_pipe, VALUE),
+	DATAPIPE_ENTRY(exception_state_pipe, VALUE),
+	DATAPIPE_ENTRY(display_brightness_pipe, VALUE),
+	DATAPIPE_ENTRY(key_backlight_pipe, VALUE),
+	DATAPIPE_ENTRY(keypress_pipe, EVENT),
+	DATAPIPE_ENTRY(touchscreen_pipe, EVENT),
+	DATAPIPE_ENTRY(lockkey_pipe, VALUE),
+	DATAPIPE_ENTRY(keyboard_slide_pipe, VALUE),
+	DATAPIPE_ENTRY(keyboard_available_pipe, VALUE),
+	DATAPIPE_ENTRY(lid_sensor_is_working_pipe, VALUE),
+	DATAPIPE_ENTRY(lid_cover_sensor_pipe, VALUE),
+	DATAPIPE_ENTRY(lid_cover_policy_pipe, VALUE),
+	DATAPIPE_ENTRY(lens_cover_pipe, VALUE),
+	DATAPIPE_ENTRY(proximity_sensor_pipe, VALUE),
+	DATAPIPE_ENTRY(ambient_light_sensor_pipe, VALUE),
+	DATAPIPE_ENTRY(ambient_light_level_pipe, VALUE),
+	DATAPIPE_ENTRY(ambient_light_poll_pipe, VALUE),
+	DATAPIPE_ENTRY(orientation_sensor_pipe, VALUE),
+	DATAPIPE_ENTRY(alarm_ui_state_pipe, VALUE),
+	DATAPIPE_ENTRY(system_state_pipe, VALUE),
+	DATAPIPE_ENTRY(master_radio_pipe, VALUE),
+	DATAPIPE_ENTRY(submode_pipe, VALUE),
+	DATAPIPE_ENTRY(call_state_pipe, VALUE),
+	DATAPIPE_ENTRY(ignore_incoming_call_pipe, VALUE),
+	DATAPIPE_ENTRY(call_type_pipe, VALUE),
+	DATAPIPE_ENTRY(tk_lock_pipe, VALUE),
+	DATAPIPE_ENTRY(interaction_expected_pipe, VALUE),
+	DATAPIPE_ENTRY(charger_state_pipe, VALUE),
+	DATAPIPE_ENTRY(battery_status_pipe, VALUE),
+	DATAPIPE_ENTRY(battery_level_pipe, VALUE),
+	DATAPIPE_ENTRY(camera_button_pipe, VALUE),
+	DATAPIPE_ENTRY(inactivity_timeout_pipe, VALUE),
+	DATAPIPE_ENTRY(audio_route_pipe, VALUE),
+	DATAPIPE_ENTRY(usb_cable_pipe, VALUE),
+	DATAPIPE_ENTRY(jack_sense_pipe, VALUE),
+	DATAPIPE_ENTRY(power_saving_mode_pipe, VALUE),
+	DATAPIPE_ENTRY(thermal_state_pipe, VALUE),
+	DATAPIPE_ENTRY(heartbeat_pipe, VALUE),
+	DATAPIPE_ENTRY(compositor_available_pipe, VALUE),
+	DATAPIPE_ENTRY(lipstick_available_pipe, VALUE),
+	DATAPIPE_ENTRY(devicelock_available_pipe, VALUE),
+	DATAPIPE_ENTRY(usbmoded_available_pipe, VALUE),
+	DATAPIPE_ENTRY(ngfd_available_pipe, VALUE),
+	DATAPIPE_ENTRY(dsme_available_pipe, VALUE),
+	DATAPIPE_ENTRY(bluez_available_pipe, VALUE),
+	DATAPIPE_ENTRY(packagekit_locked_pipe, VALUE),
+	DATAPIPE_ENTRY(update_mode_pipe, VALUE),
+	DATAPIPE_ENTRY(shutting_down_pipe, VALUE),
+	DATAPIPE_ENTRY(device_lock_state_pipe, VALUE),
+	DATAPIPE_ENTRY(touch_detected_pipe, VALUE),
+	DATAPIPE_ENTRY(touch_grab_wanted_pipe, VALUE),
+	DATAPIPE_ENTRY(touch_grab_active_pipe, VALUE),
+	DATAPIPE_ENTRY(keypad_grab_wanted_pipe, VALUE),
+	DATAPIPE_ENTRY(keypad_grab_active_pipe, VALUE),
+	DATAPIPE_ENTRY(music_playback_pipe, VALUE),
+	DATAPIPE_ENTRY(proximity_blank_pipe, VALUE),
+	DATAPIPE_ENTRY(wristgesture_sensor_pipe, VALUE),
+	DATAPIPE_ENTRY(memnotify_level_pipe, VALUE),
+};
+
+/** Number of entries in datapipe_recorder_lut */
+#define DATAPIPE_RECORDER_PIPES G_N_ELEMENTS(datapipe_recorder_lut)
+
+/** Ring buffer for recorded executions */
+static datapipe_record_t *datapipe_recorder_ring = NULL;
+
+/** Number of records datapipe_recorder_ring can hold */
+static guint datapipe_recorder_size = 0;
+
+/** Total number of recorded executions */
+static guint datapipe_recorder_count = 0;
+
+/** Boot tick at recorder start [ms] */
+static int64_t datapipe_recorder_base = 0;
+
+/** Add datapipe execution to the recorder ring
+ *
+ * @param datapipe The datapipe that is being executed
+ * @param indata The input data for the execution
+ * @param use_cache The data source used for the execution
+ * @param cache_indata The caching policy used for the execution
+ */
+static void datapipe_recorder_add(const datapipe_struct *datapipe,
+				  gconstpointer indata,
+				  const data_source_t use_cache,
+				  const caching_policy_t cache_indata)
+{
+	if( !datapipe_recorder_ring || !datapipe->recorder_id )
+		goto EXIT;
+
+	guint slot = datapipe_recorder_count++ % datapipe_recorder_size;
+	datapipe_record_t *rec = datapipe_recorder_ring + slot;
+
+	rec->tick  = (uint32_t)(mce_lib_get_boot_tick() -
+				datapipe_recorder_base);
+	rec->pipe  = (uint16_t)datapipe->recorder_id;
+	rec->flags = 0;
+	rec->cache = (uint8_t)cache_indata;
+	rec->value = 0;
+
+	if( use_cache == USE_CACHE )
+		rec->flags |= DATAPIPE_RECORD_USE_CACHE;
+
+	if( datapipe_recorder_depth > 0 )
+		rec->flags |= DATAPIPE_RECORD_NESTED;
+
+	switch( datapipe_recorder_lut[datapipe->recorder_id - 1].kind ) {
+	case DATAPIPE_KIND_VALUE:
+		rec->value = (int64_t)GPOINTER_TO_SIZE(indata);
+		break;
+
+	case DATAPIPE_KIND_EVENT:
+		{
+			const struct input_event *const *evp = indata;
+			const struct input_event *ev = evp ? *evp : NULL;
+			if( ev )
+				rec->value = (int64_t)(((uint64_t)ev->type << 48) |
+						       ((uint64_t)ev->code << 32) |
+						       (uint32_t)ev->value);
+		}
+		break;
+
+	default:
+		break;
+	}
+
+EXIT:
+	return;
+}
+
+/** Write recorded datapipe executions to a file
+ *
+ * The file is written via temporary file, so that partial recordings
+ * are not left behind on failures.
+ *
+ * @param path Where to write the recording
+ *
+ * @return true on success, false on failure
+ */
+bool datapipe_recorder_dump(const char *path)
+{
+	bool   ack  = false;
+	gchar *temp = g_strdup_printf("%s.tmp", path);
+	FILE  *file = NULL;
+
+	if( !datapipe_recorder_ring ) {
+		mce_log(LL_WARN, "datapipe recorder is not enabled");
+		goto EXIT;
+	}
+
+	guint records = MIN(datapipe_recorder_count, datapipe_recorder_size);
+	guint first   = datapipe_recorder_count - records;
+
+	datapipe_recording_header_t head;
+	memset(&head, 0, sizeof head);
+	memcpy(head.magic, DATAPIPE_RECORDING_MAGIC, sizeof head.magic);
+	head.version   = DATAPIPE_RECORDING_VERSION;
+	head.pipes     = DATAPIPE_RECORDER_PIPES;
+	head.records   = records;
+	head.name_size = DATAPIPE_RECORDING_NAME_SIZE;
+
+	if( !(file = fopen(temp, "w")) ) {
+		mce_log(LL_ERR, "%s: can't open: %m", temp);
+		goto EXIT;
+	}
+
+	if( fwrite(&head, sizeof head, 1, file) != 1 )
+		goto FAIL;
+
+	for( guint i = 0; i < DATAPIPE_RECORDER_PIPES; ++i ) {
+		char name[DATAPIPE_RECORDING_NAME_SIZE];
+		memset(name, 0, sizeof name);
+		strncpy(name, datapipe_recorder_lut[i].name, sizeof name - 1);
+		if( fwrite(name, sizeof name, 1, file) != 1 )
+			goto FAIL;
+	}
+
+	for( guint i = 0; i < records; ++i ) {
+		guint slot = (first + i) % datapipe_recorder_size;
+		if( fwrite(datapipe_recorder_ring + slot,
+			   sizeof *datapipe_recorder_ring, 1, file) != 1 )
+			goto FAIL;
+	}
+
+	if( fclose(file) == EOF ) {
+		file = NULL;
+		goto FAIL;
+	}
+	file = NULL;
+
+	if( rename(temp, path) == -1 ) {
+		mce_log(LL_ERR, "%s: can't rename to %s: %m", temp, path);
+		goto EXIT;
+	}
+
+	mce_log(LL_NOTICE, "wrote %u datapipe executions to %s",
+		records, path);
+	ack = true;
+	goto EXIT;
+
+FAIL:
+	mce_log(LL_ERR, "%s: write failed: %m", temp);
+
+EXIT:
+	if( file )
+		fclose(file);
+
+	if( !ack && temp )
+		unlink(temp);
+
+	g_free(temp);
+
+	return ack;
+}
+
+/** Enable execution recorder
+ */
+static void datapipe_recorder_init(void)
+{
+	gint size = mce_conf_get_int(MCE_CONF_DATAPIPE_GROUP,
+				     MCE_CONF_DATAPIPE_RECORDER_SIZE,
+				     DEFAULT_DATAPIPE_RECORDER_SIZE);
+
+	for( guint i = 0; i < DATAPIPE_RECORDER_PIPES; ++i )
+		datapipe_recorder_lut[i].pipe->recorder_id = i + 1;
+
+	if( size <= 0 ) {
+		mce_log(LL_INFO, "datapipe recorder disabled");
+		goto EXIT;
+	}
+
+	datapipe_recorder_ring  = g_malloc0_n(size, sizeof *datapipe_recorder_ring);
+	datapipe_recorder_size  = size;
+	datapipe_recorder_count = 0;
+	datapipe_recorder_base  = mce_lib_get_boot_tick();
+
+EXIT:
+	return;
+}
+
+/** Disable execution recorder
+ */
+static void datapipe_recorder_quit(void)
+{
+	g_free(datapipe_recorder_ring),
+		datapipe_recorder_ring = NULL;
+	datapipe_recorder_size = 0;
+}
+
+/* ========================================================================= *
+ * EXECUTION REPLAY
+ * ========================================================================= */
+
+/** State data for replaying a recording */
+typedef struct {
+	/** Recording file content */
+	gchar                   *data;
+	/** Records within data */
+	const datapipe_record_t *records;
+	/** Number of records */
+	guint                    count;
+	/** Index of the next record to replay */
+	guint                    next;
+	/** Recording pipe id -> local datapipe_recorder_lut index + 1 */
+	guint                   *map;
+	/** Number of replayed executions */
+	guint                    executed;
+	/** Process cpu time at replay start [ns] */
+	int64_t                  cpu_start;
+	/** Monotonic time at replay start [ns] */
+	int64_t                  wall_start;
+	/** Idle callback id */
+	guint                    idle_id;
+} datapipe_replay_t;
+
+/** Currently active replay, or NULL */
+static datapipe_replay_t *datapipe_replay = NULL;
+
+/** Helper for getting clock value in nanoseconds
+ *
+ * @param id clock to use
+ *
+ * @return clock value [ns]
+ */
+static int64_t datapipe_replay_clock(clockid_t id)
+{
+	struct timespec ts = { 0, 0 };
+	clock_gettime(id, &ts);
+	return ts.tv_sec * (int64_t)1000000000 + ts.tv_nsec;
+}
+
+/** Release replay state data
+ *
+ * @param self replay state, or NULL
+ */
+static void datapipe_replay_delete(datapipe_replay_t *self)
+{
+	if( !self )
+		goto EXIT;
+
+	if( self->idle_id )
+		g_source_remove(self->idle_id);
+
+	g_free(self->map);
+	g_free(self->data);
+	g_free(self);
+
+EXIT:
+	return;
+}
+
+/** Replay one recorded datapipe execution
+ *
+ * @param self replay state
+ * @param rec  record to replay
+ *
+ * @return true if datapipe was executed, false if record was skipped
+ */
+static bool datapipe_replay_record(datapipe_replay_t *self,
+				   const datapipe_record_t *rec)
+{
+	/* Nested executions are reproduced by replaying the top
+	 * level execution that caused them */
+	if( rec->flags & DATAPIPE_RECORD_NESTED )
+		return false;
+
+	guint id = rec->pipe ? self->map[rec->pipe - 1] : 0;
+	if( !id )
+		return false;
+
+	const datapipe_recorder_entry_t *entry = datapipe_recorder_lut + id - 1;
+
+	data_source_t    use_cache = USE_INDATA;
+	caching_policy_t cache     = rec->cache;
+
+	if( rec->flags & DATAPIPE_RECORD_USE_CACHE )
+		use_cache = USE_CACHE;
+
+	switch( entry->kind ) {
+	case DATAPIPE_KIND_VALUE:
+		execute_datapipe(entry->pipe,
+				 GSIZE_TO_POINTER((gsize)rec->value),
+				 use_cache, cache);
+		break;
+
+	case DATAPIPE_KIND_EVENT:
+		{
+			struct input_event ev;
+			memset(&ev, 0, sizeof ev);
+			gettimeofday(&ev.time, 0);
+			ev.type  = (uint16_t)((uint64_t)rec->value >> 48);
+			ev.code  = (uint16_t)((uint64_t)rec->value >> 32);
+			ev.value = (int32_t)(uint32_t)rec->value;
+
+			struct input_event *evp = &ev;
+			execute_datapipe(entry->pipe, &evp,
+					 USE_INDATA, DONT_CACHE_INDATA);
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+/** Idle callback for replaying recorded executions one at a time
+ *
+ * @param aptr replay state (as void pointer)
+ *
+ * @return TRUE while there are records left, FALSE when finished
+ */
+static gboolean datapipe_replay_cb(gpointer aptr)
+{
+	datapipe_replay_t *self = aptr;
+
+	if( !self->idle_id )
+		return FALSE;
+
+	while( self->next < self->count ) {
+		const datapipe_record_t *rec = self->records + self->next++;
+		if( datapipe_replay_record(self, rec) ) {
+			self->executed += 1;
+			return TRUE;
+		}
+	}
+
+	self->idle_id = 0;
+
+	int64_t cpu  = datapipe_replay_clock(CLOCK_PROCESS_CPUTIME_ID) -
+		self->cpu_start;
+	int64_t wall = datapipe_replay_clock(CLOCK_MONOTONIC) -
+		self->wall_start;
+
+	mce_log(LL_NOTICE, "replayed %u/%u executions; cpu %.3f ms, "
+		"wall %.3f ms, %.1f us/execution",
+		self->executed, self->count, cpu * 1e-6, wall * 1e-6,
+		self->executed ? cpu * 1e-3 / self->executed : 0.0);
+
+	datapipe_replay = NULL;
+	datapipe_replay_delete(self);
+
+	mce_quit_mainloop();
+
+	return FALSE;
+}
+
+/** Start replaying a datapipe recording
+ *
+ * The recorded top level executions are fed to the datapipes
+ * from idle callback, one execution per main loop iteration, so
+ * that callbacks scheduled by policy modules get a chance to run
+ * in between. Timers are not simulated. The main loop is exited
+ * when all records have been replayed.
+ *
+ * @param path Recording file to replay
+ *
+ * @return true if replay was started, false otherwise
+ */
+bool datapipe_replay_start(const char *path)
+{
+	bool               ack  = false;
+	datapipe_replay_t *self = NULL;
+	gsize              size = 0;
+	GError            *err  = NULL;
+
+	if( datapipe_replay ) {
+		mce_log(LL_ERR, "replay already in progress");
+		goto EXIT;
+	}
+
+	self = g_malloc0(sizeof *self);
+
+	if( !g_file_get_contents(path, &self->data, &size, &err) ) {
+		mce_log(LL_ERR, "%s: %s", path, err->message);
+		goto EXIT;
+	}
+
+	const datapipe_recording_header_t *head = (void *)self->data;
+
+	if( size < sizeof *head ||
+	    memcmp(head->magic, DATAPIPE_RECORDING_MAGIC, sizeof head->magic) ||
+	    head->version != DATAPIPE_RECORDING_VERSION ||
+	    head->name_size != DATAPIPE_RECORDING_NAME_SIZE ) {
+		mce_log(LL_ERR, "%s: not a datapipe recording", path);
+		goto EXIT;
+	}
+
+	gsize need = (sizeof *head +
+		      (gsize)head->pipes * head->name_size +
+		      (gsize)head->records * sizeof *self->records);
+	if( size < need ) {
+		mce_log(LL_ERR, "%s: truncated datapipe recording", path);
+		goto EXIT;
+	}
+
+	/* Map recorded pipe ids to pipes by name */
+	const char *names = self->data + sizeof *head;
+	self->map = g_malloc0_n(head->pipes ?: 1, sizeof *self->map);
+	for( guint i = 0; i < head->pipes; ++i ) {
+		const char *name = names + i * head->name_size;
+		for( guint k = 0; k < DATAPIPE_RECORDER_PIPES; ++k ) {
+			if( strncmp(name, datapipe_recorder_lut[k].name,
+				    head->name_size) )
+				continue;
+			self->map[i] = k + 1;
+			break;
+		}
+		if( !self->map[i] )
+			mce_log(LL_WARN, "%.*s: unknown datapipe",
+				(int)head->name_size, name);
+	}
+
+	self->records = (void *)(names + head->pipes * head->name_size);
+	self->count   = head->records;
+
+	/* Reject records referring to nonexistent pipe names */
+	for( guint i = 0; i < self->count; ++i ) {
+		if( self->records[i].pipe > head->pipes ) {
+			mce_log(LL_ERR, "%s: invalid datapipe record", path);
+			goto EXIT;
+		}
+	}
+
+	mce_log(LL_WARN, "replaying %u datapipe executions from %s",
+		self->count, path);
+
+	self->cpu_start  = datapipe_replay_clock(CLOCK_PROCESS_CPUTIME_ID);
+	self->wall_start = datapipe_replay_clock(CLOCK_MONOTONIC);
+	self->idle_id    = g_idle_add_full(G_PRIORITY_LOW, datapipe_replay_cb,
+					   self, NULL);
+
+	datapipe_replay = self, self = NULL;
+	ack = true;
+
+EXIT:
+	if( err )
+		g_error_free(err);
+
+	datapipe_replay_delete(self);
+
+	return ack;
+}
+
+/** Cancel replay that is in progress
+ */
+static void datapipe_replay_quit(void)
+{
+	datapipe_replay_delete(datapipe_replay),
+		datapipe_replay = NULL;
+}
+
+/* ========================================================================= *
+ * STARTUP / EXIT
+ * ========================================================================= */
+
 /** Setup all datapipes
  */
 void mce_datapipe_init(void)
 {
 	setup_datapipe(&system_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_STATE_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_STATE_UNDEF));
 	setup_datapipe(&master_radio_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&call_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(CALL_STATE_NONE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(CALL_STATE_NONE));
 	setup_datapipe(&ignore_incoming_call_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(false));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(false));
 	setup_datapipe(&call_type_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(NORMAL_CALL));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(NORMAL_CALL));
 	setup_datapipe(&alarm_ui_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_ALARM_UI_INVALID_INT32));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_ALARM_UI_INVALID_INT32));
 	setup_datapipe(&submode_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_NORMAL_SUBMODE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_NORMAL_SUBMODE));
 	setup_datapipe(&display_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_DISPLAY_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_DISPLAY_UNDEF));
 	setup_datapipe(&display_state_req_pipe, READ_WRITE, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_DISPLAY_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_DISPLAY_UNDEF));
 	setup_datapipe(&display_state_next_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_DISPLAY_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_DISPLAY_UNDEF));
 	setup_datapipe(&exception_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(UIEXC_NONE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(UIEXC_NONE));
 	setup_datapipe(&display_brightness_pipe, READ_WRITE, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(3));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(3));
 	setup_datapipe(&led_brightness_pipe, READ_WRITE, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&lpm_brightness_pipe, READ_WRITE, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&led_pattern_activate_pipe, READ_ONLY, FREE_CACHE,
-		       0, NULL);
+		       NOTIFY_ALWAYS, 0, NULL);
 	setup_datapipe(&device_resumed_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, NULL);
+		       NOTIFY_ALWAYS, 0, NULL);
 	setup_datapipe(&led_pattern_deactivate_pipe, READ_ONLY, FREE_CACHE,
-		       0, NULL);
+		       NOTIFY_ALWAYS, 0, NULL);
 	setup_datapipe(&user_activity_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, NULL);
+		       NOTIFY_ALWAYS, 0, NULL);
 	setup_datapipe(&key_backlight_pipe, READ_WRITE, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&keypress_pipe, READ_ONLY, FREE_CACHE,
-		       sizeof (struct input_event), NULL);
+		       NOTIFY_ALWAYS, sizeof (struct input_event), NULL);
 	setup_datapipe(&touchscreen_pipe, READ_ONLY, FREE_CACHE,
-		       sizeof (struct input_event), NULL);
+		       NOTIFY_ALWAYS, sizeof (struct input_event), NULL);
 	setup_datapipe(&device_inactive_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(TRUE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(TRUE));
 	setup_datapipe(&device_inactive_event_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(TRUE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(TRUE));
 	setup_datapipe(&lockkey_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&keyboard_slide_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(COVER_CLOSED));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(COVER_CLOSED));
 	setup_datapipe(&keyboard_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(COVER_CLOSED));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(COVER_CLOSED));
 	setup_datapipe(&lid_sensor_is_working_pipe, READ_ONLY,
-		       DONT_FREE_CACHE, 0, GINT_TO_POINTER(FALSE));
+		       DONT_FREE_CACHE, NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&lid_cover_sensor_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(COVER_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(COVER_UNDEF));
 	setup_datapipe(&lid_cover_policy_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(COVER_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(COVER_UNDEF));
 	setup_datapipe(&lens_cover_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&proximity_sensor_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(COVER_OPEN));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(COVER_OPEN));
 	setup_datapipe(&ambient_light_sensor_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(400));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(400));
 	setup_datapipe(&ambient_light_level_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(400));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(400));
 	setup_datapipe(&ambient_light_poll_pipe, READ_WRITE, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(false));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(false));
 	setup_datapipe(&orientation_sensor_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(MCE_ORIENTATION_UNDEFINED));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(MCE_ORIENTATION_UNDEFINED));
 	setup_datapipe(&tk_lock_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(LOCK_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(LOCK_UNDEF));
 	setup_datapipe(&interaction_expected_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(false));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(false));
 	setup_datapipe(&charger_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(CHARGER_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(CHARGER_STATE_UNDEF));
 	setup_datapipe(&battery_status_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(BATTERY_STATUS_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(BATTERY_STATUS_UNDEF));
 	setup_datapipe(&battery_level_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(BATTERY_LEVEL_INITIAL));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(BATTERY_LEVEL_INITIAL));
 	setup_datapipe(&camera_button_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(CAMERA_BUTTON_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(CAMERA_BUTTON_UNDEF));
 	setup_datapipe(&inactivity_timeout_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(DEFAULT_INACTIVITY_TIMEOUT));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(DEFAULT_INACTIVITY_TIMEOUT));
 	setup_datapipe(&audio_route_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(AUDIO_ROUTE_UNDEF));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(AUDIO_ROUTE_UNDEF));
 	setup_datapipe(&usb_cable_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(USB_CABLE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(USB_CABLE_UNDEF));
 	setup_datapipe(&jack_sense_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(COVER_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(COVER_UNDEF));
 	setup_datapipe(&power_saving_mode_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&thermal_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(THERMAL_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(THERMAL_STATE_UNDEF));
 	setup_datapipe(&heartbeat_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(0));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(0));
 	setup_datapipe(&compositor_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 	setup_datapipe(&lipstick_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 	setup_datapipe(&devicelock_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 	setup_datapipe(&usbmoded_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 	setup_datapipe(&ngfd_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 
 	setup_datapipe(&dsme_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 
 	setup_datapipe(&bluez_available_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(SERVICE_STATE_UNDEF));
 
 	setup_datapipe(&packagekit_locked_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&update_mode_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&shutting_down_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&device_lock_state_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(DEVICE_LOCK_UNDEFINED));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(DEVICE_LOCK_UNDEFINED));
 	setup_datapipe(&touch_detected_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&touch_grab_wanted_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&touch_grab_active_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&keypad_grab_wanted_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&keypad_grab_active_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&music_playback_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ON_CHANGE, 0, GINT_TO_POINTER(FALSE));
 	setup_datapipe(&proximity_blank_pipe, READ_ONLY, DONT_FREE_CACHE,
-		       0, GINT_TO_POINTER(FALSE));
+		       NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
     setup_datapipe(&wristgesture_sensor_pipe, READ_ONLY, DONT_FREE_CACHE,
-               0, GINT_TO_POINTER(FALSE));
+               NOTIFY_ALWAYS, 0, GINT_TO_POINTER(FALSE));
+	setup_datapipe(&memnotify_level_pipe, READ_ONLY, DONT_FREE_CACHE,
+		       NOTIFY_ON_CHANGE, 0,
+		       GINT_TO_POINTER(MEMNOTIFY_LEVEL_UNKNOWN));
+
+	datapipe_recorder_init();
 
 }
 
@@ -876,6 +1552,9 @@ void mce_datapipe_init(void)
  */
 void mce_datapipe_quit(void)
 {
+	datapipe_replay_quit();
+	datapipe_recorder_quit();
+
 	free_datapipe(&thermal_state_pipe);
 	free_datapipe(&power_saving_mode_pipe);
 	free_datapipe(&jack_sense_pipe);
@@ -943,6 +1622,7 @@ void mce_datapipe_quit(void)
 	free_datapipe(&music_playback_pipe);
 	free_datapipe(&proximity_blank_pipe);
     free_datapipe(&wristgesture_sensor_pipe);
+	free_datapipe(&memnotify_level_pipe);
 }
 
 /** Convert submode_t bitmap changes to human readable string
@@ -1500,6 +2180,35 @@ const char *orientation_state_repr(orientation_state_t state)
 	return name;
 }
 
+/** Translate memory pressure level to human readable form
+ *
+ * Note: Also used as argument for the memory level D-Bus signal
+ *       and thus changes here can cause API breaks.
+ */
+const char *memnotify_level_repr(memnotify_level_t lev)
+{
+	const char *repr = "undefined";
+
+	switch( lev ) {
+	case MEMNOTIFY_LEVEL_NORMAL:
+		repr = MCE_MEMORY_LEVEL_NORMAL;
+		break;
+	case MEMNOTIFY_LEVEL_WARNING:
+		repr = MCE_MEMORY_LEVEL_WARNING;
+		break;
+	case MEMNOTIFY_LEVEL_CRITICAL:
+		repr = MCE_MEMORY_LEVEL_CRITICAL;
+		break;
+	case MEMNOTIFY_LEVEL_UNKNOWN:
+		repr = MCE_MEMORY_LEVEL_UNKNOWN;
+		break;
+	default:
+		break;
+	}
+
+	return repr;
+}
+
 void datapipe_handlers_install(datapipe_handler_t *bindings)
 {
     if( !bindings )
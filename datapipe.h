@@ -52,6 +52,11 @@ typedef struct {
 	gsize datasize;			/**< Size of data; NULL == automagic */
 	gboolean free_cache;		/**< Free the cache? */
 	gboolean read_only;		/**< Datapipe is read only */
+	gboolean change_only;		/**< Skip unchanged output triggers */
+	gboolean have_outdata;		/**< Has been executed at least once */
+	gconstpointer last_outdata;	/**< Latest data passed to outputs */
+	guint suppressed;		/**< Number of skipped notifications */
+	guint recorder_id;		/**< Recorder pipe id; 0 = none */
 } datapipe_struct;
 
 /**
@@ -70,6 +75,14 @@ typedef enum {
 	FREE_CACHE = TRUE		/**< Free the cache */
 } cache_free_policy_t;
 
+/**
+ * Policy for executions that do not change the data
+ */
+typedef enum {
+	NOTIFY_ALWAYS = FALSE,		/**< Always execute triggers */
+	NOTIFY_ON_CHANGE = TRUE		/**< Skip unchanged output triggers */
+} change_policy_t;
+
 /**
  * Policy for the data source
  */
@@ -155,6 +168,7 @@ extern datapipe_struct keypad_grab_active_pipe;
 extern datapipe_struct music_playback_pipe;
 extern datapipe_struct proximity_blank_pipe;
 extern datapipe_struct wristgesture_sensor_pipe;
+extern datapipe_struct memnotify_level_pipe;
 
 /* Data retrieval */
 
@@ -209,6 +223,7 @@ void remove_output_trigger_from_datapipe(datapipe_struct *const datapipe,
 void setup_datapipe(datapipe_struct *const datapipe,
 		    const read_only_policy_t read_only,
 		    const cache_free_policy_t free_cache,
+		    const change_policy_t change_only,
 		    const gsize datasize, gpointer initial_data);
 void free_datapipe(datapipe_struct *const datapipe);
 
@@ -237,6 +252,31 @@ typedef struct
 void datapipe_bindings_init(datapipe_bindings_t *self);
 void datapipe_bindings_quit(datapipe_bindings_t *self);
 
+/* Execution recorder */
+
+/** Name of the datapipe configuration group */
+#define MCE_CONF_DATAPIPE_GROUP "Datapipe"
+
+/** Number of executions to keep in the recorder ring; 0 = disabled */
+#define MCE_CONF_DATAPIPE_RECORDER_SIZE "RecorderSize"
+
+/** Default recorder ring size */
+#define DEFAULT_DATAPIPE_RECORDER_SIZE 0
+
+/** Where datapipe recordings are written to */
+#define DATAPIPE_RECORDING_FILE G_STRINGIFY(MCE_RUN_DIR) "/datapipe.rec"
+
+/** Name of D-Bus method for dumping datapipe recording to file
+ *
+ * Defined here until it becomes available in mce-dev
+ */
+#ifndef MCE_DATAPIPE_RECORDING_DUMP
+# define MCE_DATAPIPE_RECORDING_DUMP "datapipe_recording_dump"
+#endif
+
+bool datapipe_recorder_dump(const char *path);
+bool datapipe_replay_start(const char *path);
+
 /* Startup / exit */
 void mce_datapipe_init(void);
 void mce_datapipe_quit(void);
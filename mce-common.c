@@ -23,8 +23,12 @@
 #include "mce.h"
 #include "mce-dbus.h"
 #include "mce-log.h"
+#include "mce-setting.h"
 
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <malloc.h>
 
 #include <mce/dbus-names.h>
 #include <mce/mode-names.h>
@@ -50,9 +54,17 @@ static void     common_datapipe_usb_cable_state_cb(gconstpointer data);
 static void     common_datapipe_charger_state_cb  (gconstpointer data);
 static void     common_datapipe_battery_status_cb (gconstpointer data);
 static void     common_datapipe_battery_level_cb  (gconstpointer data);
+static void     common_datapipe_memnotify_level_cb(gconstpointer data);
 static void     common_datapipe_init              (void);
 static void     common_datapipe_quit              (void);
 
+// SELF_TRIM
+static long     common_trim_get_rss_kb            (void);
+static void     common_trim_execute               (void);
+static gboolean common_trim_cb                    (gpointer aptr);
+static void     common_trim_schedule              (void);
+static void     common_trim_cancel                (void);
+
 // MODULE_INIT_QUIT
 bool mce_common_init(void);
 void mce_common_quit(void);
@@ -73,6 +85,9 @@ static battery_status_t battery_status = BATTERY_STATUS_UNDEF;
 /** Battery charge level: assume 100% */
 static gint battery_level = BATTERY_LEVEL_INITIAL;
 
+/** Memory pressure level; assume unknown */
+static memnotify_level_t memnotify_level = MEMNOTIFY_LEVEL_UNKNOWN;
+
 /* ========================================================================= *
  * DBUS_FUNCTIONS
  * ========================================================================= */
@@ -578,6 +593,38 @@ EXIT:
     return;
 }
 
+/** Callback for handling memnotify_level_pipe state changes
+ *
+ * @param data memnotify_level (as void pointer)
+ */
+static void common_datapipe_memnotify_level_cb(gconstpointer data)
+{
+    memnotify_level_t prev = memnotify_level;
+    memnotify_level = GPOINTER_TO_INT(data);
+
+    if( memnotify_level == prev )
+        goto EXIT;
+
+    mce_log(LL_DEBUG, "memnotify_level = %s -> %s",
+            memnotify_level_repr(prev),
+            memnotify_level_repr(memnotify_level));
+
+    /* Trim when entering warning / critical level. Unknown level
+     * sorts after critical, so it must be excluded explicitly. */
+    switch( memnotify_level ) {
+    case MEMNOTIFY_LEVEL_WARNING:
+    case MEMNOTIFY_LEVEL_CRITICAL:
+        if( prev == MEMNOTIFY_LEVEL_UNKNOWN || prev < memnotify_level )
+            common_trim_schedule();
+        break;
+    default:
+        break;
+    }
+
+EXIT:
+    return;
+}
+
 /* ------------------------------------------------------------------------- *
  * init/quit
  * ------------------------------------------------------------------------- */
@@ -602,6 +649,10 @@ static datapipe_handler_t common_datapipe_handlers[] =
         .datapipe  = &battery_level_pipe,
         .output_cb = common_datapipe_battery_level_cb,
     },
+    {
+        .datapipe  = &memnotify_level_pipe,
+        .output_cb = common_datapipe_memnotify_level_cb,
+    },
     // sentinel
     {
         .datapipe = 0,
@@ -628,6 +679,101 @@ static void common_datapipe_quit(void)
     datapipe_bindings_quit(&common_datapipe_bindings);
 }
 
+/* ========================================================================= *
+ * SELF_TRIM
+ * ========================================================================= */
+
+/** Idle callback id for delayed self trimming */
+static guint common_trim_id = 0;
+
+/** Get resident set size of mce process
+ *
+ * @return rss [kB], or -1 if not available
+ */
+static long common_trim_get_rss_kb(void)
+{
+    long  res  = -1;
+    long  size = 0;
+    long  rss  = 0;
+    FILE *file = fopen("/proc/self/statm", "r");
+
+    if( !file )
+        goto EXIT;
+
+    if( fscanf(file, "%ld %ld", &size, &rss) != 2 )
+        goto EXIT;
+
+    res = rss * (sysconf(_SC_PAGESIZE) / 1024);
+
+EXIT:
+    if( file )
+        fclose(file);
+
+    return res;
+}
+
+/** Release memory that mce can do without
+ *
+ * Drops caches that are rebuilt on demand, compacts lists and
+ * returns free heap memory back to the system.
+ */
+static void common_trim_execute(void)
+{
+    long rss_before = common_trim_get_rss_kb();
+
+    mce_log_trim();
+    mce_dbus_trim();
+    mce_setting_trim();
+
+    malloc_trim(0);
+
+    long rss_after = common_trim_get_rss_kb();
+
+    mce_log(LL_NOTICE, "self trim at %s memory level: rss %ld -> %ld kB",
+            memnotify_level_repr(memnotify_level), rss_before, rss_after);
+}
+
+/** Idle callback for delayed self trimming
+ *
+ * @param aptr (unused) user data pointer
+ *
+ * @return FALSE to stop the idle callback from repeating
+ */
+static gboolean common_trim_cb(gpointer aptr)
+{
+    (void)aptr;
+
+    if( !common_trim_id )
+        goto EXIT;
+
+    common_trim_id = 0;
+    common_trim_execute();
+
+EXIT:
+    return FALSE;
+}
+
+/** Schedule self trimming
+ *
+ * Trimming is done from idle callback so that all memory level
+ * datapipe listeners get a chance to release resources first.
+ */
+static void common_trim_schedule(void)
+{
+    if( !common_trim_id )
+        common_trim_id = g_idle_add(common_trim_cb, 0);
+}
+
+/** Cancel pending self trimming
+ */
+static void common_trim_cancel(void)
+{
+    if( common_trim_id ) {
+        g_source_remove(common_trim_id),
+            common_trim_id = 0;
+    }
+}
+
 /* ========================================================================= *
  * MODULE_INIT_QUIT
  * ========================================================================= */
@@ -654,4 +800,7 @@ mce_common_quit(void)
     /* remove all handlers */
     common_dbus_quit();
     common_datapipe_quit();
+
+    /* cancel pending actions */
+    common_trim_cancel();
 }
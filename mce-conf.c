@@ -27,18 +27,750 @@
 
 #include <string.h>
 #include <glob.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /** Pointer to the keyfile structure where config values are read from */
 static gpointer keyfile = NULL;
 
+/* ========================================================================= *
+ * Binary configuration cache
+ *
+ * Merging the ini-files yields the same result on every boot unless
+ * the files themselves change. The merged result is stored in a cache
+ * file that can be mapped to memory and used for lookups without
+ * having to parse and merge the ini-files.
+ *
+ * The cache is used only if the mce version and the set of ini-files,
+ * including their sizes and modification times, match the ones that
+ * were used when the cache was written.
+ * ========================================================================= */
+
+/** Location of the merged configuration cache file */
+#define MCE_CONF_CACHE_PATH  G_STRINGIFY(MCE_VAR_DIR) "/mce-conf.cache"
+
+/** Magic bytes at the start of configuration cache file */
+#define MCE_CONF_CACHE_MAGIC "MCECONF1"
+
+/** Configuration cache file header
+ *
+ * Table offsets are relative to the start of the file, string
+ * offsets are relative to the start of the string pool.
+ */
+typedef struct
+{
+	char     mch_magic[8];
+	uint32_t mch_file_size;
+	uint32_t mch_version;
+	uint32_t mch_source_count;
+	uint32_t mch_source_offs;
+	uint32_t mch_group_count;
+	uint32_t mch_group_offs;
+	uint32_t mch_entry_count;
+	uint32_t mch_entry_offs;
+	uint32_t mch_group_bucket_count;
+	uint32_t mch_group_bucket_offs;
+	uint32_t mch_entry_bucket_count;
+	uint32_t mch_entry_bucket_offs;
+	uint32_t mch_string_size;
+	uint32_t mch_string_offs;
+} mce_conf_cache_header_t;
+
+/** Configuration cache: ini-file the cache was generated from */
+typedef struct
+{
+	int64_t  mcs_mtime_sec;
+	int64_t  mcs_mtime_nsec;
+	int64_t  mcs_size;
+	uint32_t mcs_path;
+	uint32_t mcs_reserved;
+} mce_conf_cache_source_t;
+
+/** Configuration cache: group with contiguous range of entries */
+typedef struct
+{
+	uint32_t mcg_name;
+	uint32_t mcg_first;
+	uint32_t mcg_count;
+} mce_conf_cache_group_t;
+
+/** Configuration cache: key and unparsed value */
+typedef struct
+{
+	uint32_t mcv_group;
+	uint32_t mcv_key;
+	uint32_t mcv_value;
+} mce_conf_cache_entry_t;
+
+/** Mapped configuration cache file, or NULL */
+static const char *conf_cache_base = 0;
+
+/** Size of mapped configuration cache file */
+static size_t      conf_cache_size = 0;
+
+/** Single value keyfile for parsing cached values */
+static GKeyFile   *conf_cache_scratch = 0;
+
+/** Group of the value currently staged in conf_cache_scratch, or NULL */
+static gchar      *conf_cache_scratch_group = 0;
+
+/** Calculate lookup hash for group / key pair
+ *
+ * @param group The configuration group
+ * @param key   The configuration key, or NULL for group lookup
+ *
+ * @return hash value
+ */
+static uint32_t mce_conf_cache_hash(const char *group, const char *key)
+{
+	/* FNV-1a; must remain stable as it is stored in the cache */
+	uint32_t h = 2166136261u;
+
+	for( const char *s = group; *s; ++s )
+		h = (h ^ (uint8_t)*s) * 16777619u;
+
+	if( key ) {
+		h = (h ^ 0xff) * 16777619u;
+		for( const char *s = key; *s; ++s )
+			h = (h ^ (uint8_t)*s) * 16777619u;
+	}
+
+	return h;
+}
+
+/** Get configuration cache header
+ *
+ * @return header pointer, or NULL if cache is not in use
+ */
+static const mce_conf_cache_header_t *mce_conf_cache_header(void)
+{
+	return (const mce_conf_cache_header_t *)conf_cache_base;
+}
+
+/** Get configuration cache table
+ *
+ * @param offs table offset from start of file
+ *
+ * @return table pointer
+ */
+static const void *mce_conf_cache_table(uint32_t offs)
+{
+	return conf_cache_base + offs;
+}
+
+/** Get string from configuration cache string pool
+ *
+ * @param offs string offset from start of string pool
+ *
+ * @return string pointer
+ */
+static const char *mce_conf_cache_string(uint32_t offs)
+{
+	return conf_cache_base + mce_conf_cache_header()->mch_string_offs + offs;
+}
+
+/** Lookup group from configuration cache
+ *
+ * @param group The configuration group
+ *
+ * @return group pointer, or NULL if not found
+ */
+static const mce_conf_cache_group_t *mce_conf_cache_find_group(const char *group)
+{
+	const mce_conf_cache_header_t *hdr = mce_conf_cache_header();
+	const mce_conf_cache_group_t  *tab = mce_conf_cache_table(hdr->mch_group_offs);
+	const uint32_t *bucket = mce_conf_cache_table(hdr->mch_group_bucket_offs);
+	uint32_t        mask   = hdr->mch_group_bucket_count - 1;
+
+	for( uint32_t i = mce_conf_cache_hash(group, 0); ; ++i ) {
+		uint32_t slot = bucket[i & mask];
+
+		if( !slot )
+			break;
+
+		if( !strcmp(mce_conf_cache_string(tab[slot - 1].mcg_name), group) )
+			return tab + slot - 1;
+	}
+
+	return 0;
+}
+
+/** Lookup unparsed value from configuration cache
+ *
+ * @param group The configuration group
+ * @param key   The configuration key
+ *
+ * @return value string, or NULL if not found
+ */
+static const char *mce_conf_cache_find_value(const char *group,
+					     const char *key)
+{
+	const mce_conf_cache_header_t *hdr = mce_conf_cache_header();
+	const mce_conf_cache_group_t  *grp = mce_conf_cache_table(hdr->mch_group_offs);
+	const mce_conf_cache_entry_t  *tab = mce_conf_cache_table(hdr->mch_entry_offs);
+	const uint32_t *bucket = mce_conf_cache_table(hdr->mch_entry_bucket_offs);
+	uint32_t        mask   = hdr->mch_entry_bucket_count - 1;
+
+	for( uint32_t i = mce_conf_cache_hash(group, key); ; ++i ) {
+		uint32_t slot = bucket[i & mask];
+
+		if( !slot )
+			break;
+
+		const mce_conf_cache_entry_t *ent = tab + slot - 1;
+
+		if( strcmp(mce_conf_cache_string(ent->mcv_key), key) )
+			continue;
+
+		if( strcmp(mce_conf_cache_string(grp[ent->mcv_group].mcg_name),
+			   group) )
+			continue;
+
+		return mce_conf_cache_string(ent->mcv_value);
+	}
+
+	return 0;
+}
+
+/** Ini-file stat details for cache validation */
+typedef struct
+{
+	gchar   *path;
+	int64_t  mtime_sec;
+	int64_t  mtime_nsec;
+	int64_t  size;
+} mce_conf_source_t;
+
+/** Release array of ini-file stat details
+ *
+ * @param sources array of mce_conf_source_t, or NULL
+ */
+static void mce_conf_cache_free_sources(GArray *sources)
+{
+	if( !sources )
+		goto EXIT;
+
+	for( guint i = 0; i < sources->len; ++i )
+		g_free(g_array_index(sources, mce_conf_source_t, i).path);
+
+	g_array_free(sources, TRUE);
+
+EXIT:
+	return;
+}
+
+/** Collect stat details of ini-files that make up mce configuration
+ *
+ * @return array of mce_conf_source_t, or NULL on failure
+ */
+static GArray *mce_conf_cache_scan_sources(void)
+{
+	static const char pattern[] = MCE_CONF_DIR"/[0-9][0-9]*.ini";
+
+	GArray *sources = g_array_new(FALSE, FALSE, sizeof (mce_conf_source_t));
+	glob_t  gb;
+
+	memset(&gb, 0, sizeof gb);
+
+	/* Note: no matches is valid state that can be cached too */
+	if( glob(pattern, 0, 0, &gb) != 0 )
+		goto EXIT;
+
+	for( size_t i = 0; i < gb.gl_pathc; ++i ) {
+		struct stat st;
+
+		if( stat(gb.gl_pathv[i], &st) == -1 ) {
+			mce_conf_cache_free_sources(sources), sources = 0;
+			goto EXIT;
+		}
+
+		mce_conf_source_t src = {
+			.path       = g_strdup(gb.gl_pathv[i]),
+			.mtime_sec  = st.st_mtim.tv_sec,
+			.mtime_nsec = st.st_mtim.tv_nsec,
+			.size       = st.st_size,
+		};
+		g_array_append_val(sources, src);
+	}
+
+EXIT:
+	globfree(&gb);
+
+	return sources;
+}
+
+/** Check that table fits within the mapped cache file
+ *
+ * @param offs  table offset
+ * @param count number of table elements
+ * @param size  size of one table element
+ *
+ * @return true if table is within bounds, false otherwise
+ */
+static bool mce_conf_cache_table_ok(uint32_t offs, uint32_t count, size_t size)
+{
+	return offs <= conf_cache_size &&
+		count <= (conf_cache_size - offs) / size;
+}
+
+/** Validate mapped configuration cache file
+ *
+ * @param sources array of mce_conf_source_t for current ini-files
+ *
+ * @return true if cache can be used, false otherwise
+ */
+static bool mce_conf_cache_validate(const GArray *sources)
+{
+	const mce_conf_cache_header_t *hdr = mce_conf_cache_header();
+
+	if( conf_cache_size < sizeof *hdr )
+		return false;
+
+	if( memcmp(hdr->mch_magic, MCE_CONF_CACHE_MAGIC, sizeof hdr->mch_magic) )
+		return false;
+
+	if( hdr->mch_file_size != conf_cache_size )
+		return false;
+
+	/* Tables must be properly aligned */
+	if( (hdr->mch_source_offs & 7) ||
+	    (hdr->mch_group_offs  & 3) ||
+	    (hdr->mch_entry_offs  & 3) ||
+	    (hdr->mch_group_bucket_offs & 3) ||
+	    (hdr->mch_entry_bucket_offs & 3) )
+		return false;
+
+	/* String pool must be in bounds and nul terminated */
+	if( !mce_conf_cache_table_ok(hdr->mch_string_offs,
+				     hdr->mch_string_size, 1) ||
+	    hdr->mch_string_size < 1 ||
+	    mce_conf_cache_string(hdr->mch_string_size - 1)[0] )
+		return false;
+
+	if( !mce_conf_cache_table_ok(hdr->mch_source_offs,
+				     hdr->mch_source_count,
+				     sizeof (mce_conf_cache_source_t)) ||
+	    !mce_conf_cache_table_ok(hdr->mch_group_offs,
+				     hdr->mch_group_count,
+				     sizeof (mce_conf_cache_group_t)) ||
+	    !mce_conf_cache_table_ok(hdr->mch_entry_offs,
+				     hdr->mch_entry_count,
+				     sizeof (mce_conf_cache_entry_t)) ||
+	    !mce_conf_cache_table_ok(hdr->mch_group_bucket_offs,
+				     hdr->mch_group_bucket_count,
+				     sizeof (uint32_t)) ||
+	    !mce_conf_cache_table_ok(hdr->mch_entry_bucket_offs,
+				     hdr->mch_entry_bucket_count,
+				     sizeof (uint32_t)) )
+		return false;
+
+	/* Hash tables must be power of two sized and have free slots */
+	if( hdr->mch_group_bucket_count <= hdr->mch_group_count ||
+	    (hdr->mch_group_bucket_count & (hdr->mch_group_bucket_count - 1)) ||
+	    hdr->mch_entry_bucket_count <= hdr->mch_entry_count ||
+	    (hdr->mch_entry_bucket_count & (hdr->mch_entry_bucket_count - 1)) )
+		return false;
+
+	if( hdr->mch_version >= hdr->mch_string_size ||
+	    strcmp(mce_conf_cache_string(hdr->mch_version),
+		   G_STRINGIFY(PRG_VERSION)) )
+		return false;
+
+	/* Ini-files must be the same as when the cache was written */
+	const mce_conf_cache_source_t *src =
+		mce_conf_cache_table(hdr->mch_source_offs);
+
+	if( hdr->mch_source_count != sources->len )
+		return false;
+
+	for( guint i = 0; i < sources->len; ++i ) {
+		const mce_conf_source_t *cur =
+			&g_array_index(sources, mce_conf_source_t, i);
+
+		if( src[i].mcs_path >= hdr->mch_string_size ||
+		    strcmp(mce_conf_cache_string(src[i].mcs_path), cur->path) ||
+		    src[i].mcs_mtime_sec  != cur->mtime_sec  ||
+		    src[i].mcs_mtime_nsec != cur->mtime_nsec ||
+		    src[i].mcs_size       != cur->size )
+			return false;
+	}
+
+	/* All references must be within bounds */
+	const mce_conf_cache_group_t *grp =
+		mce_conf_cache_table(hdr->mch_group_offs);
+	const mce_conf_cache_entry_t *ent =
+		mce_conf_cache_table(hdr->mch_entry_offs);
+	const uint32_t *gbk = mce_conf_cache_table(hdr->mch_group_bucket_offs);
+	const uint32_t *ebk = mce_conf_cache_table(hdr->mch_entry_bucket_offs);
+
+	for( uint32_t i = 0; i < hdr->mch_group_count; ++i ) {
+		if( grp[i].mcg_name >= hdr->mch_string_size ||
+		    grp[i].mcg_first > hdr->mch_entry_count ||
+		    grp[i].mcg_count > hdr->mch_entry_count - grp[i].mcg_first )
+			return false;
+	}
+
+	for( uint32_t i = 0; i < hdr->mch_entry_count; ++i ) {
+		if( ent[i].mcv_group >= hdr->mch_group_count ||
+		    ent[i].mcv_key   >= hdr->mch_string_size ||
+		    ent[i].mcv_value >= hdr->mch_string_size )
+			return false;
+	}
+
+	/* Lookups probe until an empty bucket is found -> there must
+	 * not be more used buckets than there are items */
+	uint32_t used = 0;
+
+	for( uint32_t i = 0; i < hdr->mch_group_bucket_count; ++i ) {
+		if( gbk[i] > hdr->mch_group_count )
+			return false;
+		if( gbk[i] )
+			++used;
+	}
+
+	if( used > hdr->mch_group_count )
+		return false;
+
+	used = 0;
+
+	for( uint32_t i = 0; i < hdr->mch_entry_bucket_count; ++i ) {
+		if( ebk[i] > hdr->mch_entry_count )
+			return false;
+		if( ebk[i] )
+			++used;
+	}
+
+	if( used > hdr->mch_entry_count )
+		return false;
+
+	return true;
+}
+
+/** Unmap configuration cache file
+ */
+static void mce_conf_cache_unload(void)
+{
+	if( conf_cache_scratch )
+		g_key_file_free(conf_cache_scratch), conf_cache_scratch = 0;
+
+	g_free(conf_cache_scratch_group), conf_cache_scratch_group = 0;
+
+	if( conf_cache_base ) {
+		munmap((void *)conf_cache_base, conf_cache_size);
+		conf_cache_base = 0;
+		conf_cache_size = 0;
+	}
+}
+
+/** Map configuration cache file, if it is up to date
+ *
+ * @param sources array of mce_conf_source_t for current ini-files
+ *
+ * @return true if cache is in use, false otherwise
+ */
+static bool mce_conf_cache_load(const GArray *sources)
+{
+	bool        res  = false;
+	int         fd   = -1;
+	void       *base = MAP_FAILED;
+	struct stat st;
+
+	mce_conf_cache_unload();
+
+	if( (fd = open(MCE_CONF_CACHE_PATH, O_RDONLY)) == -1 ) {
+		if( errno != ENOENT )
+			mce_log(LL_WARN, "%s: open: %m", MCE_CONF_CACHE_PATH);
+		goto EXIT;
+	}
+
+	if( fstat(fd, &st) == -1 || st.st_size <= 0 ||
+	    st.st_size > (off_t)UINT32_MAX )
+		goto EXIT;
+
+	base = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if( base == MAP_FAILED ) {
+		mce_log(LL_WARN, "%s: mmap: %m", MCE_CONF_CACHE_PATH);
+		goto EXIT;
+	}
+
+	conf_cache_base = base, base = MAP_FAILED;
+	conf_cache_size = st.st_size;
+
+	if( !mce_conf_cache_validate(sources) ) {
+		mce_log(LL_NOTICE, "%s: out of date", MCE_CONF_CACHE_PATH);
+		mce_conf_cache_unload();
+		goto EXIT;
+	}
+
+	conf_cache_scratch = g_key_file_new();
+
+	mce_log(LL_NOTICE, "using configuration cache %s",
+		MCE_CONF_CACHE_PATH);
+
+	res = true;
+
+EXIT:
+	if( base != MAP_FAILED )
+		munmap(base, st.st_size);
+
+	if( fd != -1 )
+		close(fd);
+
+	return res;
+}
+
+/** Append padding to align cache file image
+ *
+ * @param image cache file image
+ */
+static void mce_conf_cache_align(GByteArray *image)
+{
+	static const guint8 pad[8] = { 0 };
+
+	if( image->len & 7 )
+		g_byte_array_append(image, pad, 8 - (image->len & 7));
+}
+
+/** Append string to cache string pool
+ *
+ * @param pool string pool
+ * @param str  string to add
+ *
+ * @return offset of the string within the pool
+ */
+static uint32_t mce_conf_cache_pool_add(GString *pool, const char *str)
+{
+	uint32_t offs = pool->len;
+
+	g_string_append_len(pool, str, strlen(str) + 1);
+
+	return offs;
+}
+
+/** Get power of two hash table size suitable for given item count
+ *
+ * @param count number of items to store
+ *
+ * @return number of hash buckets
+ */
+static uint32_t mce_conf_cache_bucket_count(uint32_t count)
+{
+	uint32_t n = 8;
+
+	while( n < 2 * count )
+		n <<= 1;
+
+	return n;
+}
+
+/** Write merged configuration to cache file
+ *
+ * @param ini     merged configuration
+ * @param sources array of mce_conf_source_t the configuration came from
+ *
+ * @return true on success, false on failure
+ */
+static bool mce_conf_cache_save(GKeyFile *ini, const GArray *sources)
+{
+	bool        res    = false;
+	gchar     **groups = g_key_file_get_groups(ini, 0);
+	GString    *pool   = g_string_sized_new(4096);
+	GArray     *srctab = g_array_new(FALSE, TRUE, sizeof (mce_conf_cache_source_t));
+	GArray     *grptab = g_array_new(FALSE, TRUE, sizeof (mce_conf_cache_group_t));
+	GArray     *enttab = g_array_new(FALSE, TRUE, sizeof (mce_conf_cache_entry_t));
+	uint32_t   *gbk    = 0;
+	uint32_t   *ebk    = 0;
+	GByteArray *image  = g_byte_array_new();
+	GError     *err    = 0;
+
+	mce_conf_cache_header_t hdr;
+	memset(&hdr, 0, sizeof hdr);
+
+	/* Empty string at offset zero */
+	g_string_append_c(pool, 0);
+
+	hdr.mch_version = mce_conf_cache_pool_add(pool, G_STRINGIFY(PRG_VERSION));
+
+	for( guint i = 0; i < sources->len; ++i ) {
+		const mce_conf_source_t *cur =
+			&g_array_index(sources, mce_conf_source_t, i);
+		mce_conf_cache_source_t src = {
+			.mcs_mtime_sec  = cur->mtime_sec,
+			.mcs_mtime_nsec = cur->mtime_nsec,
+			.mcs_size       = cur->size,
+			.mcs_path       = mce_conf_cache_pool_add(pool, cur->path),
+		};
+		g_array_append_val(srctab, src);
+	}
+
+	for( size_t g = 0; groups && groups[g]; ++g ) {
+		gchar **keys = g_key_file_get_keys(ini, groups[g], 0, 0);
+
+		mce_conf_cache_group_t grp = {
+			.mcg_name  = mce_conf_cache_pool_add(pool, groups[g]),
+			.mcg_first = enttab->len,
+			.mcg_count = 0,
+		};
+
+		for( size_t k = 0; keys && keys[k]; ++k ) {
+			gchar *val = g_key_file_get_value(ini, groups[g],
+							  keys[k], 0);
+			if( !val )
+				continue;
+
+			mce_conf_cache_entry_t ent = {
+				.mcv_group = grptab->len,
+				.mcv_key   = mce_conf_cache_pool_add(pool, keys[k]),
+				.mcv_value = mce_conf_cache_pool_add(pool, val),
+			};
+			g_array_append_val(enttab, ent);
+			grp.mcg_count += 1;
+			g_free(val);
+		}
+
+		g_array_append_val(grptab, grp);
+		g_strfreev(keys);
+	}
+
+	/* Fill in hash tables using linear probing */
+	hdr.mch_group_bucket_count = mce_conf_cache_bucket_count(grptab->len);
+	hdr.mch_entry_bucket_count = mce_conf_cache_bucket_count(enttab->len);
+
+	gbk = g_malloc0(hdr.mch_group_bucket_count * sizeof *gbk);
+	ebk = g_malloc0(hdr.mch_entry_bucket_count * sizeof *ebk);
+
+	for( guint i = 0; i < grptab->len; ++i ) {
+		const mce_conf_cache_group_t *grp =
+			&g_array_index(grptab, mce_conf_cache_group_t, i);
+		uint32_t mask = hdr.mch_group_bucket_count - 1;
+		uint32_t slot = mce_conf_cache_hash(pool->str + grp->mcg_name, 0);
+
+		while( gbk[slot & mask] )
+			++slot;
+		gbk[slot & mask] = i + 1;
+	}
+
+	for( guint i = 0; i < enttab->len; ++i ) {
+		const mce_conf_cache_entry_t *ent =
+			&g_array_index(enttab, mce_conf_cache_entry_t, i);
+		const mce_conf_cache_group_t *grp =
+			&g_array_index(grptab, mce_conf_cache_group_t,
+				       ent->mcv_group);
+		uint32_t mask = hdr.mch_entry_bucket_count - 1;
+		uint32_t slot = mce_conf_cache_hash(pool->str + grp->mcg_name,
+						    pool->str + ent->mcv_key);
+
+		while( ebk[slot & mask] )
+			++slot;
+		ebk[slot & mask] = i + 1;
+	}
+
+	/* Construct file image */
+	g_byte_array_append(image, (const guint8 *)&hdr, sizeof hdr);
+
+	mce_conf_cache_align(image);
+	hdr.mch_source_offs  = image->len;
+	hdr.mch_source_count = srctab->len;
+	g_byte_array_append(image, (const guint8 *)srctab->data,
+			    srctab->len * sizeof (mce_conf_cache_source_t));
+
+	mce_conf_cache_align(image);
+	hdr.mch_group_offs  = image->len;
+	hdr.mch_group_count = grptab->len;
+	g_byte_array_append(image, (const guint8 *)grptab->data,
+			    grptab->len * sizeof (mce_conf_cache_group_t));
+
+	mce_conf_cache_align(image);
+	hdr.mch_entry_offs  = image->len;
+	hdr.mch_entry_count = enttab->len;
+	g_byte_array_append(image, (const guint8 *)enttab->data,
+			    enttab->len * sizeof (mce_conf_cache_entry_t));
+
+	mce_conf_cache_align(image);
+	hdr.mch_group_bucket_offs = image->len;
+	g_byte_array_append(image, (const guint8 *)gbk,
+			    hdr.mch_group_bucket_count * sizeof *gbk);
+
+	mce_conf_cache_align(image);
+	hdr.mch_entry_bucket_offs = image->len;
+	g_byte_array_append(image, (const guint8 *)ebk,
+			    hdr.mch_entry_bucket_count * sizeof *ebk);
+
+	hdr.mch_string_offs = image->len;
+	hdr.mch_string_size = pool->len;
+	g_byte_array_append(image, (const guint8 *)pool->str, pool->len);
+
+	memcpy(hdr.mch_magic, MCE_CONF_CACHE_MAGIC, sizeof hdr.mch_magic);
+	hdr.mch_file_size = image->len;
+	memcpy(image->data, &hdr, sizeof hdr);
+
+	/* Note: g_file_set_contents() replaces the file atomically */
+	if( !g_file_set_contents(MCE_CONF_CACHE_PATH,
+				 (const gchar *)image->data,
+				 image->len, &err) ) {
+		mce_log(LL_WARN, "%s: could not write cache: %s",
+			MCE_CONF_CACHE_PATH, err->message);
+		goto EXIT;
+	}
+
+	mce_log(LL_NOTICE, "wrote configuration cache %s; %u groups, "
+		"%u keys, %u bytes", MCE_CONF_CACHE_PATH,
+		hdr.mch_group_count, hdr.mch_entry_count,
+		hdr.mch_file_size);
+
+	res = true;
+
+EXIT:
+	g_clear_error(&err);
+	g_byte_array_free(image, TRUE);
+	g_free(ebk);
+	g_free(gbk);
+	g_array_free(enttab, TRUE);
+	g_array_free(grptab, TRUE);
+	g_array_free(srctab, TRUE);
+	g_string_free(pool, TRUE);
+	g_strfreev(groups);
+
+	return res;
+}
+
 /** Internal helper for insuring valid keyfile pointer is available
  *
- * @param keyfilepointer custom key file, or NULL to use the default one
+ * When configuration cache is in use, the requested value is staged
+ * in a single value keyfile so that glib value parsing can be used.
+ * The same keyfile is reused for all lookups; the previously staged
+ * value is removed before staging the next one.
+ *
+ * @param group The configuration group
+ * @param key   The configuration key, or NULL
  *
  * @returns non-null keyfile pointer, or aborts
  */
-static gpointer mce_conf_get_keyfile(void)
+static gpointer mce_conf_get_keyfile(const gchar *group, const gchar *key)
 {
+	if( conf_cache_base ) {
+		const char *val = key ? mce_conf_cache_find_value(group, key) : 0;
+
+		if( conf_cache_scratch_group ) {
+			g_key_file_remove_group(conf_cache_scratch,
+						conf_cache_scratch_group, 0);
+			g_free(conf_cache_scratch_group),
+				conf_cache_scratch_group = 0;
+		}
+
+		if( val ) {
+			g_key_file_set_value(conf_cache_scratch, group, key, val);
+			conf_cache_scratch_group = g_strdup(group);
+		}
+
+		return conf_cache_scratch;
+	}
+
 	if( !keyfile ) {
 		/* Earlier it was possible to have mce running with NULL
 		 * keyfile. Now the only reasons that might happen are:
@@ -61,7 +793,10 @@ static gpointer mce_conf_get_keyfile(void)
  */
 gboolean mce_conf_has_group(const gchar *group)
 {
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	if( conf_cache_base )
+		return mce_conf_cache_find_group(group) != 0;
+
+	gpointer keyfileptr = mce_conf_get_keyfile(group, 0);
 	return g_key_file_has_group(keyfileptr, group);
 }
 
@@ -74,7 +809,10 @@ gboolean mce_conf_has_group(const gchar *group)
  */
 gboolean mce_conf_has_key(const gchar *group, const gchar *key)
 {
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	if( conf_cache_base )
+		return mce_conf_cache_find_value(group, key) != 0;
+
+	gpointer keyfileptr = mce_conf_get_keyfile(group, key);
 	GError *error = NULL;
 	gboolean res = g_key_file_has_key(keyfileptr, group, key, &error);
 	g_clear_error(&error);
@@ -96,7 +834,7 @@ gboolean mce_conf_get_bool(const gchar *group, const gchar *key,
 	gboolean tmp = FALSE;
 	GError *error = NULL;
 
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	gpointer keyfileptr = mce_conf_get_keyfile(group, key);
 
 	tmp = g_key_file_get_boolean(keyfileptr, group, key, &error);
 
@@ -128,7 +866,7 @@ gint mce_conf_get_int(const gchar *group, const gchar *key,
 	gint tmp = -1;
 	GError *error = NULL;
 
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	gpointer keyfileptr = mce_conf_get_keyfile(group, key);
 
 	tmp = g_key_file_get_integer(keyfileptr, group, key, &error);
 
@@ -160,7 +898,7 @@ gint *mce_conf_get_int_list(const gchar *group, const gchar *key,
 	gint *tmp = NULL;
 	GError *error = NULL;
 
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	gpointer keyfileptr = mce_conf_get_keyfile(group, key);
 
 	tmp = g_key_file_get_integer_list(keyfileptr, group, key,
 					  length, &error);
@@ -193,7 +931,7 @@ gchar *mce_conf_get_string(const gchar *group, const gchar *key,
 	gchar *tmp = NULL;
 	GError *error = NULL;
 
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	gpointer keyfileptr = mce_conf_get_keyfile(group, key);
 
 	tmp = g_key_file_get_string(keyfileptr, group, key, &error);
 
@@ -229,7 +967,7 @@ gchar **mce_conf_get_string_list(const gchar *group, const gchar *key,
 	gchar **tmp = NULL;
 	GError *error = NULL;
 
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	gpointer keyfileptr = mce_conf_get_keyfile(group, key);
 
 	tmp = g_key_file_get_string_list(keyfileptr, group, key,
 					 length, &error);
@@ -252,7 +990,32 @@ gchar **mce_conf_get_keys(const gchar *group, gsize *length)
 	gchar **tmp = NULL;
 	GError *error = NULL;
 
-	gpointer keyfileptr = mce_conf_get_keyfile();
+	if( conf_cache_base ) {
+		const mce_conf_cache_group_t *grp =
+			mce_conf_cache_find_group(group);
+		const mce_conf_cache_entry_t *ent =
+			mce_conf_cache_table(mce_conf_cache_header()->mch_entry_offs);
+
+		if( !grp ) {
+			mce_log(LL_WARN,
+				"Could not get config keys %s; %s",
+				group, "group not found");
+			if( length )
+				*length = 0;
+			goto EXIT;
+		}
+
+		tmp = g_malloc0((grp->mcg_count + 1) * sizeof *tmp);
+		for( uint32_t i = 0; i < grp->mcg_count; ++i ) {
+			uint32_t key = ent[grp->mcg_first + i].mcv_key;
+			tmp[i] = g_strdup(mce_conf_cache_string(key));
+		}
+		if( length )
+			*length = grp->mcg_count;
+		goto EXIT;
+	}
+
+	gpointer keyfileptr = mce_conf_get_keyfile(group, 0);
 
 	tmp = g_key_file_get_keys(keyfileptr, group, length, &error);
 
@@ -266,6 +1029,7 @@ gchar **mce_conf_get_keys(const gchar *group, gsize *length)
 
 	g_clear_error(&error);
 
+EXIT:
 	return tmp;
 }
 
@@ -611,28 +1375,31 @@ static gchar **black_cached = NULL;
  */
 gboolean mce_conf_init(void)
 {
-	gboolean status = FALSE;
+	gboolean status  = FALSE;
+	GArray  *sources = mce_conf_cache_scan_sources();
+
+	/* Use pre-merged configuration if it is up to date */
+	if( sources && mce_conf_cache_load(sources) )
+		goto CACHED;
 
 	if( !(keyfile = mce_conf_read_ini_files()) )
 		goto EXIT;
 
-	touch_cached = g_key_file_get_string_list(keyfile,
-						  "evdev",
-						  "touch",
-						  0, 0);
+	/* Update cache and switch over to using it */
+	if( sources && mce_conf_cache_save(keyfile, sources) &&
+	    mce_conf_cache_load(sources) )
+		g_key_file_free(keyfile), keyfile = 0;
 
-	keybd_cached = g_key_file_get_string_list(keyfile,
-						  "evdev",
-						  "keybd",
-						  0, 0);
+CACHED:
+	touch_cached = mce_conf_get_string_list("evdev", "touch", 0);
+	keybd_cached = mce_conf_get_string_list("evdev", "keybd", 0);
+	black_cached = mce_conf_get_string_list("evdev", "black", 0);
 
-	black_cached = g_key_file_get_string_list(keyfile,
-						  "evdev",
-						  "black",
-						  0, 0);
 	status = TRUE;
 
 EXIT:
+	mce_conf_cache_free_sources(sources);
+
 	return status;
 }
 
@@ -647,6 +1414,8 @@ void mce_conf_exit(void)
 
 	if( keyfile ) g_key_file_free(keyfile), keyfile = 0;
 
+	mce_conf_cache_unload();
+
 	return;
 }
 
@@ -27,6 +27,7 @@
 #include "mce-log.h"
 #include "mce-lib.h"
 #include "mce-wakelock.h"
+#include "mce-prof.h"
 
 #include "systemui/dbus-names.h"
 
@@ -195,6 +196,19 @@ struct peerinfo_t
     char             pi_repr[128];
 };
 
+/** Pending / last broadcast state for one coalesced signal */
+typedef struct
+{
+	/** Signal identity: path, interface, member and optional key arg */
+	gchar       *mc_key;
+
+	/** Signal waiting to be broadcast, or NULL */
+	DBusMessage *mc_pending;
+
+	/** Arguments of the last broadcast signal, or NULL */
+	char        *mc_sent;
+} mdb_coalesce_t;
+
 /* ========================================================================= *
  * FUNCTIONALITY
  * ========================================================================= */
@@ -331,6 +345,27 @@ static gboolean          dbus_send_va                          (const char *serv
 gboolean                 dbus_send_ex                          (const char *service, const char *path, const char *interface, const char *name, DBusPendingCallNotifyFunction callback, void *user_data, DBusFreeFunction user_free, DBusPendingCall **ppc, int first_arg_type, ...);
 gboolean                 dbus_send_ex2                         (const char *service, const char *path, const char *interface, const char *name, DBusPendingCallNotifyFunction callback, int timeout, void *user_data, DBusFreeFunction user_free, DBusPendingCall **ppc, int first_arg_type, ...);
 gboolean                 dbus_send                             (const gchar *const service, const gchar *const path, const gchar *const interface, const gchar *const name, DBusPendingCallNotifyFunction callback, int first_arg_type, ...);
+static gboolean          dbus_send_message_now                 (DBusMessage *const msg);
+
+/* ------------------------------------------------------------------------- *
+ * SIGNAL_COALESCING
+ * ------------------------------------------------------------------------- */
+
+static const char       *mdb_coalesce_lookup                   (DBusMessage *msg, bool *keyed);
+static gchar            *mdb_coalesce_key                      (DBusMessage *msg, const char *member, bool keyed);
+static mdb_coalesce_t   *mdb_coalesce_create                   (const char *key);
+static void              mdb_coalesce_delete                   (mdb_coalesce_t *self);
+static void              mdb_coalesce_delete_cb                (gpointer self);
+static bool              mdb_coalesce_queue_message            (DBusMessage *msg);
+static void              mdb_coalesce_flush                    (void);
+static gboolean          mdb_coalesce_flush_cb                 (gpointer aptr);
+static void              mdb_coalesce_schedule_flush           (void);
+static void              mdb_coalesce_cancel_flush             (void);
+static gboolean          mdb_coalesce_trim_cb                  (gpointer key, gpointer value, gpointer aptr);
+static void              mdb_coalesce_trim                     (void);
+static gboolean          mdb_coalesce_peer_added_cb            (DBusMessage *const msg);
+static void              mdb_coalesce_init                     (void);
+static void              mdb_coalesce_quit                     (void);
 
 /* ------------------------------------------------------------------------- *
  * METHOD_CALL_HANDLERS
@@ -338,6 +373,7 @@ gboolean                 dbus_send                             (const gchar *con
 
 static gboolean          version_get_dbus_cb                   (DBusMessage *const msg);
 static gboolean          suspend_stats_get_dbus_cb             (DBusMessage *const req);
+static gboolean          datapipe_recording_dump_dbus_cb       (DBusMessage *const req);
 static gboolean          verbosity_get_dbus_cb                 (DBusMessage *const req);
 static gboolean          config_get_dbus_cb                    (DBusMessage *const msg);
 static gboolean          verbosity_set_dbus_cb                 (DBusMessage *const req);
@@ -458,6 +494,7 @@ DBusConnection          *dbus_bus_get                          (DBusBusType type
 DBusConnection          *dbus_bus_get_private                  (DBusBusType type, DBusError *err);
 static void              mce_dbus_init_privileged_uid          (void);
 static void              mce_dbus_init_privileged_gid          (void);
+void                     mce_dbus_trim                         (void);
 gboolean                 mce_dbus_init                         (const gboolean systembus);
 void                     mce_dbus_exit                         (void);
 
@@ -2091,10 +2128,32 @@ DBusMessage *dbus_new_method_reply(DBusMessage *const message)
  * Send a D-Bus message
  * Side-effects: frees msg
  *
+ * Broadcasts of state signals are coalesced, see
+ * mdb_coalesce_queue_message().
+ *
  * @param msg The D-Bus message to send
  * @return TRUE on success, FALSE on out of memory
  */
 gboolean dbus_send_message(DBusMessage *const msg)
+{
+	if( mdb_coalesce_queue_message(msg) )
+		return TRUE;
+
+	/* Keep all other messages - signals, method calls and replies -
+	 * ordered with respect to already queued state signals */
+	mdb_coalesce_flush();
+
+	return dbus_send_message_now(msg);
+}
+
+/**
+ * Send a D-Bus message without coalescing
+ * Side-effects: frees msg
+ *
+ * @param msg The D-Bus message to send
+ * @return TRUE on success, FALSE on out of memory
+ */
+static gboolean dbus_send_message_now(DBusMessage *const msg)
 {
 	gboolean status = FALSE;
 
@@ -2138,6 +2197,9 @@ dbus_send_message_with_reply_handler(DBusMessage *const msg,
 	if( !msg )
 		goto EXIT;
 
+	/* Method calls must not overtake queued state signals */
+	mdb_coalesce_flush();
+
 	if( !dbus_connection_send_with_reply(dbus_connection, msg, &pc,
 					     timeout) ) {
 		mce_log(LL_CRIT, "Out of memory when sending D-Bus message");
@@ -2364,6 +2426,416 @@ gboolean dbus_send(const gchar *const service, const gchar *const path,
 	return res;
 }
 
+/* ========================================================================= *
+ * SIGNAL_COALESCING
+ * ========================================================================= */
+
+/** Broadcast signals that carry state and can thus be coalesced
+ *
+ * When the same signal is broadcast several times during one main
+ * loop iteration, only the last one is sent - and only if it differs
+ * from the previously broadcast one, unless a new client has connected
+ * to the bus in the meanwhile. Queued signals are
+ * flushed before any other message is sent, so that the ordering
+ * with respect to method calls, replies and other signals is retained.
+ *
+ * Signals that carry events (led pattern activation, ui feedback,
+ * power key actions, etc) must not be listed here.
+ */
+static const struct
+{
+	/** Signal name */
+	const char *member;
+
+	/** Whether the first string argument is part of signal identity */
+	bool        keyed;
+} mdb_coalesce_lut[] =
+{
+	{ MCE_DISPLAY_SIG,                  false },
+	{ MCE_TKLOCK_MODE_SIG,              false },
+	{ MCE_CONFIG_CHANGE_SIG,            true  },
+	{ MCE_INACTIVITY_SIG,               false },
+	{ MCE_CHARGER_STATE_SIG,            false },
+	{ MCE_BATTERY_STATUS_SIG,           false },
+	{ MCE_BATTERY_LEVEL_SIG,            false },
+	{ MCE_USB_CABLE_STATE_SIG,          false },
+	{ MCE_PSM_STATE_SIG,                false },
+	{ MCE_RADIO_STATES_SIG,             false },
+	{ MCE_CALL_STATE_SIG,               false },
+	{ MCE_PREVENT_BLANK_SIG,            false },
+	{ MCE_BLANKING_POLICY_SIG,          false },
+	{ MCE_BLANKING_INHIBIT_SIG,         false },
+	{ MCE_LPM_UI_MODE_SIG,              false },
+	{ MCE_COLOR_PROFILE_SIG,            false },
+	{ MCE_BUTTON_BACKLIGHT_SIG,         false },
+	{ MCE_TOUCH_INPUT_POLICY_SIG,       false },
+	{ MCE_VOLKEY_INPUT_POLICY_SIG,      false },
+	{ MCE_HARDWARE_KEYBOARD_STATE_SIG,  false },
+	{ MCE_SLIDING_KEYBOARD_STATE_SIG,   false },
+	{ MCE_MEMORY_LEVEL_SIG,             false },
+};
+
+/** Coalescing state lookup table; signal identity -> mdb_coalesce_t * */
+static GHashTable *mdb_coalesce_lut_by_key = 0;
+
+/** Signals waiting to be broadcast; in order of first queuing */
+static GQueue mdb_coalesce_queue = G_QUEUE_INIT;
+
+/** Idle callback id for broadcasting queued signals */
+static guint mdb_coalesce_flush_id = 0;
+
+/** Check if a message is a broadcast signal that can be coalesced
+ *
+ * @param msg    D-Bus message
+ * @param keyed  where to store key argument flag
+ *
+ * @return signal name, or NULL if the message can't be coalesced
+ */
+static const char *
+mdb_coalesce_lookup(DBusMessage *msg, bool *keyed)
+{
+	const char *member = 0;
+
+	if( dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_SIGNAL )
+		goto EXIT;
+
+	if( dbus_message_get_destination(msg) )
+		goto EXIT;
+
+	if( !(member = dbus_message_get_member(msg)) )
+		goto EXIT;
+
+	for( size_t i = 0; i < G_N_ELEMENTS(mdb_coalesce_lut); ++i ) {
+		if( strcmp(mdb_coalesce_lut[i].member, member) )
+			continue;
+		*keyed = mdb_coalesce_lut[i].keyed;
+		return member;
+	}
+
+	member = 0;
+
+EXIT:
+	return member;
+}
+
+/** Construct signal identity string for coalescing purposes
+ *
+ * @param msg     D-Bus signal message
+ * @param member  signal name
+ * @param keyed   true to include the first string argument
+ *
+ * @return identity string, caller must release with g_free()
+ */
+static gchar *
+mdb_coalesce_key(DBusMessage *msg, const char *member, bool keyed)
+{
+	const char      *arg = 0;
+	DBusMessageIter  iter;
+
+	if( keyed && dbus_message_iter_init(msg, &iter) )
+		mce_dbus_iter_get_string(&iter, &arg);
+
+	return g_strdup_printf("%s %s %s%s%s",
+			       dbus_message_get_path(msg) ?: "",
+			       dbus_message_get_interface(msg) ?: "",
+			       member,
+			       arg ? " " : "",
+			       arg ?: "");
+}
+
+/** Create coalescing state object
+ *
+ * @param key  signal identity string
+ *
+ * @return state object
+ */
+static mdb_coalesce_t *
+mdb_coalesce_create(const char *key)
+{
+	mdb_coalesce_t *self = g_malloc0(sizeof *self);
+
+	self->mc_key     = g_strdup(key);
+	self->mc_pending = 0;
+	self->mc_sent    = 0;
+
+	return self;
+}
+
+/** Delete coalescing state object
+ *
+ * @param self  state object, or NULL
+ */
+static void
+mdb_coalesce_delete(mdb_coalesce_t *self)
+{
+	if( !self )
+		goto EXIT;
+
+	if( self->mc_pending )
+		dbus_message_unref(self->mc_pending);
+
+	free(self->mc_sent);
+	g_free(self->mc_key);
+	g_free(self);
+
+EXIT:
+	return;
+}
+
+/** Delete coalescing state object; type agnostic callback function
+ *
+ * @param self  state object, or NULL
+ */
+static void
+mdb_coalesce_delete_cb(gpointer self)
+{
+	mdb_coalesce_delete(self);
+}
+
+/** Queue broadcast signal for coalesced sending
+ *
+ * If the signal is already queued, the pending message is replaced
+ * with the new one, but the position in the queue is retained.
+ *
+ * Side-effects: takes ownership of msg if true is returned
+ *
+ * @param msg  D-Bus message
+ *
+ * @return true if the message was queued, false if it should be
+ *         sent immediately
+ */
+static bool
+mdb_coalesce_queue_message(DBusMessage *msg)
+{
+	bool            queued = false;
+	bool            keyed  = false;
+	const char     *member = 0;
+	gchar          *key    = 0;
+	mdb_coalesce_t *state  = 0;
+
+	if( !mdb_coalesce_lut_by_key )
+		goto EXIT;
+
+	if( !(member = mdb_coalesce_lookup(msg, &keyed)) )
+		goto EXIT;
+
+	key = mdb_coalesce_key(msg, member, keyed);
+
+	if( !(state = g_hash_table_lookup(mdb_coalesce_lut_by_key, key)) ) {
+		state = mdb_coalesce_create(key);
+		g_hash_table_replace(mdb_coalesce_lut_by_key,
+				     state->mc_key, state);
+	}
+
+	if( state->mc_pending ) {
+		mce_log(LL_DEBUG, "%s: superseded", key);
+		dbus_message_unref(state->mc_pending);
+	}
+	else {
+		g_queue_push_tail(&mdb_coalesce_queue, state);
+	}
+
+	state->mc_pending = msg;
+	queued = true;
+
+	/* Block suspend until the queue has been flushed */
+	mce_wakelock_obtain("dbus_send", MCE_DBUS_SEND_SUSPEND_BLOCK_MS);
+
+	mdb_coalesce_schedule_flush();
+
+EXIT:
+	g_free(key);
+
+	return queued;
+}
+
+/** Broadcast queued signals
+ *
+ * Signals that are identical to the previously broadcast ones are
+ * dropped.
+ */
+static void
+mdb_coalesce_flush(void)
+{
+	mdb_coalesce_t *state;
+
+	mdb_coalesce_cancel_flush();
+
+	while( (state = g_queue_pop_head(&mdb_coalesce_queue)) ) {
+		DBusMessage     *msg  = state->mc_pending;
+		char            *args = 0;
+		DBusMessageIter  iter;
+
+		state->mc_pending = 0;
+
+		if( !msg )
+			continue;
+
+		dbus_message_iter_init(msg, &iter);
+		args = mce_dbus_message_iter_repr(&iter);
+
+		if( args && state->mc_sent && !strcmp(args, state->mc_sent) ) {
+			mce_log(LL_DEBUG, "%s: unchanged", state->mc_key);
+			dbus_message_unref(msg);
+			free(args);
+			continue;
+		}
+
+		free(state->mc_sent), state->mc_sent = args;
+		dbus_send_message_now(msg);
+	}
+}
+
+/** Idle callback for broadcasting queued signals
+ *
+ * @param aptr  (unused) user data pointer
+ *
+ * @return FALSE to stop the idle callback from repeating
+ */
+static gboolean
+mdb_coalesce_flush_cb(gpointer aptr)
+{
+	(void)aptr;
+
+	if( !mdb_coalesce_flush_id )
+		goto EXIT;
+
+	mdb_coalesce_flush_id = 0;
+	mdb_coalesce_flush();
+
+EXIT:
+	return FALSE;
+}
+
+/** Schedule broadcasting of queued signals
+ */
+static void
+mdb_coalesce_schedule_flush(void)
+{
+	if( mdb_coalesce_flush_id )
+		goto EXIT;
+
+	/* High priority idle -> dispatched on the next main loop
+	 * iteration, before normal priority io / timer callbacks */
+	mdb_coalesce_flush_id = g_idle_add_full(G_PRIORITY_HIGH,
+						mdb_coalesce_flush_cb, 0, 0);
+
+EXIT:
+	return;
+}
+
+/** Cancel pending broadcasting of queued signals
+ */
+static void
+mdb_coalesce_cancel_flush(void)
+{
+	if( mdb_coalesce_flush_id ) {
+		g_source_remove(mdb_coalesce_flush_id),
+			mdb_coalesce_flush_id = 0;
+	}
+}
+
+/** Predicate for: coalescing state object can be dropped
+ *
+ * @param key    signal identity string (unused)
+ * @param value  coalescing state object
+ * @param aptr   (unused) user data pointer
+ *
+ * @return TRUE if the object has no pending signal, FALSE otherwise
+ */
+static gboolean
+mdb_coalesce_trim_cb(gpointer key, gpointer value, gpointer aptr)
+{
+	(void)key;
+	(void)aptr;
+
+	const mdb_coalesce_t *state = value;
+
+	return state->mc_pending == 0;
+}
+
+/** Forget last broadcast values of signals that are not queued
+ *
+ * Afterwards the next broadcast of each signal is sent even if
+ * it happens to repeat the previous value.
+ */
+static void
+mdb_coalesce_trim(void)
+{
+	if( mdb_coalesce_lut_by_key )
+		g_hash_table_foreach_remove(mdb_coalesce_lut_by_key,
+					    mdb_coalesce_trim_cb, 0);
+}
+
+/** D-Bus callback for names that got an owner without having one before
+ *
+ * A client that has just connected to the bus might not have seen
+ * the previously broadcast state signals, so repeating values must
+ * not be suppressed after that.
+ *
+ * @param msg  NameOwnerChanged signal
+ *
+ * @return TRUE
+ */
+static gboolean
+mdb_coalesce_peer_added_cb(DBusMessage *const msg)
+{
+	const char *name = 0;
+	const char *prev = 0;
+	const char *curr = 0;
+	DBusError   err  = DBUS_ERROR_INIT;
+
+	if( !dbus_message_get_args(msg, &err,
+				   DBUS_TYPE_STRING, &name,
+				   DBUS_TYPE_STRING, &prev,
+				   DBUS_TYPE_STRING, &curr,
+				   DBUS_TYPE_INVALID) ) {
+		mce_log(LL_WARN, "%s: %s", err.name, err.message);
+		goto EXIT;
+	}
+
+	if( *prev || !*curr )
+		goto EXIT;
+
+	mce_log(LL_DEBUG, "%s: connected; forget broadcast history", name);
+	mdb_coalesce_trim();
+
+EXIT:
+	dbus_error_free(&err);
+	return TRUE;
+}
+
+/** Initialize signal coalescing
+ */
+static void
+mdb_coalesce_init(void)
+{
+	if( !mdb_coalesce_lut_by_key ) {
+		mdb_coalesce_lut_by_key =
+			g_hash_table_new_full(g_str_hash, g_str_equal,
+					      0, mdb_coalesce_delete_cb);
+	}
+}
+
+/** Stop signal coalescing
+ *
+ * Signals that are still queued are broadcast immediately.
+ */
+static void
+mdb_coalesce_quit(void)
+{
+	if( dbus_connection )
+		mdb_coalesce_flush();
+
+	mdb_coalesce_cancel_flush();
+	g_queue_clear(&mdb_coalesce_queue);
+
+	if( mdb_coalesce_lut_by_key ) {
+		g_hash_table_unref(mdb_coalesce_lut_by_key),
+			mdb_coalesce_lut_by_key = 0;
+	}
+}
+
 /* ========================================================================= *
  * METHOD_CALL_HANDLERS
  * ========================================================================= */
@@ -2441,6 +2913,50 @@ EXIT:
 	return TRUE;
 }
 
+/** D-Bus callback for the dump datapipe recording method call
+ *
+ * The recording is written to a fixed location and the
+ * path is returned to the caller.
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean datapipe_recording_dump_dbus_cb(DBusMessage *const req)
+{
+	static const char path[] = DATAPIPE_RECORDING_FILE;
+
+	DBusMessage *rsp = 0;
+	const char  *res = path;
+
+	mce_log(LL_DEVEL, "datapipe recording dump request from %s",
+		mce_dbus_get_message_sender_ident(req));
+
+	if( !datapipe_recorder_dump(path) ) {
+		rsp = dbus_message_new_error(req, DBUS_ERROR_FAILED,
+					     "datapipe recording not available");
+		goto SEND;
+	}
+
+	rsp = dbus_new_method_reply(req);
+
+	if( !dbus_message_append_args(rsp,
+				      DBUS_TYPE_STRING, &res,
+				      DBUS_TYPE_INVALID) ) {
+		mce_log(LL_ERR, "Failed to append arguments");
+		goto EXIT;
+	}
+
+SEND:
+	dbus_send_message(rsp), rsp = 0;
+
+EXIT:
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	return TRUE;
+}
+
 /** D-Bus callback for: get mce verbosity method call
  *
  * @param req The D-Bus message to reply to
@@ -3661,6 +4177,8 @@ static DBusHandlerResult msg_handler(DBusConnection *const connection,
 
 	peerinfo_t *peerinfo  = 0;
 
+	mce_prof_enter("dbus", member);
+
 	if( sender )
 		peerinfo = mce_dbus_add_peerinfo(sender);
 
@@ -3758,6 +4276,8 @@ static DBusHandlerResult msg_handler(DBusConnection *const connection,
 
 EXIT:
 
+	mce_prof_leave();
+
 	mce_wakelock_release("dbus_recv");
 
 	return status;
@@ -4779,6 +5299,14 @@ static mce_dbus_handler_t mce_dbus_handlers[] =
 			"    <arg name=\"key_name\" type=\"s\"/>\n"
 			"    <arg name=\"key_value\" type=\"v\"/>\n"
 	},
+	/* signals */
+	{
+		.interface = DBUS_INTERFACE_DBUS,
+		.name      = "NameOwnerChanged",
+		.rules     = "arg1=''",
+		.type      = DBUS_MESSAGE_TYPE_SIGNAL,
+		.callback  = mdb_coalesce_peer_added_cb,
+	},
 	/* method calls */
 	{
 		.interface = MCE_REQUEST_IF,
@@ -4834,6 +5362,14 @@ static mce_dbus_handler_t mce_dbus_handlers[] =
 			"    <arg direction=\"out\" name=\"uptime_ms\" type=\"x\"/>\n"
 			"    <arg direction=\"out\" name=\"suspend_ms\" type=\"x\"/>\n"
 	},
+	{
+		.interface = MCE_REQUEST_IF,
+		.name      = MCE_DATAPIPE_RECORDING_DUMP,
+		.type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+		.callback  = datapipe_recording_dump_dbus_cb,
+		.args      =
+			"    <arg direction=\"out\" name=\"path\" type=\"s\"/>\n"
+	},
 	{
 		.interface = MCE_REQUEST_IF,
 		.name      = MCE_VERBOSITY_GET,
@@ -4976,6 +5512,18 @@ EXIT:
     free(data);
 }
 
+/**
+ * Release memory used for rebuildable caches
+ */
+void mce_dbus_trim(void)
+{
+	/* Drop half removed handlers */
+	mce_dbus_squeeze_slist(&dbus_handlers);
+
+	/* Drop signal coalescing history */
+	mdb_coalesce_trim();
+}
+
 /**
  * Init function for the mce-dbus component
  * Pre-requisites: glib mainloop registered
@@ -5027,6 +5575,9 @@ gboolean mce_dbus_init(const gboolean systembus)
 	if( !dbus_init_message_handler() )
 		goto EXIT;
 
+	/* Enable coalescing of broadcast signals */
+	mdb_coalesce_init();
+
 	/* Start tracking essential services */
 	mce_dbus_init_peerinfo();
 
@@ -5061,6 +5612,9 @@ void mce_dbus_exit(void)
 		dbus_handlers = 0;
 	}
 
+	/* Send queued signals and stop coalescing */
+	mdb_coalesce_quit();
+
 	/* Disconnect from D-Bus */
 	if (dbus_connection != NULL) {
 		mce_log(LL_DEBUG, "closing dbus connection");
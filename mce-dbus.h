@@ -121,6 +121,7 @@ gssize mce_dbus_owner_monitor_remove(const gchar *service,
 				     GSList **monitor_list);
 void mce_dbus_owner_monitor_remove_all(GSList **monitor_list);
 
+void mce_dbus_trim(void);
 gboolean mce_dbus_init(const gboolean systembus);
 void mce_dbus_exit(void);
 
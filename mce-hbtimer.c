@@ -29,6 +29,7 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-prof.h"
 
 #ifdef ENABLE_WAKELOCKS
 # include "libwakelock.h"
@@ -346,7 +347,9 @@ mce_hbtimer_notify(mce_hbtimer_t *self)
     self->hbt_in_notify = true;
     self->hbt_trigger   = NO_TICK;
 
+    mce_prof_enter("hbtimer", self->hbt_name);
     bool again = self->hbt_notify(self->hbt_user_data);
+    mce_prof_leave();
 
     /* Check that notify callback did not delete the timer */
     if( !mht_queue_has_timer(self) )
@@ -11,8 +11,8 @@
  * elements these functions turn in to "NOP and return failure".
  *
  * In addition to the above this module also:
- * - moves sensor input data via pipe from worker thread context to the
- *   thread that is running the glib mainloop.
+ * - moves sensor input data via lock-free ring buffer from worker thread
+ *   context to the thread that is running the glib mainloop.
  * - proxies diagnostic output from hybris-plugin to mce_log()
  * ========================================================================= */
 
@@ -30,30 +30,37 @@
 #include <errno.h>
 #include <dlfcn.h>
 
+#include <sys/eventfd.h>
+
 static void mce_hybris_ps_set_hook(mce_hybris_ps_fn cb);
 static void mce_hybris_als_set_hook(mce_hybris_als_fn cb);
 
 /* ------------------------------------------------------------------------- *
- * Feeding sensor data via pipe to glib mainloop goes roughly as follows
+ * Feeding sensor data via ring buffer to glib mainloop goes roughly as follows
  *
  * --- mce-libhybris-plugin worker thread --
  * 1) uses blocking poll_dev->poll() function to read sensor data
- * 2) uses a set of callbacks to write the data to a pipe
+ * 2) uses a set of callbacks to store the data to a lock-free ring buffer
+ *    and rings an eventfd doorbell if the buffer was empty
  * --- mce-libhybris-module --
- * 3) iowatch reads the data from pipe
+ * 3) iowatch on the eventfd drains all buffered data in one go
  * 4) and passes the data to mce via another set of callbacks
  * --- mce sensor handling code --
  * 5) can act on the data in the context that runs gmainloop
+ *
+ * The ring buffer assumes that there is exactly one producer thread
+ * (the hybris-plugin sensor worker) and one consumer thread (the one
+ * running glib mainloop).
  * ------------------------------------------------------------------------- */
 
-/** Sensor enumeration for mux @ worker thread -> pipe -> demux @ mainloop */
+/** Sensor enumeration for mux @ worker thread -> ring -> demux @ mainloop */
 enum
 {
   EVEPIPE_ALS,
   EVEPIPE_PS,
 };
 
-/** Sensor data passed over pipe */
+/** Sensor data passed over ring buffer */
 typedef struct
 {
   int64_t time;  // time stamp from android side
@@ -61,7 +68,10 @@ typedef struct
   float   value; // sensor data from android side
 } evepipe_t;
 
-/** Initialize once flag for sensor data pipe */
+/** Number of slots in the sensor data ring buffer; must be power of two */
+#define EVEPIPE_RING_SIZE 256
+
+/** Initialize once flag for sensor data ring buffer */
 static bool evepipe_done = false;
 
 /** Callback for handling proximity data */
@@ -70,13 +80,75 @@ static mce_hybris_ps_fn  evepipe_ps_cb  = 0;
 /** Callback for handling ambient light data */
 static mce_hybris_als_fn evepipe_als_cb = 0;
 
-/** The sensor data pipe */
-static int               evepipe_fd[2]  = { -1, -1 };
+/** The doorbell eventfd for waking up mainloop */
+static int               evepipe_fd     = -1;
 
-/** I/O watch id for the sensor data pipe */
+/** I/O watch id for the doorbell eventfd */
 static guint             evepipe_id     = 0;
 
-/** I/O watch callback for handling pipe input
+/** Sensor data ring buffer slots */
+static evepipe_t         evepipe_ring[EVEPIPE_RING_SIZE];
+
+/** Ring buffer write position; modified only by the producer */
+static unsigned          evepipe_head   = 0;
+
+/** Ring buffer read position; modified only by the consumer */
+static unsigned          evepipe_tail   = 0;
+
+/** Number of samples dropped due to ring buffer overflow */
+static unsigned          evepipe_lost   = 0;
+
+/** Pass sensor data from ring buffer to mce callbacks
+ *
+ * Must be called only from the thread running glib mainloop.
+ */
+static void evepipe_drain(void)
+{
+  unsigned tail = evepipe_tail;
+
+  for( ;; ) {
+    unsigned head = __atomic_load_n(&evepipe_head, __ATOMIC_ACQUIRE);
+
+    if( head == tail ) {
+      /* Publish read position and then re-check that the producer did
+       * not add anything without ringing the doorbell in between */
+      __atomic_store_n(&evepipe_tail, tail, __ATOMIC_RELEASE);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+      if( __atomic_load_n(&evepipe_head, __ATOMIC_ACQUIRE) == tail )
+        break;
+      continue;
+    }
+
+    const evepipe_t *eve = &evepipe_ring[tail % EVEPIPE_RING_SIZE];
+
+    switch( eve->type ) {
+    case EVEPIPE_PS:
+      if( evepipe_ps_cb ) {
+        evepipe_ps_cb(eve->time, eve->value);
+      }
+      break;
+
+    case EVEPIPE_ALS:
+      if( evepipe_als_cb ) {
+        evepipe_als_cb(eve->time, eve->value);
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    ++tail;
+  }
+
+  unsigned lost = __atomic_exchange_n(&evepipe_lost, 0, __ATOMIC_RELAXED);
+  if( lost ) {
+    mce_log(LL_WARN, "sensor event ring overflow; %u events lost", lost);
+  }
+}
+
+/** I/O watch callback for handling doorbell input
  *
  * @param channel    (not used)
  * @param condition  (not used)
@@ -93,14 +165,16 @@ static gboolean evepipe_recv_cb(GIOChannel *channel,
 
   gboolean keep_going = TRUE;
 
-  evepipe_t eve[64];
+  uint64_t cnt = 0;
 
   if( condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL) )
   {
     keep_going = FALSE;
   }
 
-  int rc = read(evepipe_fd[0], eve, sizeof eve);
+  /* Acknowledge the doorbell before draining so that samples
+   * added after this point will trigger another wakeup */
+  int rc = read(evepipe_fd, &cnt, sizeof cnt);
 
   if( rc < 0 ) {
     switch( errno ) {
@@ -109,45 +183,27 @@ static gboolean evepipe_recv_cb(GIOChannel *channel,
       break;
 
     default:
-      mce_log(LL_ERR, "failed to read sensor events: %m");
+      mce_log(LL_ERR, "failed to read sensor event doorbell: %m");
       keep_going = FALSE;
-      break;
+      goto cleanup;
     }
-    goto cleanup;
   }
 
-  rc /= sizeof *eve;
-
-  for( int i = 0; i < rc; ++i ) {
-    switch( eve[i].type ) {
-    case EVEPIPE_PS:
-      if( evepipe_ps_cb ) {
-        evepipe_ps_cb(eve[i].time, eve[i].value);
-      }
-      break;
-
-    case EVEPIPE_ALS:
-      if( evepipe_als_cb ) {
-        evepipe_als_cb(eve[i].time, eve[i].value);
-      }
-      break;
-
-    default:
-      break;
-    }
-  }
+  evepipe_drain();
 
 cleanup:
 
   if( !keep_going )  {
-    mce_log(LL_CRIT, "disabling sensor event pipe iowatch");
+    mce_log(LL_CRIT, "disabling sensor event doorbell iowatch");
     evepipe_id = 0;
   }
 
   return keep_going;
 }
 
-/** Write sensor data to the pipe
+/** Store sensor data to the ring buffer
+ *
+ * Called from the hybris-plugin worker thread context.
  *
  * @param timestamp nanoseconds
  * @param type      EVEPIPE_ALS or EVEPIPE_PS
@@ -155,24 +211,39 @@ cleanup:
  */
 static void evepipe_send(int64_t timestamp, int32_t type, float data)
 {
-  evepipe_t eve =
-  {
-    .time  = timestamp,
-    .type  = type,
-    .value = data,
-  };
+  unsigned head = evepipe_head;
+  unsigned tail = __atomic_load_n(&evepipe_tail, __ATOMIC_ACQUIRE);
+
+  if( head - tail >= EVEPIPE_RING_SIZE ) {
+    /* Mainloop is not keeping up; drop the sample and let the
+     * consumer side report it instead of blocking the sensor thread */
+    __atomic_add_fetch(&evepipe_lost, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  evepipe_t *eve = &evepipe_ring[head % EVEPIPE_RING_SIZE];
+  eve->time  = timestamp;
+  eve->type  = type;
+  eve->value = data;
 
-  int rc = TEMP_FAILURE_RETRY(write(evepipe_fd[1], &eve, sizeof eve));
+  __atomic_store_n(&evepipe_head, head + 1, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-  if( rc != sizeof eve ) {
-    // TODO: since this happens from separate thread, we might want
-    //       to do something bit more clever in case the sensor data
-    //       overflows the pipe ...
+  /* Ring the doorbell only on empty -> non-empty transition */
+  if( __atomic_load_n(&evepipe_tail, __ATOMIC_ACQUIRE) != head )
+    return;
+
+  uint64_t cnt = 1;
+  int rc = TEMP_FAILURE_RETRY(write(evepipe_fd, &cnt, sizeof cnt));
+
+  if( rc != sizeof cnt && errno != EAGAIN ) {
+    // the eventfd counter can't realistically overflow, so any
+    // failure here means the doorbell is broken for good
     mce_abort();
   }
 }
 
-/** Write PS data to the sensor data pipe
+/** Write PS data to the sensor data ring buffer
  *
  * @param timestamp nanoseconds
  * @param distance  centimeters
@@ -182,7 +253,7 @@ static void evepipe_send_ps(int64_t timestamp, float distance)
   evepipe_send(timestamp, EVEPIPE_PS, distance);
 }
 
-/** Write ALS data to the sensor data pipe
+/** Write ALS data to the sensor data ring buffer
  * @param timestamp nanoseconds
  * @param ligt      lux
  */
@@ -191,7 +262,7 @@ static void evepipe_send_als(int64_t timestamp, float light)
   evepipe_send(timestamp, EVEPIPE_ALS, light);
 }
 
-/** Close sensor data pipe
+/** Close sensor data doorbell
  *
  * @param reset_done true if we wish to return to uninitialized
  *                   state, or false to preserve "already tried
@@ -202,14 +273,16 @@ static void evepipe_quit(bool reset_done)
   /* remove io watch */
   if( evepipe_id ) g_source_remove(evepipe_id), evepipe_id = 0;
 
-  /* close pipe file descriptors */
-  if( evepipe_fd[1] != -1 ) close(evepipe_fd[1]), evepipe_fd[1] = -1;
-  if( evepipe_fd[0] != -1 ) close(evepipe_fd[0]), evepipe_fd[0] = -1;
+  /* close doorbell file descriptor */
+  if( evepipe_fd != -1 ) close(evepipe_fd), evepipe_fd = -1;
+
+  /* discard unprocessed data */
+  evepipe_tail = evepipe_head;
 
   if( reset_done ) evepipe_done = false;
 }
 
-/** Initialize sensor data pipe
+/** Initialize sensor data ring buffer and doorbell
  *
  * @return true on success, or false in case of errors
  */
@@ -223,11 +296,11 @@ static bool evepipe_init(void)
 
   evepipe_done = true;
 
-  if( pipe(evepipe_fd) == -1 ) {
+  if( (evepipe_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1 ) {
     goto EXIT;
   }
 
-  if( !(chn = g_io_channel_unix_new(evepipe_fd[0])) ) {
+  if( !(chn = g_io_channel_unix_new(evepipe_fd)) ) {
     goto EXIT;
   }
 
@@ -634,8 +707,9 @@ bool mce_hybris_ps_set_callback(mce_hybris_ps_fn cb)
   bool res = true;
 
   if( (evepipe_ps_cb = cb) ) {
-    mce_hybris_ps_set_hook(evepipe_send_ps);
-    res = evepipe_init();
+    /* doorbell must exist before worker thread can start sending */
+    if( (res = evepipe_init()) )
+      mce_hybris_ps_set_hook(evepipe_send_ps);
   }
   else {
     mce_hybris_ps_set_hook(0);
@@ -709,8 +783,9 @@ bool mce_hybris_als_set_callback(mce_hybris_als_fn cb)
   bool res = true;
 
   if( (evepipe_als_cb = cb) ) {
-    mce_hybris_als_set_hook(evepipe_send_als);
-    res = evepipe_init();
+    /* doorbell must exist before worker thread can start sending */
+    if( (res = evepipe_init()) )
+      mce_hybris_als_set_hook(evepipe_send_als);
   }
   else {
     mce_hybris_als_set_hook(0);
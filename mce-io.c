@@ -25,6 +25,7 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-prof.h"
 
 #ifdef ENABLE_WAKELOCKS
 # include "libwakelock.h"
@@ -655,6 +656,8 @@ static gboolean mce_io_mon_input_cb(GIOChannel *source,
 		goto EXIT;
 	}
 
+	mce_prof_enter("iomon", iomon->path);
+
 	// error conditions
 	if( condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL) ) {
 		mce_log(LL_ERR, "iomon '%s' got %s", iomon->path,
@@ -716,6 +719,9 @@ EXIT:
 		mce_io_mon_unregister(iomon);
 	}
 
+	if( iomon )
+		mce_prof_leave();
+
 	// terminate process
 	if( terminate ) {
 		mce_log(LL_CRIT, "terminating due to error policy");
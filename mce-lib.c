@@ -406,3 +406,115 @@ int64_t mce_lib_get_real_tick(void)
 {
 	return mce_lib_get_tick(CLOCK_REALTIME);
 }
+
+/** Timeout source with expiry time aligned for shared wakeups */
+typedef struct {
+	/** Parent glib source, must be the first member */
+	GSource source;
+
+	/** Nominal timeout [ms] */
+	guint   interval;
+
+	/** How much later than nominal the timeout is allowed to fire [ms] */
+	guint   slack;
+} mce_slack_source_t;
+
+/** Calculate aligned expiry time for slack timeout
+ *
+ * The expiry time is rounded up to a multiple of the largest power
+ * of two milliseconds that fits within the allowed slack. Since the
+ * rounding is done against CLOCK_MONOTONIC origin, timeouts with
+ * similar slack end up expiring at the same time and can be served
+ * with a single wakeup.
+ *
+ * @param now       current time [us]
+ * @param interval  nominal timeout [ms]
+ * @param slack     allowed delay on top of interval [ms]
+ *
+ * @return expiry time [us]
+ */
+static gint64 mce_slack_source_expiry(gint64 now, guint interval,
+				      guint slack)
+{
+	gint64 expiry = now + interval * (gint64)1000;
+	gint64 grain  = 1;
+
+	while( grain * 2 <= slack )
+		grain *= 2;
+
+	if( grain > 1 ) {
+		grain *= 1000;
+		expiry = (expiry + grain - 1) / grain * grain;
+	}
+
+	return expiry;
+}
+
+/** Dispatch function for slack timeout sources
+ *
+ * @param source    slack timeout source
+ * @param callback  callback function
+ * @param user_data data to pass to callback function
+ *
+ * @return TRUE to keep the source alive, FALSE to remove it
+ */
+static gboolean mce_slack_source_dispatch(GSource *source,
+					  GSourceFunc callback,
+					  gpointer user_data)
+{
+	mce_slack_source_t *self = (mce_slack_source_t *)source;
+
+	if( !callback || !callback(user_data) )
+		return FALSE;
+
+	g_source_set_ready_time(source,
+				mce_slack_source_expiry(g_source_get_time(source),
+							self->interval,
+							self->slack));
+	return TRUE;
+}
+
+/** Glib source functions for slack timeout sources
+ *
+ * Expiry is handled via source ready time, so only dispatch
+ * function is needed.
+ */
+static GSourceFuncs mce_slack_source_funcs = {
+	.dispatch = mce_slack_source_dispatch,
+};
+
+/** Add timeout that is allowed to fire late
+ *
+ * Works like g_timeout_add(), but expiry is aligned so that timeouts
+ * with non-zero slack can share wakeups with each other.
+ *
+ * @param interval  nominal timeout [ms]
+ * @param slack     allowed delay on top of interval [ms]
+ * @param function  callback function
+ * @param data      data to pass to callback function
+ *
+ * @return glib source id
+ */
+guint mce_timeout_add_slack(guint interval, guint slack,
+			    GSourceFunc function, gpointer data)
+{
+	GSource            *source = 0;
+	mce_slack_source_t *self   = 0;
+	guint               id     = 0;
+
+	source = g_source_new(&mce_slack_source_funcs, sizeof *self);
+	self   = (mce_slack_source_t *)source;
+
+	self->interval = interval;
+	self->slack    = slack;
+
+	g_source_set_ready_time(source,
+				mce_slack_source_expiry(g_get_monotonic_time(),
+							interval, slack));
+	g_source_set_callback(source, function, data, 0);
+
+	id = g_source_attach(source, 0);
+	g_source_unref(source);
+
+	return id;
+}
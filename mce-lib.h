@@ -61,4 +61,7 @@ int64_t mce_lib_get_boot_tick(void);
 int64_t mce_lib_get_mono_tick(void);
 int64_t mce_lib_get_real_tick(void);
 
+guint mce_timeout_add_slack(guint interval, guint slack,
+			    GSourceFunc function, gpointer data);
+
 #endif /* _MCE_LIB_H_ */
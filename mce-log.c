@@ -308,6 +308,16 @@ EXIT:
 	return GPOINTER_TO_INT(hit) > 1;
 }
 
+/** Release memory used for caching function name pattern matches
+ *
+ * The cache is repopulated on demand.
+ */
+void mce_log_trim(void)
+{
+	if( mce_log_functions )
+		g_hash_table_remove_all(mce_log_functions);
+}
+
 /**
  * Log level testing predicate
  *
@@ -56,6 +56,7 @@ typedef enum {
 
 # ifdef OSSOLOG_COMPILE
 void mce_log_add_pattern(const char *pat);
+void mce_log_trim(void);
 void mce_log_set_verbosity(int verbosity);
 int  mce_log_get_verbosity(void);
 
@@ -85,6 +86,7 @@ void mce_log_close(void);
 # else
 /* Dummy versions used when logging is disabled at compile time */
 #  define mce_log_add_pattern(PAT_)             do {} while (0)
+#  define mce_log_trim()                        do {} while (0)
 #  define mce_log_set_verbosity(LEV_)           do {} while (0)
 #  define mce_log_open(NAME_, FACILITY_, TYPE_) do {} while (0)
 #  define mce_log_close()                       do {} while (0)
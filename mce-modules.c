@@ -24,117 +24,543 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-conf.h"
+#include "mce-prof.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include <gmodule.h>
 
 /** List of all loaded modules */
 static GSList *modules = NULL;
 
-/**
- * Dump information about mce modules to stdout
+#ifdef ENABLE_STATIC_MODULES
+/** List of all initialized statically linked modules */
+static GSList *static_modules = NULL;
+
+/** Initialize statically linked module
+ *
+ * @param module_name Name of the module
+ *
+ * @return TRUE if module is statically linked, FALSE otherwise
  */
-void mce_modules_dump_info(void)
+static gboolean mce_modules_load_static(const gchar *module_name)
 {
-	GModule *module;
-	gint i;
+	const mce_static_module_t *smod = NULL;
 
-	for (i = 0; (module = g_slist_nth_data(modules, i)) != NULL; i++) {
-		const gchar *modulename = g_module_name(module);
-		module_info_struct *modinfo;
-		gchar *tmp = NULL;
-		gpointer mip;
+	for (size_t i = 0; mce_static_modules[i].name; i++) {
+		if (!strcmp(mce_static_modules[i].name, module_name)) {
+			smod = &mce_static_modules[i];
+			break;
+		}
+	}
 
-		fprintf(stdout,
-			"\n"
-			"Module: %s\n", modulename);
-
-		if (g_module_symbol(module,
-				    "module_info",
-				    &mip) == FALSE) {
-			fprintf(stdout,
-				"        %-32s\n",
-				"module lacks information");
-			continue;
+	if (smod == NULL)
+		return FALSE;
+
+	mce_log(LL_INFO, "Initializing built-in module: %s", module_name);
+
+	const gchar *err = smod->check_init(NULL);
+
+	if (err == NULL) {
+		static_modules = g_slist_prepend(static_modules,
+						 (gpointer)smod);
+	} else {
+		mce_log(LL_ERR, "%s", err);
+		mce_log(LL_ERR,
+			"Failed to load module: %s; skipping",
+			module_name);
+	}
+
+	return TRUE;
+}
+#endif
+
+/* ========================================================================= *
+ * DEFERRED_INIT
+ * ========================================================================= */
+
+/** Delay for starting deferred module inits without display on [ms] */
+#define MCE_MODULES_DEFER_FALLBACK_MS 15000
+
+/** Bookkeeping data for module with deferred initialization */
+typedef struct
+{
+	/** Module name, for diagnostic logging */
+	gchar                 *name;
+
+	/** When the initialization should be done */
+	mce_module_startup_t   startup;
+
+	/** Service availability pipe for MCE_MODULE_STARTUP_ON_SERVICE */
+	datapipe_struct       *service_pipe;
+
+	/** Module initialization function */
+	const gchar         *(*init_cb)(void);
+
+	/** Module cleanup function, or NULL */
+	void                 (*quit_cb)(void);
+
+	/** Set when initialization has been attempted */
+	gboolean               attempted;
+} mce_modules_deferred_t;
+
+/** Registered modules, in registration order */
+static GSList *deferred_pending = NULL;
+
+/** Successfully initialized deferred modules, in reverse init order */
+static GSList *deferred_active = NULL;
+
+/** Set when display has been on, or fallback timeout has triggered */
+static gboolean deferred_display_seen = FALSE;
+
+/** Idle callback id for executing deferred inits */
+static guint deferred_idle_id = 0;
+
+/** Timer id for starting deferred inits without display on */
+static guint deferred_fallback_id = 0;
+
+/** Check if deferred module initialization should be done now
+ *
+ * @param self deferred module entry
+ *
+ * @return TRUE if init is due, FALSE otherwise
+ */
+static gboolean mce_modules_deferred_is_due(const mce_modules_deferred_t *self)
+{
+	gboolean due = FALSE;
+
+	if (self->attempted)
+		goto EXIT;
+
+	switch (self->startup) {
+	case MCE_MODULE_STARTUP_AFTER_DISPLAY:
+		due = deferred_display_seen;
+		break;
+
+	case MCE_MODULE_STARTUP_ON_SERVICE:
+		due = (datapipe_get_gint(*self->service_pipe) ==
+		       SERVICE_STATE_RUNNING);
+		break;
+
+	default:
+		due = TRUE;
+		break;
+	}
+
+EXIT:
+	return due;
+}
+
+/** Execute initialization of a deferred module
+ *
+ * @param self deferred module entry
+ */
+static void mce_modules_deferred_execute(mce_modules_deferred_t *self)
+{
+	self->attempted = TRUE;
+
+	mce_log(LL_INFO, "Initializing deferred module: %s", self->name);
+
+	const gchar *err = self->init_cb();
+
+	if (err == NULL) {
+		deferred_active = g_slist_prepend(deferred_active, self);
+	} else {
+		mce_log(LL_ERR, "%s", err);
+		mce_log(LL_ERR,
+			"Failed to initialize module: %s; skipping",
+			self->name);
+	}
+}
+
+/** Idle callback for executing deferred module inits
+ *
+ * Only one module is initialized per main loop iteration so that
+ * input events etc do not need to wait for all of them.
+ *
+ * @param aptr (unused)
+ *
+ * @return TRUE if there are more inits due, FALSE otherwise
+ */
+static gboolean mce_modules_deferred_idle_cb(gpointer aptr)
+{
+	(void)aptr;
+
+	if (!deferred_idle_id)
+		return FALSE;
+
+	/* Use registration order, i.e. the order in configuration */
+	for (GSList *item = deferred_pending; item; item = item->next) {
+		mce_modules_deferred_t *self = item->data;
+
+		if (mce_modules_deferred_is_due(self)) {
+			mce_modules_deferred_execute(self);
+			return TRUE;
 		}
+	}
 
-		modinfo = (module_info_struct *)mip;
+	deferred_idle_id = 0;
+	return FALSE;
+}
 
-		fprintf(stdout,
-			"        %-32s %s\n",
-			"name:",
-			modinfo->name ? modinfo->name : "<undefined>");
+/** Schedule execution of deferred module inits that are due
+ */
+static void mce_modules_deferred_schedule(void)
+{
+	if (deferred_idle_id)
+		goto EXIT;
+
+	for (GSList *item = deferred_pending; item; item = item->next) {
+		if (mce_modules_deferred_is_due(item->data)) {
+			deferred_idle_id =
+				g_idle_add(mce_modules_deferred_idle_cb, 0);
+			break;
+		}
+	}
 
-		if (modinfo->depends != NULL)
-			tmp = g_strjoinv(",", (gchar **)(modinfo->depends));
+EXIT:
+	return;
+}
 
-		fprintf(stdout,
-			"        %-32s %s\n",
-			"depends:",
-			tmp ? tmp : "");
+/** Start deferred module inits that are waiting for display
+ */
+static void mce_modules_deferred_display_seen(void)
+{
+	if (deferred_fallback_id) {
+		g_source_remove(deferred_fallback_id),
+			deferred_fallback_id = 0;
+	}
 
-		g_free(tmp);
-		tmp = NULL;
+	if (deferred_display_seen)
+		goto EXIT;
 
-		if (modinfo->recommends != NULL)
-			tmp = g_strjoinv(",", (gchar **)(modinfo->recommends));
+	deferred_display_seen = TRUE;
+	mce_modules_deferred_schedule();
 
-		fprintf(stdout,
-			"        %-32s %s\n",
-			"recommends:",
-			tmp ? tmp : "");
+EXIT:
+	return;
+}
 
-		g_free(tmp);
-		tmp = NULL;
+/** Timer callback for starting deferred inits without display on
+ *
+ * @param aptr (unused)
+ *
+ * @return FALSE to stop the timer from repeating
+ */
+static gboolean mce_modules_deferred_fallback_cb(gpointer aptr)
+{
+	(void)aptr;
 
-		if (modinfo->provides != NULL)
-			tmp = g_strjoinv(",", (gchar **)(modinfo->provides));
+	if (!deferred_fallback_id)
+		return FALSE;
 
-		fprintf(stdout,
-			"        %-32s %s\n",
-			"provides:",
-			tmp ? tmp : "");
+	deferred_fallback_id = 0;
 
-		g_free(tmp);
-		tmp = NULL;
+	if (!deferred_display_seen)
+		mce_log(LL_WARN, "display not turned on; "
+			"starting deferred module inits anyway");
 
-		if (modinfo->enhances != NULL)
-			tmp = g_strjoinv(",", (gchar **)(modinfo->enhances));
+	mce_modules_deferred_display_seen();
 
-		fprintf(stdout,
-			"        %-32s %s\n",
-			"enhances:",
-			tmp ? tmp : "");
+	return FALSE;
+}
 
-		g_free(tmp);
-		tmp = NULL;
+/** Datapipe trigger for display state
+ *
+ * @param data display state (as void pointer)
+ */
+static void mce_modules_deferred_display_state_cb(gconstpointer data)
+{
+	display_state_t display_state = GPOINTER_TO_INT(data);
 
-		if (modinfo->conflicts != NULL)
-			tmp = g_strjoinv(",", (gchar **)(modinfo->conflicts));
+	if (display_state == MCE_DISPLAY_ON)
+		mce_modules_deferred_display_seen();
+}
 
-		fprintf(stdout,
-			"        %-32s %s\n",
-			"conflicts:",
-			tmp ? tmp : "");
+/** Datapipe trigger for D-Bus service availability
+ *
+ * @param data service state (as void pointer)
+ */
+static void mce_modules_deferred_service_state_cb(gconstpointer data)
+{
+	service_state_t service_state = GPOINTER_TO_INT(data);
+
+	if (service_state == SERVICE_STATE_RUNNING)
+		mce_modules_deferred_schedule();
+}
+
+/** Check if some deferred module is already watching a service pipe
+ *
+ * @param service_pipe service availability datapipe
+ *
+ * @return TRUE if trigger has already been installed, FALSE otherwise
+ */
+static gboolean mce_modules_deferred_watching(datapipe_struct *service_pipe)
+{
+	for (GSList *item = deferred_pending; item; item = item->next) {
+		mce_modules_deferred_t *self = item->data;
+
+		if (self->startup == MCE_MODULE_STARTUP_ON_SERVICE &&
+		    self->service_pipe == service_pipe)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/** Register module for deferred initialization
+ *
+ * Meant to be called from g_module_check_init() of modules that
+ * are not needed during early bootup. For MCE_MODULE_STARTUP_CRITICAL
+ * the init function is called immediately.
+ *
+ * @param name         module name, for diagnostic logging
+ * @param startup      when the initialization should be done
+ * @param service_pipe service availability pipe for
+ *                     MCE_MODULE_STARTUP_ON_SERVICE, or NULL
+ * @param init_cb      module initialization function
+ * @param quit_cb      module cleanup function, or NULL
+ *
+ * @return NULL on success, a string with an error message on failure
+ */
+const gchar *mce_modules_defer(const char *name,
+			       mce_module_startup_t startup,
+			       datapipe_struct *service_pipe,
+			       const gchar *(*init_cb)(void),
+			       void (*quit_cb)(void))
+{
+	const gchar *err = NULL;
+	mce_modules_deferred_t *self = NULL;
+
+	if (startup == MCE_MODULE_STARTUP_ON_SERVICE && !service_pipe) {
+		mce_log(LL_WARN, "%s: service pipe not defined; "
+			"initializing after display", name);
+		startup = MCE_MODULE_STARTUP_AFTER_DISPLAY;
+	}
+
+	self = g_malloc0(sizeof *self);
+	self->name         = g_strdup(name);
+	self->startup      = startup;
+	self->service_pipe = service_pipe;
+	self->init_cb      = init_cb;
+	self->quit_cb      = quit_cb;
+
+	if (startup == MCE_MODULE_STARTUP_CRITICAL) {
+		/* Tracked for cleanup purposes only */
+		self->attempted = TRUE;
+		if ((err = init_cb()) == NULL)
+			deferred_active = g_slist_prepend(deferred_active, self);
+		goto EXIT;
+	}
+
+	mce_log(LL_DEBUG, "%s: initialization deferred", name);
+
+	if (startup == MCE_MODULE_STARTUP_ON_SERVICE &&
+	    !mce_modules_deferred_watching(service_pipe)) {
+		append_output_trigger_to_datapipe(service_pipe,
+						  mce_modules_deferred_service_state_cb);
+	}
+
+EXIT:
+	deferred_pending = g_slist_append(deferred_pending, self);
+	mce_modules_deferred_schedule();
+
+	return err;
+}
+
+/** Install triggers needed for scheduling deferred inits
+ */
+static void mce_modules_deferred_init(void)
+{
+	append_output_trigger_to_datapipe(&display_state_pipe,
+					  mce_modules_deferred_display_state_cb);
+}
+
+/** Start fallback timer after all modules have been loaded
+ */
+static void mce_modules_deferred_start(void)
+{
+	if (!deferred_pending || deferred_display_seen)
+		goto EXIT;
+
+	if (!deferred_fallback_id) {
+		deferred_fallback_id =
+			g_timeout_add(MCE_MODULES_DEFER_FALLBACK_MS,
+				      mce_modules_deferred_fallback_cb, 0);
+	}
+
+EXIT:
+	return;
+}
+
+/** Cleanup deferred modules and remove scheduling triggers
+ */
+static void mce_modules_deferred_quit(void)
+{
+	if (deferred_idle_id) {
+		g_source_remove(deferred_idle_id),
+			deferred_idle_id = 0;
+	}
+
+	if (deferred_fallback_id) {
+		g_source_remove(deferred_fallback_id),
+			deferred_fallback_id = 0;
+	}
+
+	remove_output_trigger_from_datapipe(&display_state_pipe,
+					    mce_modules_deferred_display_state_cb);
+
+	/* Cleanup initialized modules in reverse init order */
+	for (GSList *item = deferred_active; item; item = item->next) {
+		mce_modules_deferred_t *self = item->data;
+
+		mce_log(LL_DEBUG, "cleaning up deferred module: %s",
+			self->name);
+		if (self->quit_cb)
+			self->quit_cb();
+	}
+
+	g_slist_free(deferred_active),
+		deferred_active = NULL;
+
+	for (GSList *item = deferred_pending; item; item = item->next) {
+		mce_modules_deferred_t *self = item->data;
+
+		if (self->startup == MCE_MODULE_STARTUP_ON_SERVICE &&
+		    self->service_pipe) {
+			/* Removing non-existing trigger is harmless */
+			remove_output_trigger_from_datapipe(self->service_pipe,
+							    mce_modules_deferred_service_state_cb);
+		}
+		g_free(self->name);
+		g_free(self);
+	}
+
+	g_slist_free(deferred_pending),
+		deferred_pending = NULL;
+}
 
-		g_free(tmp);
-		tmp = NULL;
+/** Dump information about one mce module to stdout
+ *
+ * @param modulename name of the module
+ * @param modinfo    module information, or NULL
+ */
+static void mce_modules_dump_module_info(const gchar *modulename,
+					 const module_info_struct *modinfo)
+{
+	gchar *tmp = NULL;
 
-		if (modinfo->replaces != NULL)
-			tmp = g_strjoinv(",", (gchar **)(modinfo->replaces));
+	fprintf(stdout,
+		"\n"
+		"Module: %s\n", modulename);
 
+	if (modinfo == NULL) {
 		fprintf(stdout,
-			"        %-32s %s\n",
-			"replaces:",
-			tmp ? tmp : "");
+			"        %-32s\n",
+			"module lacks information");
+		return;
+	}
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"name:",
+		modinfo->name ? modinfo->name : "<undefined>");
+
+	if (modinfo->depends != NULL)
+		tmp = g_strjoinv(",", (gchar **)(modinfo->depends));
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"depends:",
+		tmp ? tmp : "");
+
+	g_free(tmp);
+	tmp = NULL;
+
+	if (modinfo->recommends != NULL)
+		tmp = g_strjoinv(",", (gchar **)(modinfo->recommends));
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"recommends:",
+		tmp ? tmp : "");
+
+	g_free(tmp);
+	tmp = NULL;
+
+	if (modinfo->provides != NULL)
+		tmp = g_strjoinv(",", (gchar **)(modinfo->provides));
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"provides:",
+		tmp ? tmp : "");
+
+	g_free(tmp);
+	tmp = NULL;
+
+	if (modinfo->enhances != NULL)
+		tmp = g_strjoinv(",", (gchar **)(modinfo->enhances));
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"enhances:",
+		tmp ? tmp : "");
+
+	g_free(tmp);
+	tmp = NULL;
+
+	if (modinfo->conflicts != NULL)
+		tmp = g_strjoinv(",", (gchar **)(modinfo->conflicts));
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"conflicts:",
+		tmp ? tmp : "");
+
+	g_free(tmp);
+	tmp = NULL;
+
+	if (modinfo->replaces != NULL)
+		tmp = g_strjoinv(",", (gchar **)(modinfo->replaces));
+
+	fprintf(stdout,
+		"        %-32s %s\n",
+		"replaces:",
+		tmp ? tmp : "");
+
+	g_free(tmp);
+
+	fprintf(stdout,	"        %-32s %d\n",
+		"priority:",
+		modinfo->priority);
+}
 
-		g_free(tmp);
+/**
+ * Dump information about mce modules to stdout
+ */
+void mce_modules_dump_info(void)
+{
+	GModule *module;
+	gint i;
+
+	for (i = 0; (module = g_slist_nth_data(modules, i)) != NULL; i++) {
+		gpointer mip = NULL;
+
+		if (g_module_symbol(module, "module_info", &mip) == FALSE)
+			mip = NULL;
+
+		mce_modules_dump_module_info(g_module_name(module), mip);
+	}
+
+#ifdef ENABLE_STATIC_MODULES
+	for (GSList *item = static_modules; item; item = item->next) {
+		const mce_static_module_t *smod = item->data;
 
-		fprintf(stdout,	"        %-32s %d\n",
-			"priority:",
-			modinfo->priority);
+		mce_modules_dump_module_info(smod->name, smod->info);
 	}
+#endif
 }
 
 /** Construct path for named mce plugin
@@ -171,12 +597,25 @@ gboolean mce_modules_init(void)
 					   MCE_CONF_MODULES_MODULES,
 					   &length);
 
+	/* Modules may defer their initialization while loading */
+	mce_modules_deferred_init();
+
 	if (modlist != NULL) {
 		gint i;
 
 		for (i = 0; modlist[i]; i++) {
 			GModule *module;
-			gchar *tmp = mce_modules_build_path(path, modlist[i]);
+			gchar *tmp;
+
+#ifdef ENABLE_STATIC_MODULES
+			/* Prefer modules linked into mce binary */
+			if (mce_modules_load_static(modlist[i])) {
+				mce_prof_startup_mark("module", modlist[i]);
+				continue;
+			}
+#endif
+
+			tmp = mce_modules_build_path(path, modlist[i]);
 
 			mce_log(LL_INFO,
 				"Loading module: %s from %s",
@@ -193,6 +632,9 @@ gboolean mce_modules_init(void)
 					modlist[i]);
 			}
 
+			/* Loading includes g_module_check_init() */
+			mce_prof_startup_mark("module", modlist[i]);
+
 			g_free(tmp);
 		}
 
@@ -201,6 +643,8 @@ gboolean mce_modules_init(void)
 
 	g_free(path);
 
+	mce_modules_deferred_start();
+
 	return TRUE;
 }
 
@@ -212,6 +656,9 @@ void mce_modules_exit(void)
 	GModule *module;
 	gint i;
 
+	/* Deferred cleanup functions live in the modules */
+	mce_modules_deferred_quit();
+
 	if (modules != NULL) {
 		for (i = 0; (module = g_slist_nth_data(modules, i)) != NULL; i++) {
 			if( mce_in_valgrind_mode() ) {
@@ -239,5 +686,17 @@ void mce_modules_exit(void)
 		modules = NULL;
 	}
 
+#ifdef ENABLE_STATIC_MODULES
+	for (GSList *item = static_modules; item; item = item->next) {
+		const mce_static_module_t *smod = item->data;
+
+		mce_log(LL_DEBUG, "unloading built-in module: %s", smod->name);
+		smod->unload(NULL);
+	}
+
+	g_slist_free(static_modules);
+	static_modules = NULL;
+#endif
+
 	return;
 }
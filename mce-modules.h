@@ -21,8 +21,16 @@
 #ifndef _MCE_MODULES_H_
 #define _MCE_MODULES_H_
 
+#include "datapipe.h"
+
 #include <glib.h>
 
+#ifdef ENABLE_STATIC_MODULES
+# include <gmodule.h>
+
+# include "mce.h"
+#endif
+
 /** Name of Modules configuration group */
 #define MCE_CONF_MODULES_GROUP		"Modules"
 
@@ -35,6 +43,54 @@
 /** Default value for module path */
 #define DEFAULT_MCE_MODULE_PATH		"/usr/lib/mce/modules"
 
+#ifdef ENABLE_STATIC_MODULES
+/** Plugin that has been linked into the mce binary
+ *
+ * The table of these is generated at build time, see Makefile.
+ */
+typedef struct
+{
+	/** Module name, as used in configuration */
+	const char          *name;
+
+	/** Renamed g_module_check_init() of the module */
+	const gchar       *(*check_init)(GModule *module);
+
+	/** Renamed g_module_unload() of the module */
+	void               (*unload)(GModule *module);
+
+	/** Renamed module_info of the module, or NULL */
+	module_info_struct  *info;
+} mce_static_module_t;
+
+/** Statically linked plugins; terminated by entry with NULL name */
+extern const mce_static_module_t mce_static_modules[];
+#endif
+
+/** Module startup classes
+ *
+ * Modules that are not needed for getting the display up at boot
+ * can use mce_modules_defer() from their g_module_check_init() to
+ * have the actual initialization done later on.
+ */
+typedef enum
+{
+	/** Initialize immediately while loading modules */
+	MCE_MODULE_STARTUP_CRITICAL,
+
+	/** Initialize from idle callback after display has been turned on */
+	MCE_MODULE_STARTUP_AFTER_DISPLAY,
+
+	/** Initialize when D-Bus service availability pipe says running */
+	MCE_MODULE_STARTUP_ON_SERVICE,
+} mce_module_startup_t;
+
+const gchar *mce_modules_defer(const char *name,
+			       mce_module_startup_t startup,
+			       datapipe_struct *service_pipe,
+			       const gchar *(*init_cb)(void),
+			       void (*quit_cb)(void));
+
 void mce_modules_dump_info(void);
 gboolean mce_modules_init(void);
 void mce_modules_exit(void);
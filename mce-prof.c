@@ -0,0 +1,1146 @@
+/**
+ * @file mce-prof.c
+ *
+ * Mode Control Entity - Main loop dispatch profiling
+ *
+ * Counts main loop wakeups and attributes them, together with cpu
+ * time, to named dispatch targets such as io monitors, D-Bus messages
+ * and timers. Profiling is disabled by default and can be started,
+ * stopped and queried over D-Bus.
+ *
+ * Additionally records wall clock duration of startup phases, which
+ * can be queried over D-Bus or collected over repeated startups for
+ * benchmarking purposes.
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mce-prof.h"
+
+#include "mce.h"
+#include "mce-log.h"
+#include "mce-lib.h"
+#include "mce-dbus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <sys/wait.h>
+
+#include <mce/dbus-names.h>
+
+#include <glib.h>
+
+/* ========================================================================= *
+ * Types and functions
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * PROFILE_ENTRY
+ * ------------------------------------------------------------------------- */
+
+/** Statistics for one named dispatch target */
+typedef struct
+{
+    /** Target name as "category:name", used also as lookup key */
+    char     *mpe_name;
+
+    /** Number of main loop wakeups caused by the target */
+    unsigned  mpe_wakeups;
+
+    /** Number of times the target was dispatched */
+    unsigned  mpe_dispatches;
+
+    /** Cpu time spent, excluding nested targets [us] */
+    int64_t   mpe_cpu_us;
+
+    /** Longest single dispatch, including nested targets [us] */
+    int64_t   mpe_max_us;
+} mpr_entry_t;
+
+static mpr_entry_t *mpr_entry_create     (const char *name);
+static void         mpr_entry_delete     (mpr_entry_t *self);
+static void         mpr_entry_delete_cb  (gpointer self);
+static gint         mpr_entry_compare_cb (gconstpointer a, gconstpointer b);
+
+/* ------------------------------------------------------------------------- *
+ * PROFILE_STATE
+ * ------------------------------------------------------------------------- */
+
+/** Maximum depth of tracked nested dispatches */
+#define MPR_STACK_DEPTH 16
+
+/** Book keeping for an ongoing dispatch */
+typedef struct
+{
+    /** Target being dispatched */
+    mpr_entry_t *mpf_entry;
+
+    /** Cpu time at dispatch start [us] */
+    int64_t      mpf_started;
+
+    /** Cpu time spent in nested dispatches [us] */
+    int64_t      mpf_nested;
+} mpr_frame_t;
+
+/** Flag for: profiling is active */
+static bool         mpr_enabled = false;
+
+/** Statistics lookup table; target name -> mpr_entry_t */
+static GHashTable  *mpr_entry_lut = 0;
+
+/** Stack of ongoing dispatches */
+static mpr_frame_t  mpr_stack[MPR_STACK_DEPTH];
+
+/** Number of ongoing dispatches; can exceed MPR_STACK_DEPTH */
+static int          mpr_depth = 0;
+
+/** Monotonic time when statistics were last cleared [ms] */
+static int64_t      mpr_started = 0;
+
+/** Monotonic time when profiling was stopped [ms], or 0 */
+static int64_t      mpr_stopped = 0;
+
+/** Number of main loop iterations */
+static unsigned     mpr_iterations = 0;
+
+/** Number of main loop wakeups */
+static unsigned     mpr_wakeups = 0;
+
+/** Flag for: wakeup has not been attributed to any target yet */
+static bool         mpr_wakeup_pending = false;
+
+/** Cpu time at the start of current main loop iteration [us] */
+static int64_t      mpr_iteration_started = 0;
+
+/** Cpu time attributed to named targets in current iteration [us] */
+static int64_t      mpr_iteration_attributed = 0;
+
+/** Total cpu time spent outside poll() [us] */
+static int64_t      mpr_busy_us = 0;
+
+/** Poll function that was in use before profiling was started */
+static GPollFunc    mpr_poll_prev = 0;
+
+static int64_t      mpr_get_cpu_time      (void);
+static mpr_entry_t *mpr_lookup_entry      (const char *category, const char *name);
+static void         mpr_iteration_end     (void);
+static gint         mpr_poll_cb           (GPollFD *ufds, guint nfsd, gint timeout_);
+static void         mpr_clear             (void);
+static void         mpr_start             (void);
+static void         mpr_stop              (void);
+static gchar       *mpr_report            (void);
+
+/* ------------------------------------------------------------------------- *
+ * EXTERNAL_API
+ * ------------------------------------------------------------------------- */
+
+void                mce_prof_enter        (const char *category, const char *name);
+void                mce_prof_leave        (void);
+
+/* ------------------------------------------------------------------------- *
+ * STARTUP_TIMELINE
+ * ------------------------------------------------------------------------- */
+
+/** Book keeping for one startup phase */
+typedef struct
+{
+    /** Phase name as "category:name" */
+    char     *mps_name;
+
+    /** Monotonic time at the start of the phase [us] */
+    int64_t   mps_begin;
+
+    /** Monotonic time at the end of the phase [us] */
+    int64_t   mps_end;
+} mpr_phase_t;
+
+/** Startup phases in order of completion; mpr_phase_t */
+static GArray      *mpr_startup_phases = 0;
+
+/** Monotonic time when startup began [us], or 0 */
+static int64_t      mpr_startup_began = 0;
+
+/** Monotonic time when previous startup phase ended [us] */
+static int64_t      mpr_startup_marked = 0;
+
+/** Monotonic time when startup was finished [us], or 0 */
+static int64_t      mpr_startup_ready = 0;
+
+static gchar       *mpr_startup_report    (void);
+static void         mpr_startup_clear     (void);
+
+void                mce_prof_startup_begin (void);
+void                mce_prof_startup_mark  (const char *category, const char *name);
+void                mce_prof_startup_finish(void);
+
+/* ------------------------------------------------------------------------- *
+ * STARTUP_BENCHMARK
+ * ------------------------------------------------------------------------- */
+
+/** Statistics for one startup phase over benchmark rounds */
+typedef struct
+{
+    /** Phase name as "category:name" */
+    char     *mpb_name;
+
+    /** Number of rounds the phase was seen in */
+    unsigned  mpb_count;
+
+    /** Shortest phase duration [us] */
+    int64_t   mpb_min;
+
+    /** Longest phase duration [us] */
+    int64_t   mpb_max;
+
+    /** Sum of phase durations [us] */
+    int64_t   mpb_sum;
+} mpr_bench_t;
+
+/** Pipe for passing timeline from benchmark round to driver, or -1 */
+static int          mpr_bench_fd = -1;
+
+static void         mpr_bench_write       (void);
+static bool         mpr_bench_collect     (int fd, GPtrArray *stats, GHashTable *lut);
+static void         mpr_bench_print       (GPtrArray *stats, int rounds, int failed);
+
+bool                mce_prof_startup_benchmark(int rounds, int *status);
+
+/* ------------------------------------------------------------------------- *
+ * DBUS_HANDLERS
+ * ------------------------------------------------------------------------- */
+
+static gboolean     mpr_dbus_start_cb     (DBusMessage *const req);
+static gboolean     mpr_dbus_stop_cb      (DBusMessage *const req);
+static gboolean     mpr_dbus_get_cb       (DBusMessage *const req);
+static gboolean     mpr_dbus_startup_cb   (DBusMessage *const req);
+
+/* ------------------------------------------------------------------------- *
+ * MODULE_INIT
+ * ------------------------------------------------------------------------- */
+
+void                mce_prof_init         (void);
+void                mce_prof_quit         (void);
+
+/* ========================================================================= *
+ * PROFILE_ENTRY
+ * ========================================================================= */
+
+/** Create dispatch target statistics object
+ *
+ * @param name target name
+ *
+ * @return statistics object
+ */
+static mpr_entry_t *
+mpr_entry_create(const char *name)
+{
+    mpr_entry_t *self = calloc(1, sizeof *self);
+
+    self->mpe_name       = strdup(name);
+    self->mpe_wakeups    = 0;
+    self->mpe_dispatches = 0;
+    self->mpe_cpu_us     = 0;
+    self->mpe_max_us     = 0;
+
+    return self;
+}
+
+/** Delete dispatch target statistics object
+ *
+ * @param self statistics object, or NULL
+ */
+static void
+mpr_entry_delete(mpr_entry_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    free(self->mpe_name);
+    free(self);
+
+EXIT:
+    return;
+}
+
+/** Type agnostic callback for deleting statistics objects
+ *
+ * @param self statistics object, or NULL
+ */
+static void
+mpr_entry_delete_cb(gpointer self)
+{
+    mpr_entry_delete(self);
+}
+
+/** Sort callback for ordering statistics by cpu time and wakeups
+ *
+ * @param a statistics object (as void pointer)
+ * @param b statistics object (as void pointer)
+ *
+ * @return negative if a should be listed before b, etc
+ */
+static gint
+mpr_entry_compare_cb(gconstpointer a, gconstpointer b)
+{
+    const mpr_entry_t *ea = a;
+    const mpr_entry_t *eb = b;
+
+    if( ea->mpe_cpu_us != eb->mpe_cpu_us )
+        return (ea->mpe_cpu_us < eb->mpe_cpu_us) ? 1 : -1;
+
+    if( ea->mpe_wakeups != eb->mpe_wakeups )
+        return (ea->mpe_wakeups < eb->mpe_wakeups) ? 1 : -1;
+
+    return strcmp(ea->mpe_name, eb->mpe_name);
+}
+
+/* ========================================================================= *
+ * PROFILE_STATE
+ * ========================================================================= */
+
+/** Get cpu time consumed by the main thread
+ *
+ * @return cpu time [us]
+ */
+static int64_t
+mpr_get_cpu_time(void)
+{
+    struct timespec ts = { 0, 0 };
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return ts.tv_sec * (int64_t)1000000 + ts.tv_nsec / 1000;
+}
+
+/** Find / create statistics object for a dispatch target
+ *
+ * @param category target category, such as "iomon" or "dbus"
+ * @param name     target name within the category
+ *
+ * @return statistics object
+ */
+static mpr_entry_t *
+mpr_lookup_entry(const char *category, const char *name)
+{
+    gchar       *key  = g_strdup_printf("%s:%s", category ?: "?", name ?: "?");
+    mpr_entry_t *self = g_hash_table_lookup(mpr_entry_lut, key);
+
+    if( !self ) {
+        self = mpr_entry_create(key);
+        g_hash_table_replace(mpr_entry_lut, self->mpe_name, self);
+    }
+
+    g_free(key);
+
+    return self;
+}
+
+/** Attribute cpu time not used by named targets in current iteration
+ *
+ * Work done by sources that are not explicitly profiled - plain
+ * glib timers, idle callbacks, etc - ends up here.
+ */
+static void
+mpr_iteration_end(void)
+{
+    int64_t busy  = mpr_get_cpu_time() - mpr_iteration_started;
+    int64_t other = busy - mpr_iteration_attributed;
+
+    mpr_busy_us += busy;
+
+    if( other > 0 || mpr_wakeup_pending ) {
+        mpr_entry_t *self = mpr_lookup_entry("mainloop", "other");
+
+        if( other > 0 )
+            self->mpe_cpu_us += other;
+
+        if( mpr_wakeup_pending )
+            self->mpe_wakeups += 1, mpr_wakeup_pending = false;
+    }
+
+    mpr_iteration_attributed = 0;
+}
+
+/** Main loop poll function wrapper for counting wakeups
+ *
+ * @param ufds     array of file descriptors to poll
+ * @param nfsd     number of file descriptors
+ * @param timeout_ poll timeout [ms], or -1 for infinite
+ *
+ * @return result from the original poll function
+ */
+static gint
+mpr_poll_cb(GPollFD *ufds, guint nfsd, gint timeout_)
+{
+    mpr_iteration_end();
+
+    gint rc = (mpr_poll_prev ?: g_poll)(ufds, nfsd, timeout_);
+
+    mpr_iteration_started = mpr_get_cpu_time();
+    mpr_iterations += 1;
+
+    /* Zero timeout means there was something to do already
+     * before polling i.e. mce was not really sleeping */
+    if( timeout_ != 0 ) {
+        mpr_wakeups += 1;
+        mpr_wakeup_pending = true;
+    }
+
+    return rc;
+}
+
+/** Clear collected statistics
+ */
+static void
+mpr_clear(void)
+{
+    /* Forget ongoing dispatches so that leave calls do
+     * not touch already deleted entries */
+    mpr_depth = 0;
+
+    if( mpr_entry_lut )
+        g_hash_table_remove_all(mpr_entry_lut);
+
+    mpr_started              = mce_lib_get_mono_tick();
+    mpr_stopped              = 0;
+    mpr_iterations           = 0;
+    mpr_wakeups              = 0;
+    mpr_wakeup_pending       = false;
+    mpr_iteration_started    = mpr_get_cpu_time();
+    mpr_iteration_attributed = 0;
+    mpr_busy_us              = 0;
+}
+
+/** Start / restart profiling
+ */
+static void
+mpr_start(void)
+{
+    if( !mpr_entry_lut )
+        goto EXIT;
+
+    mpr_clear();
+
+    if( !mpr_enabled ) {
+        mpr_enabled   = true;
+        mpr_poll_prev = g_main_context_get_poll_func(0);
+        g_main_context_set_poll_func(0, mpr_poll_cb);
+        mce_log(LL_DEVEL, "dispatch profiling started");
+    }
+
+EXIT:
+    return;
+}
+
+/** Stop profiling
+ */
+static void
+mpr_stop(void)
+{
+    if( !mpr_enabled )
+        goto EXIT;
+
+    mpr_enabled = false;
+    mpr_depth   = 0;
+    mpr_stopped = mce_lib_get_mono_tick();
+
+    g_main_context_set_poll_func(0, mpr_poll_prev);
+    mpr_poll_prev = 0;
+
+    mce_log(LL_DEVEL, "dispatch profiling stopped");
+
+EXIT:
+    return;
+}
+
+/** Generate human readable profiling report
+ *
+ * @return report text, caller must release with g_free()
+ */
+static gchar *
+mpr_report(void)
+{
+    GString *text = g_string_new(0);
+    GList   *list = 0;
+    int64_t  now  = mpr_stopped ?: mce_lib_get_mono_tick();
+
+    g_string_append_printf(text, "state:      %s\n",
+                           mpr_enabled ? "running" : "stopped");
+    g_string_append_printf(text, "duration:   %.3f s\n",
+                           mpr_started ? (now - mpr_started) * 1e-3 : 0.0);
+    g_string_append_printf(text, "iterations: %u\n", mpr_iterations);
+    g_string_append_printf(text, "wakeups:    %u\n", mpr_wakeups);
+    g_string_append_printf(text, "cpu time:   %.3f ms\n",
+                           mpr_busy_us * 1e-3);
+    g_string_append_printf(text, "\n%8s %10s %10s %10s  %s\n",
+                           "WAKEUPS", "DISPATCH", "CPU_MS", "MAX_MS",
+                           "TARGET");
+
+    if( mpr_entry_lut )
+        list = g_list_sort(g_hash_table_get_values(mpr_entry_lut),
+                           mpr_entry_compare_cb);
+
+    for( GList *item = list; item; item = item->next ) {
+        const mpr_entry_t *self = item->data;
+
+        g_string_append_printf(text, "%8u %10u %10.3f %10.3f  %s\n",
+                               self->mpe_wakeups,
+                               self->mpe_dispatches,
+                               self->mpe_cpu_us * 1e-3,
+                               self->mpe_max_us * 1e-3,
+                               self->mpe_name);
+    }
+
+    g_list_free(list);
+
+    return g_string_free(text, FALSE);
+}
+
+/* ========================================================================= *
+ * EXTERNAL_API
+ * ========================================================================= */
+
+/** Mark start of dispatching a named target
+ *
+ * Must be paired with mce_prof_leave(). Does nothing unless
+ * profiling has been started.
+ *
+ * @param category target category, such as "iomon" or "dbus"
+ * @param name     target name within the category
+ */
+void
+mce_prof_enter(const char *category, const char *name)
+{
+    if( !mpr_enabled )
+        goto EXIT;
+
+    if( mpr_depth++ >= MPR_STACK_DEPTH )
+        goto EXIT;
+
+    mpr_entry_t *entry = mpr_lookup_entry(category, name);
+    mpr_frame_t *frame = mpr_stack + mpr_depth - 1;
+
+    entry->mpe_dispatches += 1;
+
+    if( mpr_wakeup_pending )
+        entry->mpe_wakeups += 1, mpr_wakeup_pending = false;
+
+    frame->mpf_entry   = entry;
+    frame->mpf_nested  = 0;
+    frame->mpf_started = mpr_get_cpu_time();
+
+EXIT:
+    return;
+}
+
+/** Mark end of dispatching a named target
+ */
+void
+mce_prof_leave(void)
+{
+    if( !mpr_enabled || mpr_depth <= 0 )
+        goto EXIT;
+
+    if( --mpr_depth >= MPR_STACK_DEPTH )
+        goto EXIT;
+
+    mpr_frame_t *frame = mpr_stack + mpr_depth;
+    mpr_entry_t *entry = frame->mpf_entry;
+    int64_t      spent = mpr_get_cpu_time() - frame->mpf_started;
+
+    entry->mpe_cpu_us += spent - frame->mpf_nested;
+
+    if( entry->mpe_max_us < spent )
+        entry->mpe_max_us = spent;
+
+    if( mpr_depth > 0 )
+        mpr_stack[mpr_depth - 1].mpf_nested += spent;
+    else
+        mpr_iteration_attributed += spent;
+
+EXIT:
+    return;
+}
+
+/* ========================================================================= *
+ * STARTUP_TIMELINE
+ * ========================================================================= */
+
+/** Generate human readable startup timeline report
+ *
+ * @return report text, caller must release with g_free()
+ */
+static gchar *
+mpr_startup_report(void)
+{
+    GString *text = g_string_new(0);
+    guint    len  = mpr_startup_phases ? mpr_startup_phases->len : 0;
+
+    if( mpr_startup_ready )
+        g_string_append_printf(text, "ready:      %.3f ms\n",
+                               (mpr_startup_ready - mpr_startup_began) * 1e-3);
+    else
+        g_string_append_printf(text, "ready:      %s\n", "no");
+
+    g_string_append_printf(text, "\n%10s %10s  %s\n",
+                           "BEGIN_MS", "DURATION", "PHASE");
+
+    for( guint i = 0; i < len; ++i ) {
+        const mpr_phase_t *phase =
+            &g_array_index(mpr_startup_phases, mpr_phase_t, i);
+
+        g_string_append_printf(text, "%10.3f %10.3f  %s\n",
+                               (phase->mps_begin - mpr_startup_began) * 1e-3,
+                               (phase->mps_end - phase->mps_begin) * 1e-3,
+                               phase->mps_name);
+    }
+
+    return g_string_free(text, FALSE);
+}
+
+/** Release recorded startup phases
+ */
+static void
+mpr_startup_clear(void)
+{
+    if( !mpr_startup_phases )
+        goto EXIT;
+
+    for( guint i = 0; i < mpr_startup_phases->len; ++i )
+        g_free(g_array_index(mpr_startup_phases, mpr_phase_t, i).mps_name);
+
+    g_array_free(mpr_startup_phases, TRUE),
+        mpr_startup_phases = 0;
+
+EXIT:
+    return;
+}
+
+/** Mark start of mce startup
+ *
+ * Should be called as early as possible from main().
+ */
+void
+mce_prof_startup_begin(void)
+{
+    mpr_startup_clear();
+
+    mpr_startup_phases = g_array_new(FALSE, FALSE, sizeof (mpr_phase_t));
+    mpr_startup_began  = mpr_startup_marked = g_get_monotonic_time();
+    mpr_startup_ready  = 0;
+}
+
+/** Mark end of a startup phase
+ *
+ * The phase is assumed to have started when the previous phase ended.
+ * Does nothing unless startup tracking has been started via
+ * mce_prof_startup_begin() and not yet finished.
+ *
+ * @param category phase category, such as "init" or "module"
+ * @param name     phase name within the category
+ */
+void
+mce_prof_startup_mark(const char *category, const char *name)
+{
+    if( !mpr_startup_phases || mpr_startup_ready )
+        goto EXIT;
+
+    mpr_phase_t phase = {
+        .mps_name  = g_strdup_printf("%s:%s", category, name),
+        .mps_begin = mpr_startup_marked,
+        .mps_end   = g_get_monotonic_time(),
+    };
+
+    g_array_append_val(mpr_startup_phases, phase);
+    mpr_startup_marked = phase.mps_end;
+
+EXIT:
+    return;
+}
+
+/** Mark mce startup finished and log a summary
+ */
+void
+mce_prof_startup_finish(void)
+{
+    if( !mpr_startup_phases || mpr_startup_ready )
+        goto EXIT;
+
+    mpr_startup_ready = g_get_monotonic_time();
+
+    /* Report the slowest phase along with total startup time */
+    const mpr_phase_t *slowest = 0;
+
+    for( guint i = 0; i < mpr_startup_phases->len; ++i ) {
+        const mpr_phase_t *phase =
+            &g_array_index(mpr_startup_phases, mpr_phase_t, i);
+
+        if( !slowest ||
+            (slowest->mps_end - slowest->mps_begin) <
+            (phase->mps_end - phase->mps_begin) )
+            slowest = phase;
+    }
+
+    mce_log(LL_NOTICE, "startup finished in %.3f ms; %u phases; "
+            "slowest %s %.3f ms",
+            (mpr_startup_ready - mpr_startup_began) * 1e-3,
+            mpr_startup_phases->len,
+            slowest ? slowest->mps_name : "n/a",
+            slowest ? (slowest->mps_end - slowest->mps_begin) * 1e-3 : 0.0);
+
+    if( mce_log_p(LL_DEBUG) ) {
+        gchar *text = mpr_startup_report();
+        for( gchar *now = text, *zen; now && *now; now = zen ) {
+            if( (zen = strchr(now, '\n')) )
+                *zen++ = 0;
+            mce_log(LL_DEBUG, "%s", now);
+        }
+        g_free(text);
+    }
+
+    mpr_bench_write();
+
+EXIT:
+    return;
+}
+
+/* ========================================================================= *
+ * STARTUP_BENCHMARK
+ * ========================================================================= */
+
+/** Pass startup timeline to benchmark driver process
+ *
+ * One "name duration_us" line is written per phase, followed by
+ * total startup time using "ready" as name.
+ */
+static void
+mpr_bench_write(void)
+{
+    if( mpr_bench_fd == -1 )
+        goto EXIT;
+
+    GString *text = g_string_new(0);
+
+    for( guint i = 0; i < mpr_startup_phases->len; ++i ) {
+        const mpr_phase_t *phase =
+            &g_array_index(mpr_startup_phases, mpr_phase_t, i);
+
+        g_string_append_printf(text, "%s %"PRId64"\n", phase->mps_name,
+                               phase->mps_end - phase->mps_begin);
+    }
+
+    g_string_append_printf(text, "ready %"PRId64"\n",
+                           mpr_startup_ready - mpr_startup_began);
+
+    for( gsize done = 0; done < text->len; ) {
+        ssize_t rc = write(mpr_bench_fd, text->str + done, text->len - done);
+        if( rc == -1 && errno == EINTR )
+            continue;
+        if( rc <= 0 ) {
+            mce_log(LL_ERR, "benchmark pipe: write: %m");
+            break;
+        }
+        done += rc;
+    }
+
+    g_string_free(text, TRUE);
+
+    close(mpr_bench_fd), mpr_bench_fd = -1;
+
+EXIT:
+    return;
+}
+
+/** Read startup timeline of one benchmark round and update statistics
+ *
+ * @param fd    read end of benchmark pipe
+ * @param stats array of mpr_bench_t pointers, in order of first appearance
+ * @param lut   phase name -> mpr_bench_t lookup table
+ *
+ * @return true if the round finished startup, false otherwise
+ */
+static bool
+mpr_bench_collect(int fd, GPtrArray *stats, GHashTable *lut)
+{
+    bool     ready = false;
+    GString *text  = g_string_new(0);
+    char     buf[1024];
+
+    for( ;; ) {
+        ssize_t rc = read(fd, buf, sizeof buf);
+        if( rc == -1 && errno == EINTR )
+            continue;
+        if( rc <= 0 )
+            break;
+        g_string_append_len(text, buf, rc);
+    }
+
+    for( gchar *now = text->str, *zen; *now; now = zen ) {
+        if( (zen = strchr(now, '\n')) )
+            *zen++ = 0;
+        else
+            zen = now + strlen(now);
+
+        gchar *val = strrchr(now, ' ');
+        if( !val )
+            continue;
+        *val++ = 0;
+
+        int64_t us = strtoll(val, 0, 10);
+
+        mpr_bench_t *bench = g_hash_table_lookup(lut, now);
+
+        if( !bench ) {
+            bench = g_malloc0(sizeof *bench);
+            bench->mpb_name = g_strdup(now);
+            bench->mpb_min  = us;
+            bench->mpb_max  = us;
+            g_hash_table_replace(lut, bench->mpb_name, bench);
+            g_ptr_array_add(stats, bench);
+        }
+
+        bench->mpb_count += 1;
+        bench->mpb_sum   += us;
+
+        if( bench->mpb_min > us )
+            bench->mpb_min = us;
+
+        if( bench->mpb_max < us )
+            bench->mpb_max = us;
+
+        if( !strcmp(now, "ready") )
+            ready = true;
+    }
+
+    g_string_free(text, TRUE);
+
+    return ready;
+}
+
+/** Print per phase startup statistics to stdout
+ *
+ * @param stats  array of mpr_bench_t pointers
+ * @param rounds number of benchmark rounds executed
+ * @param failed number of rounds that did not finish startup
+ */
+static void
+mpr_bench_print(GPtrArray *stats, int rounds, int failed)
+{
+    printf("rounds: %d\n", rounds);
+    printf("failed: %d\n", failed);
+    printf("\n%5s %10s %10s %10s  %s\n",
+           "COUNT", "MIN_MS", "AVG_MS", "MAX_MS", "PHASE");
+
+    for( guint i = 0; i < stats->len; ++i ) {
+        const mpr_bench_t *bench = g_ptr_array_index(stats, i);
+
+        printf("%5u %10.3f %10.3f %10.3f  %s\n",
+               bench->mpb_count,
+               bench->mpb_min * 1e-3,
+               bench->mpb_sum * 1e-3 / bench->mpb_count,
+               bench->mpb_max * 1e-3,
+               bench->mpb_name);
+    }
+
+    fflush(stdout);
+}
+
+/** Repeat mce startup and collect per phase timing statistics
+ *
+ * Each round is executed in a child process that returns from this
+ * function with true and is expected to proceed with normal startup
+ * and then exit. The timeline of each round is passed back to the
+ * calling process via a pipe when mce_prof_startup_finish() is called.
+ *
+ * After all rounds the calling process prints out the statistics
+ * and returns false.
+ *
+ * @param rounds number of startups to make
+ * @param status where to store exit status for the calling process
+ *
+ * @return true in child processes, false in the calling process
+ */
+bool
+mce_prof_startup_benchmark(int rounds, int *status)
+{
+    GPtrArray  *stats  = g_ptr_array_new();
+    GHashTable *lut    = g_hash_table_new(g_str_hash, g_str_equal);
+    int         failed = 0;
+    int         round  = 0;
+
+    *status = EXIT_FAILURE;
+
+    for( round = 0; round < rounds; ++round ) {
+        int   fd[2] = { -1, -1 };
+        pid_t pid   = -1;
+        int   wst   = 0;
+
+        if( pipe(fd) == -1 ) {
+            mce_log(LL_ERR, "benchmark pipe: %m");
+            goto EXIT;
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+
+        if( (pid = fork()) == -1 ) {
+            mce_log(LL_ERR, "benchmark fork: %m");
+            close(fd[0]);
+            close(fd[1]);
+            goto EXIT;
+        }
+
+        if( pid == 0 ) {
+            /* Child: proceed with startup */
+            close(fd[0]);
+            mpr_bench_fd = fd[1];
+            g_hash_table_unref(lut);
+            g_ptr_array_free(stats, TRUE);
+            return true;
+        }
+
+        close(fd[1]);
+
+        if( !mpr_bench_collect(fd[0], stats, lut) )
+            ++failed;
+
+        close(fd[0]);
+
+        while( waitpid(pid, &wst, 0) == -1 && errno == EINTR ) {}
+
+        mce_log(LL_NOTICE, "benchmark round %d/%d finished",
+                round + 1, rounds);
+    }
+
+    mpr_bench_print(stats, rounds, failed);
+
+    *status = failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+EXIT:
+    for( guint i = 0; i < stats->len; ++i ) {
+        mpr_bench_t *bench = g_ptr_array_index(stats, i);
+        g_free(bench->mpb_name);
+        g_free(bench);
+    }
+
+    g_ptr_array_free(stats, TRUE);
+    g_hash_table_unref(lut);
+
+    return false;
+}
+
+/* ========================================================================= *
+ * DBUS_HANDLERS
+ * ========================================================================= */
+
+/** D-Bus callback for: start dispatch profiling method call
+ *
+ * @param req method call message
+ *
+ * @return TRUE
+ */
+static gboolean
+mpr_dbus_start_cb(DBusMessage *const req)
+{
+    mce_log(LL_DEVEL, "dispatch profile start request from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    mpr_start();
+
+    if( !dbus_message_get_no_reply(req) )
+        dbus_send_message(dbus_new_method_reply(req));
+
+    return TRUE;
+}
+
+/** D-Bus callback for: stop dispatch profiling method call
+ *
+ * @param req method call message
+ *
+ * @return TRUE
+ */
+static gboolean
+mpr_dbus_stop_cb(DBusMessage *const req)
+{
+    mce_log(LL_DEVEL, "dispatch profile stop request from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    mpr_stop();
+
+    if( !dbus_message_get_no_reply(req) )
+        dbus_send_message(dbus_new_method_reply(req));
+
+    return TRUE;
+}
+
+/** D-Bus callback for: get dispatch profiling report method call
+ *
+ * @param req method call message
+ *
+ * @return TRUE
+ */
+static gboolean
+mpr_dbus_get_cb(DBusMessage *const req)
+{
+    DBusMessage *rsp  = 0;
+    gchar       *text = 0;
+
+    mce_log(LL_DEBUG, "dispatch profile query from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    if( dbus_message_get_no_reply(req) )
+        goto EXIT;
+
+    text = mpr_report();
+    rsp  = dbus_new_method_reply(req);
+
+    if( !dbus_message_append_args(rsp,
+                                  DBUS_TYPE_STRING, &text,
+                                  DBUS_TYPE_INVALID) ) {
+        mce_log(LL_ERR, "Failed to append arguments");
+        goto EXIT;
+    }
+
+    dbus_send_message(rsp), rsp = 0;
+
+EXIT:
+    if( rsp )
+        dbus_message_unref(rsp);
+
+    g_free(text);
+
+    return TRUE;
+}
+
+/** D-Bus callback for: get startup timeline method call
+ *
+ * @param req method call message
+ *
+ * @return TRUE
+ */
+static gboolean
+mpr_dbus_startup_cb(DBusMessage *const req)
+{
+    DBusMessage *rsp  = 0;
+    gchar       *text = 0;
+
+    mce_log(LL_DEBUG, "startup timeline query from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    if( dbus_message_get_no_reply(req) )
+        goto EXIT;
+
+    text = mpr_startup_report();
+    rsp  = dbus_new_method_reply(req);
+
+    if( !dbus_message_append_args(rsp,
+                                  DBUS_TYPE_STRING, &text,
+                                  DBUS_TYPE_INVALID) ) {
+        mce_log(LL_ERR, "Failed to append arguments");
+        goto EXIT;
+    }
+
+    dbus_send_message(rsp), rsp = 0;
+
+EXIT:
+    if( rsp )
+        dbus_message_unref(rsp);
+
+    g_free(text);
+
+    return TRUE;
+}
+
+/** Array of dbus message handlers */
+static mce_dbus_handler_t mpr_dbus_handlers[] =
+{
+    /* method calls */
+    {
+        .interface  = MCE_REQUEST_IF,
+        .name       = MCE_DISPATCH_PROFILE_START,
+        .type       = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback   = mpr_dbus_start_cb,
+        .privileged = true,
+    },
+    {
+        .interface  = MCE_REQUEST_IF,
+        .name       = MCE_DISPATCH_PROFILE_STOP,
+        .type       = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback   = mpr_dbus_stop_cb,
+        .privileged = true,
+    },
+    {
+        .interface  = MCE_REQUEST_IF,
+        .name       = MCE_DISPATCH_PROFILE_GET,
+        .type       = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback   = mpr_dbus_get_cb,
+        .args       =
+            "    <arg direction=\"out\" name=\"report\" type=\"s\"/>\n"
+    },
+    {
+        .interface  = MCE_REQUEST_IF,
+        .name       = MCE_STARTUP_TIMELINE_GET,
+        .type       = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback   = mpr_dbus_startup_cb,
+        .args       =
+            "    <arg direction=\"out\" name=\"report\" type=\"s\"/>\n"
+    },
+    /* sentinel */
+    {
+        .interface = 0
+    }
+};
+
+/* ========================================================================= *
+ * MODULE_INIT
+ * ========================================================================= */
+
+/** Initialize dispatch profiling
+ *
+ * Profiling is not started, only the D-Bus interface is made available.
+ */
+void
+mce_prof_init(void)
+{
+    if( !mpr_entry_lut )
+        mpr_entry_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              0, mpr_entry_delete_cb);
+
+    mce_dbus_handler_register_array(mpr_dbus_handlers);
+}
+
+/** Stop dispatch profiling and release all dynamic resources
+ */
+void
+mce_prof_quit(void)
+{
+    mce_dbus_handler_unregister_array(mpr_dbus_handlers);
+
+    mpr_stop();
+
+    if( mpr_entry_lut ) {
+        g_hash_table_unref(mpr_entry_lut),
+            mpr_entry_lut = 0;
+    }
+
+    mpr_startup_clear();
+
+    if( mpr_bench_fd != -1 )
+        close(mpr_bench_fd), mpr_bench_fd = -1;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file mce-prof.h
+ *
+ * Mode Control Entity - Main loop dispatch profiling
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCE_PROF_H_
+# define MCE_PROF_H_
+
+# include <stdbool.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/* ========================================================================= *
+ * D-Bus interface
+ * ========================================================================= */
+
+/** Start / restart dispatch profiling; clears collected statistics
+ *
+ * Defined here until it becomes available in mce-dev
+ */
+# ifndef MCE_DISPATCH_PROFILE_START
+#  define MCE_DISPATCH_PROFILE_START "dispatch_profile_start"
+# endif
+
+/** Stop dispatch profiling; collected statistics are retained
+ *
+ * Defined here until it becomes available in mce-dev
+ */
+# ifndef MCE_DISPATCH_PROFILE_STOP
+#  define MCE_DISPATCH_PROFILE_STOP  "dispatch_profile_stop"
+# endif
+
+/** Get dispatch profiling report as human readable text
+ *
+ * Defined here until it becomes available in mce-dev
+ */
+# ifndef MCE_DISPATCH_PROFILE_GET
+#  define MCE_DISPATCH_PROFILE_GET   "dispatch_profile_get"
+# endif
+
+/** Get startup timeline report as human readable text
+ *
+ * Defined here until it becomes available in mce-dev
+ */
+# ifndef MCE_STARTUP_TIMELINE_GET
+#  define MCE_STARTUP_TIMELINE_GET   "startup_timeline_get"
+# endif
+
+/* ========================================================================= *
+ * Functions
+ * ========================================================================= */
+
+void mce_prof_enter            (const char *category, const char *name);
+void mce_prof_leave            (void);
+
+void mce_prof_startup_begin    (void);
+void mce_prof_startup_mark     (const char *category, const char *name);
+void mce_prof_startup_finish   (void);
+bool mce_prof_startup_benchmark(int rounds, int *status);
+
+void mce_prof_init             (void);
+void mce_prof_quit             (void);
+
+# ifdef __cplusplus
+};
+# endif
+
+#endif /* MCE_PROF_H_ */
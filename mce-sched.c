@@ -0,0 +1,551 @@
+/**
+ * @file mce-sched.c
+ *
+ * Mode Control Entity - Reference counted scheduling priority boosts
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mce-sched.h"
+
+#include "mce.h"
+#include "mce-log.h"
+#include "mce-conf.h"
+
+#include <sys/resource.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+
+#include <glib.h>
+
+/* ========================================================================= *
+ * Types and functions
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * BOOST_CLIENT
+ * ------------------------------------------------------------------------- */
+
+/** Book keeping data for a priority boost holder */
+typedef struct
+{
+    /** Client name, used also as lookup key */
+    char  *msc_name;
+
+    /** Timer id for automatic expiry */
+    guint  msc_expire_id;
+} msb_client_t;
+
+static msb_client_t *msb_client_create       (const char *name);
+static void          msb_client_delete       (msb_client_t *self);
+static void          msb_client_delete_cb    (gpointer self);
+static gboolean      msb_client_expire_cb    (gpointer aptr);
+static void          msb_client_set_timeout  (msb_client_t *self, int timeout_ms);
+
+/* ------------------------------------------------------------------------- *
+ * SCHEDULING_PARAMETERS
+ * ------------------------------------------------------------------------- */
+
+/** Scheduling parameters that can be changed while boosted */
+typedef struct
+{
+    /** Scheduling policy, or -1 if not known */
+    int       msp_policy;
+
+    /** Real time priority */
+    int       msp_priority;
+
+    /** Nice value, or INT_MAX if not to be changed */
+    int       msp_nice;
+
+    /** Whether msp_cpuset is in use */
+    bool      msp_cpuset_used;
+
+    /** Cpu affinity mask */
+    cpu_set_t msp_cpuset;
+} msb_params_t;
+
+static void          msb_params_save         (msb_params_t *self);
+static void          msb_params_apply        (const msb_params_t *self, bool enable);
+
+/* ------------------------------------------------------------------------- *
+ * BOOST_STATE
+ * ------------------------------------------------------------------------- */
+
+/** Active boost holders; client name -> msb_client_t */
+static GHashTable   *msb_client_lut = 0;
+
+/** Scheduling parameters to use while boosted */
+static msb_params_t  msb_boost_params;
+
+/** Scheduling parameters in effect before boosting */
+static msb_params_t  msb_normal_params;
+
+/** Whether boosted scheduling parameters are in use */
+static bool          msb_boost_active = false;
+
+/** Upper limit for boost duration [ms] */
+static int           msb_max_duration = MCE_SCHED_BOOST_MAX_DURATION_DEFAULT;
+
+static void          msb_boost_rethink       (void);
+
+/* ------------------------------------------------------------------------- *
+ * EXTERNAL_API
+ * ------------------------------------------------------------------------- */
+
+void                 mce_sched_boost_start   (const char *client, int timeout_ms);
+void                 mce_sched_boost_stop    (const char *client);
+bool                 mce_sched_boost_is_active(void);
+
+/* ------------------------------------------------------------------------- *
+ * MODULE_INIT
+ * ------------------------------------------------------------------------- */
+
+/** Flag for: boosts can be started */
+static bool          mce_sched_ready = false;
+
+static int           msb_config_parse_policy (const char *name);
+static void          msb_config_load         (void);
+
+void                 mce_sched_init          (void);
+void                 mce_sched_quit          (void);
+
+/* ========================================================================= *
+ * BOOST_CLIENT
+ * ========================================================================= */
+
+/** Create boost client book keeping object
+ *
+ * @param name client name
+ *
+ * @return boost client object
+ */
+static msb_client_t *
+msb_client_create(const char *name)
+{
+    msb_client_t *self = calloc(1, sizeof *self);
+
+    self->msc_name      = strdup(name);
+    self->msc_expire_id = 0;
+
+    return self;
+}
+
+/** Delete boost client book keeping object
+ *
+ * @param self boost client object, or NULL
+ */
+static void
+msb_client_delete(msb_client_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    if( self->msc_expire_id ) {
+        g_source_remove(self->msc_expire_id),
+            self->msc_expire_id = 0;
+    }
+
+    free(self->msc_name);
+    free(self);
+
+EXIT:
+    return;
+}
+
+/** Type agnostic callback for deleting boost client objects
+ *
+ * @param self boost client object, or NULL
+ */
+static void
+msb_client_delete_cb(gpointer self)
+{
+    msb_client_delete(self);
+}
+
+/** Timer callback for automatically ending a priority boost
+ *
+ * @param aptr boost client object (as void pointer)
+ *
+ * @return FALSE to stop the timer from repeating
+ */
+static gboolean
+msb_client_expire_cb(gpointer aptr)
+{
+    msb_client_t *self = aptr;
+
+    if( !self->msc_expire_id )
+        goto EXIT;
+
+    self->msc_expire_id = 0;
+
+    mce_log(LL_DEBUG, "boost expired: %s", self->msc_name);
+
+    /* Note: removal from lookup table deletes self too */
+    if( msb_client_lut )
+        g_hash_table_remove(msb_client_lut, self->msc_name);
+
+    msb_boost_rethink();
+
+EXIT:
+    return FALSE;
+}
+
+/** (Re)start automatic expiry timer for boost client
+ *
+ * @param self       boost client object
+ * @param timeout_ms expiry delay [ms]
+ */
+static void
+msb_client_set_timeout(msb_client_t *self, int timeout_ms)
+{
+    if( self->msc_expire_id )
+        g_source_remove(self->msc_expire_id);
+
+    self->msc_expire_id = g_timeout_add(timeout_ms,
+                                        msb_client_expire_cb, self);
+}
+
+/* ========================================================================= *
+ * SCHEDULING_PARAMETERS
+ * ========================================================================= */
+
+/** Cache current scheduling parameters
+ *
+ * @param self scheduling parameters object to fill in
+ */
+static void
+msb_params_save(msb_params_t *self)
+{
+    struct sched_param param;
+    memset(&param, 0, sizeof param);
+
+    self->msp_policy      = -1;
+    self->msp_priority    = 0;
+    self->msp_nice        = INT_MAX;
+    self->msp_cpuset_used = false;
+
+    int policy = sched_getscheduler(0);
+
+    if( policy == -1 )
+        mce_log(LL_WARN, "sched_getscheduler: %m");
+    else if( sched_getparam(0, &param) == -1 )
+        mce_log(LL_WARN, "sched_getparam: %m");
+    else {
+        self->msp_policy   = policy;
+        self->msp_priority = param.sched_priority;
+    }
+
+    /* Nice values are needed only if they are going to be changed */
+    if( msb_boost_params.msp_nice != INT_MAX ) {
+        errno = 0;
+        int nice = getpriority(PRIO_PROCESS, 0);
+        if( nice == -1 && errno != 0 )
+            mce_log(LL_WARN, "getpriority: %m");
+        else
+            self->msp_nice = nice;
+    }
+
+    /* As are cpu affinity masks */
+    if( msb_boost_params.msp_cpuset_used ) {
+        CPU_ZERO(&self->msp_cpuset);
+        if( sched_getaffinity(0, sizeof self->msp_cpuset,
+                              &self->msp_cpuset) == -1 )
+            mce_log(LL_WARN, "sched_getaffinity: %m");
+        else
+            self->msp_cpuset_used = true;
+    }
+}
+
+/** Apply scheduling parameters
+ *
+ * @param self   scheduling parameters object
+ * @param enable true when entering boosted mode, false when leaving it
+ */
+static void
+msb_params_apply(const msb_params_t *self, bool enable)
+{
+    /* Warn once per direction, then be quiet */
+    static bool warned[2] = { false, false };
+
+    bool failed = false;
+
+    if( self->msp_policy != -1 ) {
+        struct sched_param param;
+        memset(&param, 0, sizeof param);
+        param.sched_priority = self->msp_priority;
+
+        mce_log(LL_DEBUG, "sched=%d, prio=%d",
+                self->msp_policy, self->msp_priority);
+
+        if( sched_setscheduler(0, self->msp_policy, &param) == -1 ) {
+            failed = true;
+            if( !warned[enable] )
+                mce_log(LL_WARN, "sched_setscheduler: %m");
+        }
+    }
+
+    if( self->msp_nice != INT_MAX ) {
+        mce_log(LL_DEBUG, "nice=%d", self->msp_nice);
+
+        if( setpriority(PRIO_PROCESS, 0, self->msp_nice) == -1 ) {
+            failed = true;
+            if( !warned[enable] )
+                mce_log(LL_WARN, "setpriority: %m");
+        }
+    }
+
+    if( self->msp_cpuset_used ) {
+        mce_log(LL_DEBUG, "cpus=%d", CPU_COUNT(&self->msp_cpuset));
+
+        if( sched_setaffinity(0, sizeof self->msp_cpuset,
+                              &self->msp_cpuset) == -1 ) {
+            failed = true;
+            if( !warned[enable] )
+                mce_log(LL_WARN, "sched_setaffinity: %m");
+        }
+    }
+
+    if( failed && !warned[enable] ) {
+        warned[enable] = true;
+        mce_log(LL_WARN, "can't %s high priority mode",
+                enable ? "enter" : "leave");
+    }
+}
+
+/* ========================================================================= *
+ * BOOST_STATE
+ * ========================================================================= */
+
+/** Enter / leave boosted mode based on number of boost holders
+ */
+static void
+msb_boost_rethink(void)
+{
+    bool want_boost = (mce_sched_ready && msb_client_lut &&
+                       g_hash_table_size(msb_client_lut) > 0);
+
+    if( msb_boost_active == want_boost )
+        goto EXIT;
+
+    if( (msb_boost_active = want_boost) ) {
+        mce_log(LL_DEBUG, "enter high priority mode");
+        msb_params_save(&msb_normal_params);
+        msb_params_apply(&msb_boost_params, true);
+    }
+    else {
+        mce_log(LL_DEBUG, "leave high priority mode");
+        msb_params_apply(&msb_normal_params, false);
+    }
+
+    /* The logical change is made even if we fail to actually change
+     * the scheduling parameters */
+
+EXIT:
+    return;
+}
+
+/* ========================================================================= *
+ * EXTERNAL_API
+ * ========================================================================= */
+
+/** Acquire / renew scheduling priority boost
+ *
+ * The boost is held until mce_sched_boost_stop() is called with the
+ * same client name or timeout_ms milliseconds have passed - whichever
+ * happens first. To avoid starving other processes, the timeout is
+ * capped at configured maximum duration also when the caller does
+ * not specify one.
+ *
+ * @param client     name of the boost holder
+ * @param timeout_ms automatic expiry delay [ms], or <= 0 for maximum
+ */
+void
+mce_sched_boost_start(const char *client, int timeout_ms)
+{
+    if( !mce_sched_ready || !client )
+        goto EXIT;
+
+    if( timeout_ms <= 0 || timeout_ms > msb_max_duration )
+        timeout_ms = msb_max_duration;
+
+    msb_client_t *self = g_hash_table_lookup(msb_client_lut, client);
+
+    if( !self ) {
+        mce_log(LL_DEBUG, "boost start: %s", client);
+        self = msb_client_create(client);
+        g_hash_table_replace(msb_client_lut, self->msc_name, self);
+    }
+
+    msb_client_set_timeout(self, timeout_ms);
+
+    msb_boost_rethink();
+
+EXIT:
+    return;
+}
+
+/** Release scheduling priority boost
+ *
+ * @param client name of the boost holder
+ */
+void
+mce_sched_boost_stop(const char *client)
+{
+    if( !msb_client_lut || !client )
+        goto EXIT;
+
+    if( g_hash_table_remove(msb_client_lut, client) )
+        mce_log(LL_DEBUG, "boost stop: %s", client);
+
+    msb_boost_rethink();
+
+EXIT:
+    return;
+}
+
+/** Predicate for: scheduling priority boost is in effect
+ *
+ * @return true if boosted, false otherwise
+ */
+bool
+mce_sched_boost_is_active(void)
+{
+    return msb_boost_active;
+}
+
+/* ========================================================================= *
+ * MODULE_INIT
+ * ========================================================================= */
+
+/** Map scheduling policy name to policy id
+ *
+ * @param name fifo, rr or other
+ *
+ * @return policy id, or -1 if policy is not to be changed
+ */
+static int
+msb_config_parse_policy(const char *name)
+{
+    int policy = SCHED_FIFO;
+
+    if( !name || !*name )
+        goto EXIT;
+
+    if( !strcmp(name, "fifo") )
+        policy = SCHED_FIFO;
+    else if( !strcmp(name, "rr") )
+        policy = SCHED_RR;
+    else if( !strcmp(name, "other") )
+        policy = SCHED_OTHER;
+    else if( !strcmp(name, "none") )
+        policy = -1;
+    else
+        mce_log(LL_WARN, "unknown scheduling policy '%s'; using fifo", name);
+
+EXIT:
+    return policy;
+}
+
+/** Load boost parameters from static configuration
+ */
+static void
+msb_config_load(void)
+{
+    gchar  *policy = 0;
+    gint   *cpus   = 0;
+    gsize   count  = 0;
+
+    msb_params_t *params = &msb_boost_params;
+
+    policy = mce_conf_get_string(MCE_CONF_SCHED_BOOST_GROUP,
+                                 MCE_CONF_SCHED_BOOST_POLICY, 0);
+    params->msp_policy = msb_config_parse_policy(policy);
+
+    /* Default to medium priority within the range of the policy */
+    params->msp_priority = 0;
+    if( params->msp_policy == SCHED_FIFO ||
+        params->msp_policy == SCHED_RR ) {
+        int lo = sched_get_priority_min(params->msp_policy);
+        int hi = sched_get_priority_max(params->msp_policy);
+        int pr = mce_conf_get_int(MCE_CONF_SCHED_BOOST_GROUP,
+                                  MCE_CONF_SCHED_BOOST_PRIORITY, -1);
+        if( pr < lo || pr > hi )
+            pr = (lo + hi) / 2;
+        params->msp_priority = pr;
+    }
+
+    params->msp_nice = mce_conf_get_int(MCE_CONF_SCHED_BOOST_GROUP,
+                                        MCE_CONF_SCHED_BOOST_NICE, INT_MAX);
+    if( params->msp_nice < -20 || params->msp_nice > 19 )
+        params->msp_nice = INT_MAX;
+
+    CPU_ZERO(&params->msp_cpuset);
+    params->msp_cpuset_used = false;
+
+    cpus = mce_conf_get_int_list(MCE_CONF_SCHED_BOOST_GROUP,
+                                 MCE_CONF_SCHED_BOOST_CPUSET, &count);
+    for( gsize i = 0; cpus && i < count; ++i ) {
+        if( cpus[i] < 0 || cpus[i] >= CPU_SETSIZE )
+            continue;
+        CPU_SET(cpus[i], &params->msp_cpuset);
+        params->msp_cpuset_used = true;
+    }
+
+    msb_max_duration = mce_conf_get_int(MCE_CONF_SCHED_BOOST_GROUP,
+                                        MCE_CONF_SCHED_BOOST_MAX_DURATION,
+                                        MCE_SCHED_BOOST_MAX_DURATION_DEFAULT);
+    if( msb_max_duration <= 0 )
+        msb_max_duration = MCE_SCHED_BOOST_MAX_DURATION_DEFAULT;
+
+    mce_log(LL_DEBUG, "policy=%d prio=%d nice=%d cpus=%d max=%d",
+            params->msp_policy, params->msp_priority, params->msp_nice,
+            CPU_COUNT(&params->msp_cpuset), msb_max_duration);
+
+    g_free(cpus);
+    g_free(policy);
+}
+
+/** Initialize scheduling priority boost tracking
+ */
+void
+mce_sched_init(void)
+{
+    msb_config_load();
+
+    if( !msb_client_lut )
+        msb_client_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               0, msb_client_delete_cb);
+
+    mce_sched_ready = true;
+}
+
+/** Release all boosts and restore normal scheduling parameters
+ */
+void
+mce_sched_quit(void)
+{
+    /* Deny starting of boosts */
+    mce_sched_ready = false;
+
+    if( msb_client_lut ) {
+        g_hash_table_unref(msb_client_lut),
+            msb_client_lut = 0;
+    }
+
+    msb_boost_rethink();
+}
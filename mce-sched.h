@@ -0,0 +1,68 @@
+/**
+ * @file mce-sched.h
+ *
+ * Mode Control Entity - Reference counted scheduling priority boosts
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCE_SCHED_H_
+# define MCE_SCHED_H_
+
+# include <stdbool.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/* ========================================================================= *
+ * Configuration
+ * ========================================================================= */
+
+/** Name of the scheduling boost configuration group */
+# define MCE_CONF_SCHED_BOOST_GROUP             "SchedBoost"
+
+/** Scheduling policy to use while boosted: fifo, rr or other */
+# define MCE_CONF_SCHED_BOOST_POLICY            "Policy"
+
+/** Real time priority to use with fifo / rr policy; -1 = use medium */
+# define MCE_CONF_SCHED_BOOST_PRIORITY          "Priority"
+
+/** Nice value to use while boosted; values above 19 = leave as is */
+# define MCE_CONF_SCHED_BOOST_NICE              "Nice"
+
+/** List of cpus to pin mce to while boosted; empty = leave as is */
+# define MCE_CONF_SCHED_BOOST_CPUSET            "CpuSet"
+
+/** Upper limit for boost duration [ms] */
+# define MCE_CONF_SCHED_BOOST_MAX_DURATION      "MaxDuration"
+
+/** Default boost duration limit, used also as a fallback timeout */
+# define MCE_SCHED_BOOST_MAX_DURATION_DEFAULT   5000
+
+/* ========================================================================= *
+ * Functions
+ * ========================================================================= */
+
+void mce_sched_boost_start    (const char *client, int timeout_ms);
+void mce_sched_boost_stop     (const char *client);
+bool mce_sched_boost_is_active(void);
+
+void mce_sched_init           (void);
+void mce_sched_quit           (void);
+
+# ifdef __cplusplus
+};
+# endif
+
+#endif /* MCE_SCHED_H_ */
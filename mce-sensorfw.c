@@ -27,6 +27,7 @@
 #include "mce-sensorfw.h"
 
 #include "mce.h"
+#include "mce-lib.h"
 #include "mce-log.h"
 #include "mce-dbus.h"
 #include "libwakelock.h"
@@ -35,6 +36,7 @@
 #include <linux/input.h>
 
 #include <sys/socket.h>
+#include <sys/ioctl.h>
 #include <sys/un.h>
 
 #include <stdio.h>
@@ -272,6 +274,13 @@
 /** Connect path to sensord data unix domain socket  */
 #define SENSORFW_DATA_SOCKET                   "/var/run/sensord.sock"
 
+/** Minimum size and allocation granularity of sensord data connection
+ *  receive buffer */
+#define SENSORFW_RX_BUFFER_SIZE                4096
+
+/** Maximum age of wrist gesture sample that still wakes up the display */
+#define SENSORFW_WRIST_MAX_AGE_MS              2000
+
 // ----------------------------------------------------------------
 
 /** Name of proximity sensor */
@@ -377,6 +386,10 @@ typedef void (*sfw_sample_fn)(sfw_plugin_t *plugin, const void *sample);
 /** Callback function type: value reset reporting */
 typedef void (*sfw_reset_fn)(sfw_plugin_t *plugin);
 
+/** Callback function type: timestamped sample array reporting */
+typedef void (*sfw_batch_fn)(sfw_plugin_t *plugin, const void *samples,
+                             size_t count);
+
 /** Sensor specific data and callbacks */
 struct sfw_backend_t
 {
@@ -395,6 +408,10 @@ struct sfw_backend_t
     /** Callback for handling sensor data blob */
     sfw_sample_fn be_sample_cb;
 
+    /** Callback for handling all data blobs received in one packet,
+     *  or NULL to pass them one by one to be_sample_cb */
+    sfw_batch_fn  be_batch_cb;
+
     /** D-Bus method name for querying the initial sensor value */
     const char   *be_value_method;
 
@@ -612,6 +629,12 @@ struct sfw_connection_t
 
     /** Timer for: Retry after ipc error */
     guint                   con_retry_id;
+
+    /** Receive buffer, reused for all data packets */
+    char                   *con_rx_buf;
+
+    /** Allocated size of the receive buffer */
+    size_t                  con_rx_size;
 };
 
 static const char       *sfw_connection_state_name      (sfw_connection_state_t state);
@@ -620,6 +643,7 @@ static sfw_connection_t *sfw_connection_create          (sfw_plugin_t *plugin);
 static void              sfw_connection_delete          (sfw_connection_t *self);
 
 static bool              sfw_connection_handle_samples  (sfw_connection_t *self, char *data, size_t size);
+static bool              sfw_connection_reserve_rx      (sfw_connection_t *self, size_t size);
 
 static int               sfw_connection_get_session_id  (const sfw_connection_t *self);
 
@@ -782,6 +806,7 @@ static int               sfw_plugin_get_session_id      (const sfw_plugin_t *sel
 static const char       *sfw_plugin_get_value_method    (const sfw_plugin_t *self);
 static size_t            sfw_plugin_get_sample_size     (const sfw_plugin_t *self);
 static void              sfw_plugin_handle_sample       (sfw_plugin_t *self, const void *sample);
+static void              sfw_plugin_handle_batch        (sfw_plugin_t *self, const void *samples, size_t count);
 static void              sfw_plugin_handle_value        (sfw_plugin_t *self, unsigned value);
 static void              sfw_plugin_reset_value         (sfw_plugin_t *self);
 static void              sfw_plugin_restore_value       (sfw_plugin_t *self);
@@ -1005,18 +1030,44 @@ sfw_backend_orient_sample_cb(sfw_plugin_t *plugin, const void *sample)
     sfw_notify_orient(NOTIFY_SENSORD, self->orient_state);
 }
 
-/** Callback for handling orientation events from sensord */
+/** Callback for handling wrist gesture events from sensord
+ *
+ * Every gesture wakes up the display, so only the most recent one
+ * in a batch is acted on - and only if it was detected recently
+ * enough to be a response to what the user is doing right now.
+ */
 static void
-sfw_backend_wrist_sample_cb(sfw_plugin_t *plugin, const void *sample)
+sfw_backend_wrist_batch_cb(sfw_plugin_t *plugin, const void *samples,
+                           size_t count)
 {
     (void)plugin;
 
-    const sfw_sample_wrist_t *self = sample;
+    const sfw_sample_wrist_t *self = samples;
+
+    for( size_t i = 0; i < count; ++i ) {
+        mce_log(LL_DEBUG, "WRIST: time=%"PRIu64" wrist tilted=%s",
+                self[i].wrist_timestamp,
+                self[i].wrist_tilted ? "true" : "false");
+    }
+
+    const sfw_sample_wrist_t *last = self + count - 1;
+
+    /* Zero timestamp = not known -> assume fresh */
+    if( last->wrist_timestamp ) {
+        int64_t age = (mce_lib_get_mono_tick() -
+                       (int64_t)(last->wrist_timestamp / 1000));
+
+        if( age > SENSORFW_WRIST_MAX_AGE_MS ) {
+            mce_log(LL_DEBUG, "WRIST: ignoring %"PRId64" ms old gesture",
+                    age);
+            goto EXIT;
+        }
+    }
 
-    mce_log(LL_DEBUG, "WRIST: time=%"PRIu64" wrist tilted=%s",
-            self->wrist_timestamp, self->wrist_tilted ? "true" : "false");
+    sfw_notify_wrist(NOTIFY_SENSORD, last->wrist_tilted);
 
-    sfw_notify_wrist(NOTIFY_SENSORD, self->wrist_tilted);
+EXIT:
+    return;
 }
 // ----------------------------------------------------------------
 
@@ -1219,7 +1270,7 @@ static const sfw_backend_t sfw_backend_wrist =
     .be_sensor_interface = SENSORFW_SENSOR_INTERFACE_WRIST,
 
     .be_sample_size      = sizeof(sfw_sample_wrist_t),
-    .be_sample_cb        = sfw_backend_wrist_sample_cb,
+    .be_batch_cb         = sfw_backend_wrist_batch_cb,
 
     .be_value_method     = SENSORFW_SENSOR_METHOD_READ_WRIST,
     .be_value_cb         = sfw_backend_wrist_value_cb,
@@ -2028,6 +2079,10 @@ sfw_connection_get_session_id(const sfw_connection_t *self)
 }
 
 /** Handle array of sensor events sent by sensord
+ *
+ * The packet consists of one or more sample count + sample array
+ * groups. The samples are compacted in place into one contiguous
+ * array so that all of them can be passed on in one go.
  */
 static bool
 sfw_connection_handle_samples(sfw_connection_t *self,
@@ -2036,7 +2091,8 @@ sfw_connection_handle_samples(sfw_connection_t *self,
     bool     res    = false;
     uint32_t count  = 0;
     uint32_t block  = sfw_plugin_get_sample_size(self->con_plugin);
-    void    *sample = 0;
+    char    *batch  = data;
+    size_t   total  = 0;
 
     while( size > 0 ) {
         if( size < sizeof count ) {
@@ -2056,20 +2112,51 @@ sfw_connection_handle_samples(sfw_connection_t *self,
         }
 
         if( count > 0 ) {
-            sample = data + block * (count - 1);
+            /* Compacted data never overtakes unprocessed data */
+            memmove(batch + block * total, data, block * count);
+            total += count;
             data += block * count;
             size -= block * count;
         }
     }
 
-    if( !sample ) {
+    if( total < 1 ) {
             mce_log(LL_ERR, "connection(%s): no sample was received",
                     sfw_plugin_get_sensor_name(self->con_plugin));
         goto EXIT;
     }
 
     res = true;
-    sfw_plugin_handle_sample(self->con_plugin, sample);
+    sfw_plugin_handle_batch(self->con_plugin, batch, total);
+
+EXIT:
+    return res;
+}
+
+/** Make sure receive buffer can hold at least the given amount of data
+ */
+static bool
+sfw_connection_reserve_rx(sfw_connection_t *self, size_t size)
+{
+    bool res = false;
+
+    if( self->con_rx_size < size ) {
+        /* Round up to avoid frequent reallocations */
+        size_t want = ((size + SENSORFW_RX_BUFFER_SIZE - 1) /
+                       SENSORFW_RX_BUFFER_SIZE * SENSORFW_RX_BUFFER_SIZE);
+        char  *buf  = realloc(self->con_rx_buf, want);
+
+        if( !buf ) {
+            mce_log(LL_ERR, "connection(%s): failed to allocate %zu bytes",
+                    sfw_plugin_get_sensor_name(self->con_plugin), want);
+            goto EXIT;
+        }
+
+        self->con_rx_buf  = buf;
+        self->con_rx_size = want;
+    }
+
+    res = true;
 
 EXIT:
     return res;
@@ -2129,14 +2216,21 @@ static bool
 sfw_connection_rx_dta(sfw_connection_t *self)
 {
     bool    res = false;
-
-    char    dta[1024];
+    int     pending = 0;
 
     if( self->con_fd == -1 )
         goto EXIT;
 
+    /* Make room for everything sensord has queued up, so that
+     * batched samples get processed with one wakeup */
+    if( ioctl(self->con_fd, FIONREAD, &pending) == -1 || pending < 1 )
+        pending = SENSORFW_RX_BUFFER_SIZE;
+
+    if( !sfw_connection_reserve_rx(self, pending) )
+        goto EXIT;
+
     errno = 0;
-    int rc = read(self->con_fd, dta, sizeof dta);
+    int rc = read(self->con_fd, self->con_rx_buf, self->con_rx_size);
 
     if( rc == 0 ) {
         mce_log(LL_ERR, "connection(%s): received EOF",
@@ -2168,7 +2262,7 @@ sfw_connection_rx_dta(sfw_connection_t *self)
      *       introduced for handling header (sample count)
      *       and payload (sensor samples) separately.
      */
-    res = sfw_connection_handle_samples(self, dta, rc);
+    res = sfw_connection_handle_samples(self, self->con_rx_buf, rc);
 
 EXIT:
     return res;
@@ -2440,6 +2534,8 @@ sfw_connection_create(sfw_plugin_t *plugin)
     self->con_rx_id    = 0;
     self->con_tx_id    = 0;
     self->con_retry_id = 0;
+    self->con_rx_buf   = 0;
+    self->con_rx_size  = 0;
 
     return self;
 }
@@ -2454,6 +2550,7 @@ sfw_connection_delete(sfw_connection_t *self)
     if( self ) {
         sfw_connection_trans(self, CONNECTION_INITIAL);
         self->con_plugin = 0;
+        free(self->con_rx_buf);
         free(self);
     }
 }
@@ -2808,6 +2905,35 @@ sfw_plugin_handle_sample(sfw_plugin_t *self, const void *sample)
         self->plg_backend->be_sample_cb(self, sample);
 }
 
+/** Handle all sensor specific change events received in one packet
+ *
+ * Backends that define a batch callback get the whole sample array,
+ * including sample timestamps, in one go. Otherwise the samples are
+ * processed one by one in the order they were taken, so that also
+ * transient state changes are seen by the upper level logic.
+ */
+static void
+sfw_plugin_handle_batch(sfw_plugin_t *self, const void *samples, size_t count)
+{
+    size_t      block = sfw_plugin_get_sample_size(self);
+    const char *data  = samples;
+
+    if( count > 1 )
+        mce_log(LL_DEBUG, "plugin(%s): batch of %zu samples",
+                sfw_plugin_get_sensor_name(self), count);
+
+    if( self->plg_backend->be_batch_cb ) {
+        self->plg_backend->be_batch_cb(self, samples, count);
+        goto EXIT;
+    }
+
+    for( size_t i = 0; i < count; ++i )
+        sfw_plugin_handle_sample(self, data + block * i);
+
+EXIT:
+    return;
+}
+
 /** Handle sensor specific initial value received via dbus query
  */
 static void
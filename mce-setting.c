@@ -35,6 +35,12 @@ static gboolean gconf_disabled = FALSE;
 /** List of GConf notifiers */
 static GSList *gconf_notifiers = NULL;
 
+static gboolean mce_setting_notifier_add_full(const gchar *path,
+					      const gchar *key,
+					      const GConfClientNotifyFunc callback,
+					      gpointer user_data,
+					      guint *cb_id);
+
 /** Check if gconf-key exists
  *
  * @param key Name of value
@@ -334,6 +340,26 @@ EXIT:
 gboolean mce_setting_notifier_add(const gchar *path, const gchar *key,
 				const GConfClientNotifyFunc callback,
 				guint *cb_id)
+{
+	return mce_setting_notifier_add_full(path, key, callback, NULL, cb_id);
+}
+
+/**
+ * Add a GConf notifier with user data
+ *
+ * @param path The GConf directory to watch
+ * @param key The GConf key to add the notifier for
+ * @param callback The callback function
+ * @param user_data Data to pass to the callback function
+ * @param[out] cb_id Will contain the callback ID or zero on return
+ *
+ * @return TRUE on success, FALSE on failure
+ */
+static gboolean mce_setting_notifier_add_full(const gchar *path,
+					      const gchar *key,
+					      const GConfClientNotifyFunc callback,
+					      gpointer user_data,
+					      guint *cb_id)
 {
 	GError *error = NULL;
 	gboolean status = FALSE;
@@ -361,7 +387,7 @@ gboolean mce_setting_notifier_add(const gchar *path, const gchar *key,
 	}
 
 	id = gconf_client_notify_add(gconf_client, key, callback,
-				     NULL, NULL, &error);
+				     user_data, NULL, &error);
 	if (error != NULL) {
 		mce_log(LL_WARN,
 			"Could not register notifier for %s; %s",
@@ -502,6 +528,155 @@ void mce_setting_track_string(const gchar *key, gchar **val, const gchar *def,
 	g_free(path);
 }
 
+/** Change notification callback for bound settings
+ *
+ * @param gcc       (unused)
+ * @param id        (unused)
+ * @param entry     The modified GConf entry
+ * @param user_data The setting binding, as void pointer
+ */
+static void mce_setting_binding_cb(GConfClient *const gcc, const guint id,
+				   GConfEntry *const entry,
+				   gpointer const user_data)
+{
+	mce_setting_binding_t *self = user_data;
+	const GConfValue      *gcv  = gconf_entry_get_value(entry);
+
+	(void)gcc;
+	(void)id;
+
+	if( !gcv ) {
+		mce_log(LL_DEBUG, "%s: has been unset", self->key);
+		goto EXIT;
+	}
+
+	switch( self->type ) {
+	case MCE_SETTING_TYPE_BOOL:
+		if( gcv->type != GCONF_VALUE_BOOL )
+			goto TYPE_ERROR;
+		else {
+			gboolean *slot = self->value;
+			gboolean  curr = gconf_value_get_bool(gcv);
+			if( *slot == curr )
+				goto EXIT;
+			*slot = curr;
+		}
+		break;
+
+	case MCE_SETTING_TYPE_INT:
+		if( gcv->type != GCONF_VALUE_INT )
+			goto TYPE_ERROR;
+		else {
+			gint *slot = self->value;
+			gint  curr = gconf_value_get_int(gcv);
+			if( *slot == curr )
+				goto EXIT;
+			*slot = curr;
+		}
+		break;
+
+	case MCE_SETTING_TYPE_STRING:
+		if( gcv->type != GCONF_VALUE_STRING )
+			goto TYPE_ERROR;
+		else {
+			gchar       **slot = self->value;
+			const gchar  *curr = gconf_value_get_string(gcv);
+			if( !g_strcmp0(*slot, curr) )
+				goto EXIT;
+			g_free(*slot), *slot = g_strdup(curr);
+		}
+		break;
+
+	default:
+		goto TYPE_ERROR;
+	}
+
+	/* Hook is called only when the bound value changes */
+	if( self->changed_cb )
+		self->changed_cb(self);
+
+	goto EXIT;
+
+TYPE_ERROR:
+	mce_log(LL_WARN, "%s: unexpected value type %d",
+		self->key, gcv->type);
+
+EXIT:
+	return;
+}
+
+/** Get initial values of bound settings and start tracking changes
+ *
+ * Change hooks are not called for the initial values.
+ *
+ * Note: Values of string settings are owned by the bindings and
+ *       are released by mce_setting_bindings_quit().
+ *
+ * @param bindings Array of setting bindings, terminated by NULL key
+ */
+void mce_setting_bindings_init(mce_setting_binding_t *bindings)
+{
+	for( mce_setting_binding_t *self = bindings; self->key; ++self ) {
+		gchar *path = mce_setting_get_path(self->key);
+
+		switch( self->type ) {
+		case MCE_SETTING_TYPE_BOOL:
+			if( !mce_setting_get_bool(self->key, self->value) )
+				*(gboolean *)self->value = (self->def_int != 0);
+			break;
+
+		case MCE_SETTING_TYPE_INT:
+			if( !mce_setting_get_int(self->key, self->value) )
+				*(gint *)self->value = self->def_int;
+			break;
+
+		case MCE_SETTING_TYPE_STRING:
+			if( !mce_setting_get_string(self->key, self->value) )
+				*(gchar **)self->value = g_strdup(self->def_string);
+			break;
+
+		default:
+			mce_log(LL_ERR, "%s: unknown setting type %d",
+				self->key, self->type);
+			goto NEXT;
+		}
+
+		if( path ) {
+			mce_setting_notifier_add_full(path, self->key,
+						      mce_setting_binding_cb,
+						      self, &self->notify_id);
+		}
+NEXT:
+		g_free(path);
+	}
+}
+
+/** Stop tracking changes of bound settings
+ *
+ * @param bindings Array of setting bindings, terminated by NULL key
+ */
+void mce_setting_bindings_quit(mce_setting_binding_t *bindings)
+{
+	for( mce_setting_binding_t *self = bindings; self->key; ++self ) {
+		mce_setting_notifier_remove(self->notify_id),
+			self->notify_id = 0;
+
+		if( self->type == MCE_SETTING_TYPE_STRING ) {
+			g_free(*(gchar **)self->value),
+				*(gchar **)self->value = 0;
+		}
+	}
+}
+
+/**
+ * Release memory used for rebuildable caches
+ */
+void mce_setting_trim(void)
+{
+	if( gconf_client )
+		gconf_client_trim(gconf_client);
+}
+
 /**
  * Init function for the mce-gconf component
  *
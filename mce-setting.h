@@ -25,6 +25,47 @@
 
 # include "builtin-gconf.h"
 
+/** Value types for statically registered settings */
+typedef enum
+{
+	MCE_SETTING_TYPE_BOOL,
+	MCE_SETTING_TYPE_INT,
+	MCE_SETTING_TYPE_STRING,
+} mce_setting_type_t;
+
+typedef struct mce_setting_binding_t mce_setting_binding_t;
+
+/** Setting that is bound directly to a variable
+ *
+ * Modules define arrays of these, terminated by entry with NULL key,
+ * and pass them to mce_setting_bindings_init(). Value changes are
+ * then stored to the bound variable without key lookups, after which
+ * the optional change hook is called.
+ */
+struct mce_setting_binding_t
+{
+	/** Setting key */
+	const gchar         *key;
+
+	/** Value type; must match the type of the bound variable */
+	mce_setting_type_t   type;
+
+	/** Default value for bool and int settings */
+	gint                 def_int;
+
+	/** Default value for string settings */
+	const gchar         *def_string;
+
+	/** Bound variable: gboolean *, gint * or gchar ** */
+	gpointer             value;
+
+	/** Hook to call after value has changed, or NULL */
+	void               (*changed_cb)(const mce_setting_binding_t *binding);
+
+	/** Change notifier id; managed by mce-setting */
+	guint                notify_id;
+};
+
 gboolean      mce_setting_has_key           (const gchar *const key);
 gboolean      mce_setting_set_int           (const gchar *const key, const gint value);
 gboolean      mce_setting_set_string        (const gchar *const key, const gchar *const value);
@@ -39,6 +80,11 @@ void          mce_setting_track_int         (const gchar *key, gint *val, gint d
 void          mce_setting_track_bool        (const gchar *key, gboolean *val, gint def, GConfClientNotifyFunc cb, guint *cb_id);
 void          mce_setting_track_string      (const gchar *key, gchar **val, const gchar *def, GConfClientNotifyFunc cb, guint *cb_id);
 
+void          mce_setting_bindings_init     (mce_setting_binding_t *bindings);
+void          mce_setting_bindings_quit     (mce_setting_binding_t *bindings);
+
+void          mce_setting_trim              (void);
+
 gboolean      mce_setting_init              (void);
 void          mce_setting_exit              (void);
 
@@ -30,6 +30,7 @@
 #include "mce-log.h"
 #include "mce-lib.h"
 #include "mce-wakelock.h"
+#include "mce-prof.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -239,7 +240,9 @@ mce_wltimer_gate_cb(gpointer aptr)
         goto EXIT;
 
     if( self->wlt_notify ) {
+        mce_prof_enter("wltimer", self->wlt_name);
         bool res = self->wlt_notify(self->wlt_user_data);
+        mce_prof_leave();
 
         if( !mwt_queue_has_timer(self) ) {
             /* The notify callback managed to delete the timer
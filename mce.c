@@ -30,6 +30,8 @@
 #include "mce-fbdev.h"
 #include "mce-hbtimer.h"
 #include "mce-wltimer.h"
+#include "mce-sched.h"
+#include "mce-prof.h"
 #include "mce-setting.h"
 #include "mce-dbus.h"
 #include "mce-dsme.h"
@@ -659,6 +661,8 @@ static struct
 	bool systemd_notify;
 	bool valgrind_mode;
 	int  auto_exit;
+	int  startup_benchmark;
+	const char *replay_datapipes;
 } mce_args =
 {
 	.daemonflag       = false,
@@ -669,6 +673,8 @@ static struct
 	.systemd_notify   = false,
 	.valgrind_mode    = false,
 	.auto_exit        = -1,
+	.startup_benchmark = 0,
+	.replay_datapipes = 0,
 };
 
 bool mce_in_valgrind_mode(void)
@@ -705,6 +711,16 @@ static bool mce_do_auto_exit(const char *arg)
 	mce_args.auto_exit = arg ? strtol(arg, 0, 0) : 5;
 	return true;
 }
+static bool mce_do_startup_benchmark(const char *arg)
+{
+	mce_args.startup_benchmark = arg ? strtol(arg, 0, 0) : 10;
+	return true;
+}
+static bool mce_do_replay_datapipes(const char *arg)
+{
+	mce_args.replay_datapipes = arg;
+	return true;
+}
 static bool mce_do_valgrind_mode(const char *arg)
 {
 	(void)arg;
@@ -872,12 +888,38 @@ static const mce_opt_t options[] =
 			"\n"
 			"This is usefult for mce startup debugging only.\n"
 	},
+	{
+		.name        = "startup-benchmark",
+		.values      = "rounds",
+		.with_arg    = mce_do_startup_benchmark,
+		.without_arg = mce_do_startup_benchmark,
+		.usage       =
+			"Repeat startup and print per-phase statistics\n"
+			"\n"
+			"Each round is run in a child process that behaves\n"
+			"as if --auto-exit=0 had been given. Duration of each\n"
+			"startup phase is collected and min/avg/max values\n"
+			"over all rounds are printed to stdout. Meant to be\n"
+			"used with --session for offline benchmarking only.\n"
+	},
 	{
 		.name        = "valgrind-mode",
 		.without_arg = mce_do_valgrind_mode,
 		.usage       =
 			"Enable run-under valgrind mode\n"
 	},
+	{
+		.name        = "replay-datapipes",
+		.values      = "file",
+		.with_arg    = mce_do_replay_datapipes,
+		.usage       =
+			"Replay datapipe recording and exit\n"
+			"\n"
+			"Recorded datapipe executions are fed to the\n"
+			"policy modules as fast as possible and the\n"
+			"cpu time used is logged. Can be used only together\n"
+			"with --session, for offline benchmarking.\n"
+	},
 	// sentinel
 	{
 		.name = 0
@@ -968,9 +1010,31 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	/* Replaying datapipes would affect the real device state */
+	if( mce_args.replay_datapipes && mce_args.systembus ) {
+		fprintf(stderr, "%s: --replay-datapipes requires --session\n",
+			progname);
+		exit(EXIT_FAILURE);
+	}
+
 	mce_log_open(PRG_NAME, LOG_DAEMON, mce_args.logtype);
 	mce_log_set_verbosity(mce_args.verbosity);
 
+	/* Debug feature: repeat startup in child processes and
+	 * report per-phase statistics */
+	if( mce_args.startup_benchmark > 0 ) {
+		if( !mce_prof_startup_benchmark(mce_args.startup_benchmark,
+						&status) ) {
+			mce_log_close();
+			return status;
+		}
+		mce_args.auto_exit = 0;
+		status = EXIT_FAILURE;
+	}
+
+	/* Record duration of startup phases */
+	mce_prof_startup_begin();
+
 #ifdef ENABLE_WAKELOCKS
 	/* Since mce enables automatic suspend, we must try to
 	 * disable it when mce process exits */
@@ -998,15 +1062,18 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 	mce_signal_handlers_install();
+	mce_prof_startup_mark("init", "mainloop");
 
 	/* Initialise subsystems */
 
 	/* Open fbdev as early as possible */
 	mce_fbdev_init();
+	mce_prof_startup_mark("init", "fbdev");
 
 	/* Start worker thread */
 	if( !mce_worker_init() )
 		goto EXIT;
+	mce_prof_startup_mark("init", "worker");
 
 	/* Get configuration options */
 	if( !mce_conf_init() ) {
@@ -1014,6 +1081,7 @@ int main(int argc, char **argv)
 			"Failed to initialise configuration options");
 		exit(EXIT_FAILURE);
 	}
+	mce_prof_startup_mark("init", "conf");
 
 	/* Initialise D-Bus */
 	if( !mce_dbus_init(mce_args.systembus) ) {
@@ -1021,6 +1089,7 @@ int main(int argc, char **argv)
 			"Failed to initialise D-Bus");
 		exit(EXIT_FAILURE);
 	}
+	mce_prof_startup_mark("init", "dbus");
 
 	/* Initialise GConf
 	 * pre-requisite: g_type_init()
@@ -1030,15 +1099,31 @@ int main(int argc, char **argv)
 			"Cannot connect to default GConf engine");
 		exit(EXIT_FAILURE);
 	}
+	mce_prof_startup_mark("init", "setting");
 
 	/* Setup all datapipes */
 	mce_datapipe_init();
+	mce_prof_startup_mark("init", "datapipe");
 
 	/* Allow registering of suspend proof timers */
 	mce_hbtimer_init();
+	mce_prof_startup_mark("init", "hbtimer");
 
 	/* Allow registering of suspend blocking timers */
 	mce_wltimer_init();
+	mce_prof_startup_mark("init", "wltimer");
+
+	/* Allow scheduling priority boosts
+	 * pre-requisite: mce_conf_init()
+	 */
+	mce_sched_init();
+	mce_prof_startup_mark("init", "sched");
+
+	/* Allow main loop dispatch profiling
+	 * pre-requisite: mce_dbus_init()
+	 */
+	mce_prof_init();
+	mce_prof_startup_mark("init", "prof");
 
 	/* Initialise mode management
 	 * pre-requisite: mce_setting_init()
@@ -1047,6 +1132,7 @@ int main(int argc, char **argv)
 	if (mce_mode_init() == FALSE) {
 		goto EXIT;
 	}
+	mce_prof_startup_mark("init", "mode");
 
 	/* Initialise DSME
 	 * pre-requisite: mce_setting_init()
@@ -1055,11 +1141,13 @@ int main(int argc, char **argv)
 	 */
 	if( !mce_dsme_init() )
 		goto EXIT;
+	mce_prof_startup_mark("init", "dsme");
 
 	/* Initialise powerkey driver */
 	if (mce_powerkey_init() == FALSE) {
 		goto EXIT;
 	}
+	mce_prof_startup_mark("init", "powerkey");
 
 	/* Initialise /dev/input driver
 	 * pre-requisite: g_type_init()
@@ -1067,23 +1155,28 @@ int main(int argc, char **argv)
 	if (mce_input_init() == FALSE) {
 		goto EXIT;
 	}
+	mce_prof_startup_mark("init", "input");
 
 	/* Initialise switch driver */
 	if (mce_switches_init() == FALSE) {
 		goto EXIT;
 	}
+	mce_prof_startup_mark("init", "switches");
 
 	/* Initialise tklock driver */
 	if (mce_tklock_init() == FALSE) {
 		goto EXIT;
 	}
+	mce_prof_startup_mark("init", "tklock");
 
 	if( !mce_sensorfw_init() ) {
 		goto EXIT;
 	}
+	mce_prof_startup_mark("init", "sensorfw");
 
 	if( !mce_common_init() )
 		goto EXIT;
+	mce_prof_startup_mark("init", "common");
 
 	/* Load all modules */
 	if (mce_modules_init() == FALSE) {
@@ -1097,12 +1190,21 @@ int main(int argc, char **argv)
 
 	/* MCE startup succeeded */
 	status = EXIT_SUCCESS;
+	mce_prof_startup_finish();
 
 	/* Tell systemd that we have started up */
 	if( mce_args.systemd_notify ) {
 		mce_log(LL_NOTICE, "notifying systemd");
 		sd_notify(0, "READY=1");
 	}
+	/* Debug feature: replay recorded datapipe traffic and exit */
+	if( mce_args.replay_datapipes ) {
+		if( !datapipe_replay_start(mce_args.replay_datapipes) ) {
+			status = EXIT_FAILURE;
+			goto EXIT;
+		}
+	}
+
 	/* Debug feature: exit after startup is finished */
 	if( mce_args.auto_exit >= 0 ) {
 		mce_log(LL_WARN, "auto-exit scheduled");
@@ -1129,6 +1231,8 @@ EXIT:
 	mce_powerkey_exit();
 	mce_dsme_exit();
 	mce_mode_exit();
+	mce_prof_quit();
+	mce_sched_quit();
 	mce_wltimer_quit();
 	mce_hbtimer_quit();
 
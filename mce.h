@@ -403,6 +403,31 @@ typedef enum
 
 const char *orientation_state_repr(orientation_state_t state);
 
+/** Supported memory usage levels
+ *
+ * Note: The ordering must match:
+ *       1) memnotify_limit[] array in memnotify module
+ *       2) memnotify_dev[] array in memnotify module
+ */
+typedef enum
+{
+	/** No excess memory pressure */
+	MEMNOTIFY_LEVEL_NORMAL,
+
+	/** Non-essential caches etc should be released */
+	MEMNOTIFY_LEVEL_WARNING,
+
+	/** Non-essential prosesses should be terminated */
+	MEMNOTIFY_LEVEL_CRITICAL,
+
+	/* Not initialized yet or memnotify is not supported */
+	MEMNOTIFY_LEVEL_UNKNOWN,
+
+	MEMNOTIFY_LEVEL_COUNT
+} memnotify_level_t;
+
+const char *memnotify_level_repr(memnotify_level_t lev);
+
 /* XXX: use HAL */
 
 /** Does the device have a flicker key? */
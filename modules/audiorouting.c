@@ -23,6 +23,7 @@
 #include "../mce.h"
 #include "../mce-log.h"
 #include "../mce-dbus.h"
+#include "../mce-modules.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -567,9 +568,31 @@ static mce_dbus_handler_t handlers[] =
     }
 };
 
+/**
+ * Initialize the audio routing module
+ *
+ * @return NULL on success, a string with an error message on failure
+ */
+static const gchar *audiorouting_module_init(void)
+{
+    mce_dbus_handler_register_array(handlers);
+
+    return NULL;
+}
+
+/**
+ * Cleanup the audio routing module
+ */
+static void audiorouting_module_quit(void)
+{
+    mce_dbus_handler_unregister_array(handlers);
+}
+
 /**
  * Init function for the audio routing module
  *
+ * The actual initialization is deferred until after the display is on.
+ *
  * @param module Unused
  *
  * @return NULL on success, a string with an error message on failure
@@ -579,14 +602,17 @@ const gchar *g_module_check_init(GModule *module)
 {
     (void)module;
 
-    mce_dbus_handler_register_array(handlers);
-
-    return NULL;
+    return mce_modules_defer(MODULE_NAME,
+                             MCE_MODULE_STARTUP_AFTER_DISPLAY, NULL,
+                             audiorouting_module_init,
+                             audiorouting_module_quit);
 }
 
 /**
  * Exit function for the audio routing module
  *
+ * Cleanup is done via audiorouting_module_quit() from mce-modules.
+ *
  * @param module Unused
  */
 G_MODULE_EXPORT void g_module_unload(GModule *module);
@@ -594,7 +620,5 @@ void g_module_unload(GModule *module)
 {
     (void)module;
 
-    mce_dbus_handler_unregister_array(handlers);
-
     return;
 }
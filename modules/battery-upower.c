@@ -22,6 +22,7 @@
 #include "../mce.h"
 #include "../mce-log.h"
 #include "../mce-dbus.h"
+#include "../mce-modules.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -1126,19 +1127,12 @@ static void mce_battery_quit_dbus(void)
     mce_dbus_handler_unregister_array(battery_upower_dbus_handlers);
 }
 
-/** Init function for the battery and charger module
- *
- * @todo XXX status needs to be set on error!
- *
- * @param module Unused
+/** Initialize the battery and charger module
  *
  * @return NULL on success, a string with an error message on failure
  */
-G_MODULE_EXPORT const gchar *g_module_check_init(GModule *module);
-const gchar *g_module_check_init(GModule *module)
+static const gchar *battery_upower_module_init(void)
 {
-    (void)module;
-
     /* reset data used by the state machine */
     mcebat_init();
     upowbat_init();
@@ -1155,7 +1149,41 @@ const gchar *g_module_check_init(GModule *module)
     return NULL;
 }
 
+/** Cleanup the battery and charger module
+ */
+static void battery_upower_module_quit(void)
+{
+    /* Remove dbus handlers */
+    mce_battery_quit_dbus();
+
+    devlist_rem_dev_all();
+    mcebat_update_cancel();
+}
+
+/** Init function for the battery and charger module
+ *
+ * Starting upowerd is deferred until after the display is on.
+ *
+ * @todo XXX status needs to be set on error!
+ *
+ * @param module Unused
+ *
+ * @return NULL on success, a string with an error message on failure
+ */
+G_MODULE_EXPORT const gchar *g_module_check_init(GModule *module);
+const gchar *g_module_check_init(GModule *module)
+{
+    (void)module;
+
+    return mce_modules_defer(MODULE_NAME,
+                             MCE_MODULE_STARTUP_AFTER_DISPLAY, NULL,
+                             battery_upower_module_init,
+                             battery_upower_module_quit);
+}
+
 /** Exit function for the battery and charger module
+ *
+ * Cleanup is done via battery_upower_module_quit() from mce-modules.
  *
  * @param module Unused
  */
@@ -1163,10 +1191,4 @@ G_MODULE_EXPORT void g_module_unload(GModule *module);
 void g_module_unload(GModule *module)
 {
     (void)module;
-
-    /* Remove dbus handlers */
-    mce_battery_quit_dbus();
-
-    devlist_rem_dev_all();
-    mcebat_update_cancel();
 }
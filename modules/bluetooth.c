@@ -22,6 +22,7 @@
 #include "../mce.h"
 #include "../mce-log.h"
 #include "../mce-dbus.h"
+#include "../mce-modules.h"
 #include "../libwakelock.h"
 
 #include <stdlib.h>
@@ -29,6 +30,9 @@
 
 #include <gmodule.h>
 
+/** Module name */
+#define MODULE_NAME "bluetooth"
+
 /* Unlike the other standard dbus interfaces, the object manager seems
  * not to be defined in dbus-shared.h header file ... */
 #ifndef  DBUS_INTERFACE_OBJECT_MANAGER
@@ -57,6 +61,9 @@ static void     bluetooth_dbus_quit(void);
  * MODULE_LOAD_UNLOAD
  * ------------------------------------------------------------------------- */
 
+static const gchar           *bluetooth_module_init(void);
+static void                   bluetooth_module_quit(void);
+
 G_MODULE_EXPORT const gchar *g_module_check_init(GModule *module);
 G_MODULE_EXPORT void         g_module_unload(GModule *module);
 
@@ -343,16 +350,14 @@ static void bluetooth_datapipe_quit(void)
  * MODULE_LOAD_UNLOAD
  * ========================================================================= */
 
-/** Init function for the bluetooth module
+/** Initialize the bluetooth module
  *
- * @param module (not used)
+ * Called via mce_modules_defer() once bluez is on D-Bus.
  *
  * @return NULL on success, a string with an error message on failure
  */
-const gchar *g_module_check_init(GModule *module)
+static const gchar *bluetooth_module_init(void)
 {
-    (void)module;
-
     bluetooth_datapipe_init();
 
     bluetooth_dbus_init();
@@ -360,17 +365,44 @@ const gchar *g_module_check_init(GModule *module)
     return 0;
 }
 
-/** Exit function for the bluetooth module
- *
- * @param module (not used)
+/** Cleanup the bluetooth module
  */
-void g_module_unload(GModule *module)
+static void bluetooth_module_quit(void)
 {
-    (void)module;
-
     bluetooth_datapipe_quit();
 
     bluetooth_dbus_quit();
 
     bluetooth_suspend_block_stop();
 }
+
+/** Init function for the bluetooth module
+ *
+ * Nothing needs to be done before bluez is running, so the actual
+ * initialization is deferred until that happens.
+ *
+ * @param module (not used)
+ *
+ * @return NULL on success, a string with an error message on failure
+ */
+const gchar *g_module_check_init(GModule *module)
+{
+    (void)module;
+
+    return mce_modules_defer(MODULE_NAME,
+                             MCE_MODULE_STARTUP_ON_SERVICE,
+                             &bluez_available_pipe,
+                             bluetooth_module_init,
+                             bluetooth_module_quit);
+}
+
+/** Exit function for the bluetooth module
+ *
+ * Cleanup is done via bluetooth_module_quit() from mce-modules.
+ *
+ * @param module (not used)
+ */
+void g_module_unload(GModule *module)
+{
+    (void)module;
+}
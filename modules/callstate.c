@@ -24,6 +24,7 @@
 #include "../mce-log.h"
 #include "../mce-dbus.h"
 #include "../mce-wltimer.h"
+#include "../mce-sched.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -85,6 +86,9 @@ G_MODULE_EXPORT module_info_struct module_info = {
  * MODULE DATA
  * ========================================================================= */
 
+/** How long to boost mce scheduling priority on incoming call [ms] */
+#define CALL_STATE_RINGING_BOOST_MS 3000
+
 /** Maximum number of concurrent call state requesters */
 #define CLIENTS_MONITOR_COUNT 15
 
@@ -1696,6 +1700,12 @@ call_state_rethink_now(void)
 
     send_call_state(NULL, state_str, type_str);
 
+    /* Keep mce responsive while ringing starts up */
+    if( call_state == CALL_STATE_RINGING )
+        mce_sched_boost_start("incoming_call", CALL_STATE_RINGING_BOOST_MS);
+    else
+        mce_sched_boost_stop("incoming_call");
+
     execute_datapipe(&call_state_pipe,
                      GINT_TO_POINTER(call_state),
                      USE_INDATA, CACHE_INDATA);
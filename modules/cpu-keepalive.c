@@ -76,6 +76,9 @@ static const char cpu_wakelock[] = "mce_cpu_keepalive";
 /** Auto blocking after MCE_CPU_KEEPALIVE_PERIOD_REQ method calls [s] */
 # define MCE_CPU_KEEPALIVE_QUERY_PERIOD_S 2
 
+/** How much keepalive session expiry is allowed to be late [ms] */
+# define MCE_CPU_KEEPALIVE_EXPIRY_SLACK_MS 500
+
 /** Maximum delay between rtc wakeup and the 1st keep alive request
  *
  * FIXME: The rtc wakeup timeouts need to be tuned once timed and
@@ -96,6 +99,9 @@ static const char cpu_wakelock[] = "mce_cpu_keepalive";
 /** Warning limit for: keepalive state is kept active too long */
 #define KEEPALIVE_STATE_WARN_LIMIT_MS   (5 * 60 * 1000) // 5 minutes
 
+/** Number of stale deadline queue entries tolerated before compaction */
+#define CKA_DEADLINE_STALE_LIMIT        32
+
 /* ========================================================================= *
  * TYPEDEFS
  * ========================================================================= */
@@ -107,6 +113,8 @@ typedef struct cka_session_t cka_session_t;
 
 typedef struct cka_client_t cka_client_t;
 
+typedef struct cka_deadline_t cka_deadline_t;
+
 /* ========================================================================= *
  * FUNCTION_PROTOTYPES
  * ========================================================================= */
@@ -178,9 +186,6 @@ struct cka_client_t
   /** NameOwnerChanged signal match used for tracking death of client */
   char       *cli_match_rule;
 
-  /** Upper bound for reneval of cpu keepalive for this client */
-  tick_t      cli_timeout;
-
   /** One client can have several keepalive objects */
   GHashTable *cli_sessions; // [string] -> cka_session_t *
 };
@@ -198,7 +203,7 @@ static const char cka_client_match_fmt[] =
 
 static cka_session_t *cka_client_get_session   (cka_client_t *self, const char *session_id);
 static cka_session_t *cka_client_add_session   (cka_client_t *self, const char *session_id);
-static void           cka_client_scan_timeout  (cka_client_t *self);
+static void           cka_client_expire_session(cka_client_t *self, cka_session_t *session);
 static void           cka_client_remove_timeout(cka_client_t *self, const char *session_id);
 static void           cka_client_update_timeout(cka_client_t *self, const char *session_id, tick_t when);
 static cka_client_t  *cka_client_create        (const char *dbus_name);
@@ -207,6 +212,47 @@ static const char    *cka_client_identify      (cka_client_t *self);
 static void           cka_client_delete        (cka_client_t *self);
 static void           cka_client_delete_cb     (void *self);
 
+/* ------------------------------------------------------------------------- *
+ * DEADLINE_QUEUE
+ * ------------------------------------------------------------------------- */
+
+/** Session deadline queue entry
+ *
+ * Renewing a session pushes a new entry without removing the old
+ * one. Entries that no longer match the session timeout, or refer
+ * to already deleted sessions, are dropped when they surface at
+ * the top of the queue.
+ */
+struct cka_deadline_t
+{
+  /** Session timeout at the time of queuing */
+  tick_t   dln_when;
+
+  /** Internal unique identifier of the session */
+  unsigned dln_unique;
+};
+
+/** Binary max-heap of session deadlines */
+static GArray     *cka_deadline_heap = 0; // cka_deadline_t
+
+/** Live sessions by internal unique identifier */
+static GHashTable *cka_deadline_sessions = 0; // [unique] -> cka_session_t *
+
+static cka_session_t  *cka_deadline_get_session (const cka_deadline_t *self);
+static cka_deadline_t *cka_deadline_at          (guint pos);
+static void            cka_deadline_swap        (guint pos1, guint pos2);
+static void            cka_deadline_sift_up     (guint pos);
+static void            cka_deadline_sift_down   (guint pos);
+static void            cka_deadline_pop         (void);
+static void            cka_deadline_compact     (void);
+static void            cka_deadline_push        (cka_session_t *session);
+static tick_t          cka_deadline_get_maximum (void);
+static void            cka_deadline_expire      (tick_t now);
+static void            cka_deadline_attach      (cka_session_t *session);
+static void            cka_deadline_detach      (cka_session_t *session);
+static void            cka_deadline_init        (void);
+static void            cka_deadline_quit        (void);
+
 /* ------------------------------------------------------------------------- *
  * KEEPALIVE_STATE
  * ------------------------------------------------------------------------- */
@@ -214,6 +260,9 @@ static void           cka_client_delete_cb     (void *self);
 /** Timer for releasing cpu-keepalive wakelock */
 static guint    cka_state_timer_id = 0;
 
+/** When the cpu-keepalive timer is due to trigger */
+static tick_t   cka_state_timer_due = 0;
+
 static void     cka_state_set       (bool active);
 static gboolean cka_state_timer_cb  (gpointer data);
 static void     cka_state_reset     (void);
@@ -473,6 +522,8 @@ cka_session_create(cka_client_t *client, const char *session_id)
           self->ses_unique, self->ses_session,
           cka_client_identify(self->ses_client));
 
+  cka_deadline_attach(self);
+
   return self;
 }
 
@@ -488,6 +539,8 @@ cka_session_renew(cka_session_t *self, tick_t timeout)
   self->ses_timeout  = timeout;
   self->ses_renewed += 1;
 
+  cka_deadline_push(self);
+
   tick_t now = cka_tick_get_current();
   tick_t dur = now - self->ses_started;
 
@@ -552,6 +605,8 @@ cka_session_delete(cka_session_t *self)
           self->ses_unique, self->ses_session,
           cka_client_identify(self->ses_client));
 
+  cka_deadline_detach(self);
+
   g_free(self->ses_session);
   g_free(self);
 
@@ -605,6 +660,12 @@ cka_client_add_session(cka_client_t *self, const char *session_id)
 {
   cka_session_t *session = g_hash_table_lookup(self->cli_sessions, session_id);
 
+  /* Expired sessions are purged lazily -> do not resurrect */
+  if( session && session->ses_timeout <= cka_tick_get_current() )
+  {
+    cka_client_expire_session(self, session), session = 0;
+  }
+
   if( !session )
   {
     session = cka_session_create(self, session_id);
@@ -614,46 +675,18 @@ cka_client_add_session(cka_client_t *self, const char *session_id)
   return session;
 }
 
-/** Update client timeout to be maximum of context timeouts
+/** Finish and remove a session that has reached its timeout
  *
- * @param self pointer to cka_client_t structure
+ * @param self     pointer to cka_client_t structure
+ * @param session  session object owned by the client
  */
 static
 void
-cka_client_scan_timeout(cka_client_t *self)
+cka_client_expire_session(cka_client_t *self, cka_session_t *session)
 {
-  tick_t now  = cka_tick_get_current();
-
-  self->cli_timeout = 0;
-
-  /* Expire sessions / update client timeout */
-  GHashTableIter iter;
-  gpointer       val;
-
-  g_hash_table_iter_init(&iter, self->cli_sessions);
-  while( g_hash_table_iter_next(&iter, 0, &val) )
-  {
-    cka_session_t *session = val;
-
-    if( session->ses_timeout <= now )
-    {
-      /* Expire session */
-      cka_session_finish(session, now);
-      g_hash_table_iter_remove(&iter);
-    }
-    else if( self->cli_timeout < session->ses_timeout )
-    {
-      /* Update client timeout */
-      self->cli_timeout = session->ses_timeout;
-    }
-  }
-
-  if( self->cli_timeout > now )
-  {
-    mce_log(LL_DEBUG, "client T%+"PRId64"; %s",
-            now - self->cli_timeout,
-            cka_client_identify(self));
-  }
+  /* Expiry is handled lazily -> use the timeout as end of session */
+  cka_session_finish(session, session->ses_timeout);
+  g_hash_table_remove(self->cli_sessions, session->ses_session);
 }
 
 /** Clear client cpu-keepalive timeout
@@ -725,7 +758,6 @@ cka_client_create(const char *dbus_name)
   self->cli_dbus_name  = g_strdup(dbus_name);
   self->cli_match_rule = g_strdup_printf(cka_client_match_fmt,
                                          self->cli_dbus_name);
-  self->cli_timeout    = 0;
 
   self->cli_sessions   = g_hash_table_new_full(g_str_hash, g_str_equal,
                                                g_free, cka_session_delete_cb);
@@ -790,6 +822,313 @@ cka_client_delete_cb(void *self)
   cka_client_delete(self);
 }
 
+/* ========================================================================= *
+ *
+ * DEADLINE_QUEUE
+ *
+ * ========================================================================= */
+
+/** Lookup session a deadline queue entry refers to
+ *
+ * @param self  deadline queue entry
+ *
+ * @return session object, or NULL if the entry is stale
+ */
+static
+cka_session_t *
+cka_deadline_get_session(const cka_deadline_t *self)
+{
+  cka_session_t *session =
+    g_hash_table_lookup(cka_deadline_sessions,
+                        GUINT_TO_POINTER(self->dln_unique));
+
+  if( session && session->ses_timeout != self->dln_when )
+  {
+    session = 0;
+  }
+
+  return session;
+}
+
+/** Get deadline queue entry at given heap position
+ *
+ * @param pos  heap array index
+ *
+ * @return pointer to queue entry
+ */
+static
+cka_deadline_t *
+cka_deadline_at(guint pos)
+{
+  return &g_array_index(cka_deadline_heap, cka_deadline_t, pos);
+}
+
+/** Swap two deadline queue entries
+ *
+ * @param pos1  heap array index
+ * @param pos2  heap array index
+ */
+static
+void
+cka_deadline_swap(guint pos1, guint pos2)
+{
+  cka_deadline_t tmp = *cka_deadline_at(pos1);
+  *cka_deadline_at(pos1) = *cka_deadline_at(pos2);
+  *cka_deadline_at(pos2) = tmp;
+}
+
+/** Restore heap order by moving an entry towards the top
+ *
+ * @param pos  heap array index
+ */
+static
+void
+cka_deadline_sift_up(guint pos)
+{
+  while( pos > 0 )
+  {
+    guint parent = (pos - 1) / 2;
+
+    if( cka_deadline_at(parent)->dln_when >= cka_deadline_at(pos)->dln_when )
+    {
+      break;
+    }
+
+    cka_deadline_swap(parent, pos), pos = parent;
+  }
+}
+
+/** Restore heap order by moving an entry towards the bottom
+ *
+ * @param pos  heap array index
+ */
+static
+void
+cka_deadline_sift_down(guint pos)
+{
+  guint len = cka_deadline_heap->len;
+
+  for( ;; )
+  {
+    guint top = pos;
+    guint lhs = 2 * pos + 1;
+    guint rhs = 2 * pos + 2;
+
+    if( lhs < len &&
+        cka_deadline_at(lhs)->dln_when > cka_deadline_at(top)->dln_when )
+    {
+      top = lhs;
+    }
+
+    if( rhs < len &&
+        cka_deadline_at(rhs)->dln_when > cka_deadline_at(top)->dln_when )
+    {
+      top = rhs;
+    }
+
+    if( top == pos )
+    {
+      break;
+    }
+
+    cka_deadline_swap(top, pos), pos = top;
+  }
+}
+
+/** Remove the furthest away deadline from the queue
+ */
+static
+void
+cka_deadline_pop(void)
+{
+  guint len = cka_deadline_heap->len;
+
+  if( len < 1 )
+  {
+    goto EXIT;
+  }
+
+  cka_deadline_swap(0, len - 1);
+  g_array_set_size(cka_deadline_heap, len - 1);
+  cka_deadline_sift_down(0);
+
+EXIT:
+  return;
+}
+
+/** Drop stale entries and rebuild the deadline queue
+ */
+static
+void
+cka_deadline_compact(void)
+{
+  guint len = cka_deadline_heap->len;
+  guint out = 0;
+
+  for( guint pos = 0; pos < len; ++pos )
+  {
+    if( cka_deadline_get_session(cka_deadline_at(pos)) )
+    {
+      *cka_deadline_at(out++) = *cka_deadline_at(pos);
+    }
+  }
+
+  g_array_set_size(cka_deadline_heap, out);
+
+  for( guint pos = out / 2; pos-- > 0; )
+  {
+    cka_deadline_sift_down(pos);
+  }
+
+  mce_log(LL_DEBUG, "deadline queue compacted; %u -> %u entries",
+          len, out);
+}
+
+/** Queue current timeout of a session
+ *
+ * Entries queued for earlier timeouts of the same session become
+ * stale and are dropped lazily.
+ *
+ * @param session  session object
+ */
+static
+void
+cka_deadline_push(cka_session_t *session)
+{
+  guint live = g_hash_table_size(cka_deadline_sessions);
+
+  if( cka_deadline_heap->len >= 2 * live + CKA_DEADLINE_STALE_LIMIT )
+  {
+    cka_deadline_compact();
+  }
+
+  cka_deadline_t entry =
+  {
+    .dln_when   = session->ses_timeout,
+    .dln_unique = session->ses_unique,
+  };
+
+  g_array_append_val(cka_deadline_heap, entry);
+  cka_deadline_sift_up(cka_deadline_heap->len - 1);
+}
+
+/** Get the furthest away session timeout
+ *
+ * @return maximum of live session timeouts, or 0 if there are none
+ */
+static
+tick_t
+cka_deadline_get_maximum(void)
+{
+  tick_t res = 0;
+
+  while( cka_deadline_heap->len > 0 )
+  {
+    cka_deadline_t *top = cka_deadline_at(0);
+
+    if( cka_deadline_get_session(top) )
+    {
+      res = top->dln_when;
+      break;
+    }
+
+    cka_deadline_pop();
+  }
+
+  return res;
+}
+
+/** Expire sessions once even the furthest away timeout has passed
+ *
+ * Sessions that expire while some other session is still active
+ * are left in place until either the client touches the session
+ * again or all sessions have expired.
+ *
+ * @param now  current time
+ */
+static
+void
+cka_deadline_expire(tick_t now)
+{
+  while( cka_deadline_heap->len > 0 )
+  {
+    cka_deadline_t *top     = cka_deadline_at(0);
+    cka_session_t  *session = cka_deadline_get_session(top);
+
+    if( session && session->ses_timeout > now )
+    {
+      break;
+    }
+
+    cka_deadline_pop();
+
+    if( session )
+    {
+      cka_client_expire_session(session->ses_client, session);
+    }
+  }
+}
+
+/** Make session trackable via deadline queue entries
+ *
+ * @param session  session object
+ */
+static
+void
+cka_deadline_attach(cka_session_t *session)
+{
+  g_hash_table_replace(cka_deadline_sessions,
+                       GUINT_TO_POINTER(session->ses_unique), session);
+}
+
+/** Invalidate all deadline queue entries referring to a session
+ *
+ * @param session  session object
+ */
+static
+void
+cka_deadline_detach(cka_session_t *session)
+{
+  g_hash_table_remove(cka_deadline_sessions,
+                      GUINT_TO_POINTER(session->ses_unique));
+}
+
+/** Initialize session deadline tracking
+ */
+static
+void
+cka_deadline_init(void)
+{
+  if( !cka_deadline_heap )
+  {
+    cka_deadline_heap = g_array_new(FALSE, FALSE, sizeof (cka_deadline_t));
+  }
+
+  if( !cka_deadline_sessions )
+  {
+    cka_deadline_sessions = g_hash_table_new(g_direct_hash, g_direct_equal);
+  }
+}
+
+/** Cleanup session deadline tracking
+ *
+ * Note: Must be called after all sessions have been deleted
+ */
+static
+void
+cka_deadline_quit(void)
+{
+  if( cka_deadline_sessions )
+  {
+    g_hash_table_unref(cka_deadline_sessions), cka_deadline_sessions = 0;
+  }
+
+  if( cka_deadline_heap )
+  {
+    g_array_free(cka_deadline_heap, TRUE), cka_deadline_heap = 0;
+  }
+}
+
 /* ========================================================================= *
  *
  * KEEPALIVE_STATE
@@ -868,8 +1207,9 @@ cka_state_timer_cb(gpointer data)
   {
     mce_log(LL_DEBUG, "cpu-keepalive timeout triggered");
     cka_state_timer_id = 0;
+    cka_state_timer_due = 0;
 
-    /* Do full rethink to expire client sessions */
+    /* Expire client sessions, or re-arm if timeout has been extended */
     cka_state_rethink();
   }
 
@@ -888,13 +1228,19 @@ cka_state_reset(void)
     g_source_remove(cka_state_timer_id), cka_state_timer_id = 0;
   }
 
+  cka_state_timer_due = 0;
+
   cka_state_set(false);
 }
 
 /** Re-evaluate the end of cpu-keepalive period
  *
- * Calculates maximum of wakeup period and per client renew periods
- * and uses it to reprogram the end of cpu-keepalive period
+ * Uses maximum of wakeup period and session timeouts as the end of
+ * cpu-keepalive period.
+ *
+ * The timer is re-armed only when the period gets shorter. Extending
+ * the period - which is what renewals normally do - is dealt with
+ * when the already armed timer triggers.
  */
 static
 void
@@ -902,45 +1248,47 @@ cka_state_rethink(void)
 {
   tick_t now = cka_tick_get_current();
 
-  /* Find furthest away client renew timeout */
-  tick_t maxtime = cka_clients_wakeup_timeout;
+  /* Expire sessions if all of them have timed out */
+  cka_deadline_expire(now);
 
-  GHashTableIter iter;
-  gpointer       val;
+  /* Find furthest away session timeout */
+  tick_t maxtime = cka_deadline_get_maximum();
 
-  g_hash_table_iter_init(&iter, cka_clients_lut);
-  while( g_hash_table_iter_next(&iter, 0, &val) )
+  if( maxtime < cka_clients_wakeup_timeout )
   {
-    cka_client_t *client = val;
+    maxtime = cka_clients_wakeup_timeout;
+  }
 
-    cka_client_scan_timeout(client);
+  static tick_t oldtime = 0;
 
-    if( maxtime < client->cli_timeout )
+  if( maxtime <= now )
+  {
+    /* Remove existing timer */
+    if( cka_state_timer_id != 0 )
     {
-      maxtime = client->cli_timeout;
+      g_source_remove(cka_state_timer_id), cka_state_timer_id = 0;
     }
+    cka_state_timer_due = 0;
   }
-
-  /* Remove existing timer */
-  if( cka_state_timer_id != 0 )
-  {
-    g_source_remove(cka_state_timer_id), cka_state_timer_id = 0;
-  }
-
-  /* If needed, program timer */
-  static tick_t oldtime = 0;
-
-  if( now < maxtime )
+  else if( cka_state_timer_id == 0 || maxtime < cka_state_timer_due )
   {
-    if( maxtime != oldtime )
+    /* Program timer */
+    if( cka_state_timer_id != 0 )
     {
-      mce_log(LL_DEBUG, "cpu-keepalive timeout at T%+"PRId64"",
-              now - maxtime);
+      g_source_remove(cka_state_timer_id), cka_state_timer_id = 0;
     }
-    cka_state_timer_id = g_timeout_add(maxtime - now,
+    cka_state_timer_due = maxtime;
+    cka_state_timer_id = mce_timeout_add_slack(maxtime - now,
+                             MCE_CPU_KEEPALIVE_EXPIRY_SLACK_MS,
                              cka_state_timer_cb, 0);
   }
 
+  if( maxtime != oldtime && now < maxtime )
+  {
+    mce_log(LL_DEBUG, "cpu-keepalive timeout at T%+"PRId64"",
+            now - maxtime);
+  }
+
   oldtime = maxtime;
 
   cka_state_set(cka_state_timer_id != 0);
@@ -1600,6 +1948,7 @@ const gchar *g_module_check_init(GModule *module)
     goto EXIT;
   }
 
+  cka_deadline_init();
   cka_clients_init();
 
 EXIT:
@@ -1620,6 +1969,7 @@ void g_module_unload(GModule *module)
   /* If we have active clients, removal expects a valid dbus
    * connection -> purge clients first */
   cka_clients_quit();
+  cka_deadline_quit();
 
   cka_dbus_quit();
 
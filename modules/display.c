@@ -38,6 +38,7 @@
 #endif
 
 #include "../mce-worker.h"
+#include "../mce-sched.h"
 #include "../filewatcher.h"
 
 #ifdef ENABLE_WAKELOCKS
@@ -48,6 +49,8 @@
 
 #include <sys/ptrace.h>
 
+#include <linux/input.h>
+
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -55,6 +58,7 @@
 #include <fcntl.h>
 #include <glob.h>
 #include <pthread.h>
+#include <inttypes.h>
 
 #include <mce/dbus-names.h>
 #include <mce/mode-names.h>
@@ -101,6 +105,12 @@
 /** How long to delay entering late suspend after powering down display */
 #define MCE_DISPLAY_STM_SUSPEND_DELAY_NS (5LL * 1000LL * 1000LL * 1000LL)
 
+/** How long speculative display power up is held while power key is down */
+#define MCE_DISPLAY_SPECULATION_PRESS_MS 3000
+
+/** How long speculative display power up is held after power key release */
+#define MCE_DISPLAY_SPECULATION_RELEASE_MS 1000
+
 /** Placeholder value for unknown compositor pid */
 #define COMPOSITOR_STM_INVALID_PID (-1)
 
@@ -142,6 +152,13 @@
  */
 #define COMPOSITOR_STM_DBUS_RETRY_DELAY 5000
 
+/** How much compositor killing timeouts are allowed to fire late [ms]
+ *
+ * The kill delays are configured in seconds, aligning them with
+ * other wakeups does not make any practical difference.
+ */
+#define COMPOSITOR_STM_KILL_SLACK_MS 1000
+
 /* ========================================================================= *
  * TYPEDEFS
  * ========================================================================= */
@@ -397,6 +414,7 @@ static void                mdy_datapipe_call_state_trigger_cb(gconstpointer data
 static void                mdy_datapipe_device_inactive_cb(gconstpointer data);
 static void                mdy_datapipe_orientation_state_cb(gconstpointer data);
 static void                mdy_datapipe_shutting_down_cb(gconstpointer aptr);
+static void                mdy_datapipe_input_event_cb(gconstpointer const data);
 
 static void                mdy_datapipe_init(void);
 static void                mdy_datapipe_quit(void);
@@ -772,6 +790,12 @@ static bool                mdy_stm_is_fb_suspend_finished(void);
 static void                mdy_stm_start_fb_resume(void);
 static bool                mdy_stm_is_fb_resume_finished(void);
 
+// speculative frame buffer power up on power key press
+static gboolean            mdy_stm_speculation_timer_cb(gpointer aptr);
+static void                mdy_stm_speculation_start(int hold_ms);
+static void                mdy_stm_speculation_stop(void);
+static bool                mdy_stm_speculation_rethink(void);
+
 static void                mdy_stm_release_wakelock(void);
 static void                mdy_stm_acquire_wakelock(void);
 
@@ -797,6 +821,13 @@ static void                mdy_stm_force_rethink(void);
 
 static void                mdy_statistics_update(void);
 
+static int                 mdy_statistics_latency_bucket(int64_t ms);
+static void                mdy_statistics_latency_add(const char *name, int64_t ms);
+static void                mdy_statistics_transition_begin(display_state_t prev, display_state_t next);
+static void                mdy_statistics_transition_end(void);
+static void                mdy_statistics_transition_step(stm_state_t state);
+static void                mdy_statistics_quit(void);
+
 /* ------------------------------------------------------------------------- *
  * CPU_SCALING_GOVERNOR
  * ------------------------------------------------------------------------- */
@@ -809,6 +840,12 @@ static void                mdy_governor_set_state(int state);
 static void                mdy_governor_rethink(void);
 static void                mdy_governor_setting_cb(GConfClient *const client, const guint id, GConfEntry *const entry, gpointer const data);
 
+static void                mdy_governor_boost_start(const char *reason);
+static void                mdy_governor_boost_stop(void);
+static gboolean            mdy_governor_boost_end_cb(gpointer aptr);
+static void                mdy_governor_boost_init(void);
+static void                mdy_governor_boost_quit(void);
+
 /* ------------------------------------------------------------------------- *
  * DBUS_HANDLERS
  * ------------------------------------------------------------------------- */
@@ -842,6 +879,7 @@ static gboolean            mdy_dbus_handle_cabc_mode_set_req(DBusMessage *const
 static gboolean            mdy_dbus_handle_blanking_pause_start_req(DBusMessage *const msg);
 static gboolean            mdy_dbus_handle_blanking_pause_cancel_req(DBusMessage *const msg);
 static gboolean            mdy_dbus_handle_display_stats_get_req(DBusMessage *const req);
+static gboolean            mdy_dbus_handle_transition_stats_get_req(DBusMessage *const req);
 
 static gboolean            mdy_dbus_handle_desktop_started_sig(DBusMessage *const msg);
 static gboolean            mdy_dbus_timed_wakeup_sig(DBusMessage *const msg);
@@ -1081,6 +1119,10 @@ static gint mdy_psm_disp_brightness = -1;
 static gint  mdy_disp_never_blank = MCE_DEFAULT_DISPLAY_NEVER_BLANK;
 static guint mdy_disp_never_blank_setting_id = 0;
 
+/** Speculative display power up on power key press setting */
+static gboolean mdy_speculative_power_up = MCE_DEFAULT_DISPLAY_SPECULATIVE_POWER_UP;
+static guint    mdy_speculative_power_up_setting_id = 0;
+
 /** Use adaptive timeouts for dimming */
 static gboolean mdy_adaptive_dimming_enabled = MCE_DEFAULT_DISPLAY_ADAPTIVE_DIMMING;
 static guint    mdy_adaptive_dimming_enabled_setting_id = 0;
@@ -1481,6 +1523,16 @@ UPDATE:
 static void mdy_datapipe_display_state_req_cb(gconstpointer data)
 {
     display_state_t next_state = GPOINTER_TO_INT(data);
+
+#ifdef ENABLE_CPU_GOVERNOR
+    /* Boost cpu for the duration of unblanking, regardless of
+     * what triggered it */
+    if( (next_state == MCE_DISPLAY_ON || next_state == MCE_DISPLAY_DIM) &&
+        display_state_next != MCE_DISPLAY_ON &&
+        display_state_next != MCE_DISPLAY_DIM )
+        mdy_governor_boost_start("unblank request");
+#endif
+
     switch( next_state ) {
     case MCE_DISPLAY_OFF:
     case MCE_DISPLAY_LPM_OFF:
@@ -1557,6 +1609,54 @@ EXIT:
     return;
 }
 
+/** Handle keypress_pipe and touchscreen_pipe notifications
+ *
+ * Used for starting frame buffer power up and boosting cpu
+ * frequency as early as possible when the device is being
+ * woken up.
+ *
+ * @param data input_event pointer (as pointer to pointer)
+ */
+static void mdy_datapipe_input_event_cb(gconstpointer const data)
+{
+    const struct input_event *const*evp;
+    const struct input_event       *ev;
+
+    if( !(evp = data) )
+        goto EXIT;
+
+    if( !(ev = *evp) )
+        goto EXIT;
+
+    if( ev->type == EV_KEY && ev->code == KEY_POWER ) {
+        if( ev->value == 1 )
+            mdy_stm_speculation_start(MCE_DISPLAY_SPECULATION_PRESS_MS);
+        else if( ev->value == 0 )
+            mdy_stm_speculation_start(MCE_DISPLAY_SPECULATION_RELEASE_MS);
+    }
+
+#ifdef ENABLE_CPU_GOVERNOR
+    /* Boosting is needed only while waking up */
+    switch( display_state_next ) {
+    case MCE_DISPLAY_ON:
+    case MCE_DISPLAY_DIM:
+        goto EXIT;
+    default:
+        break;
+    }
+
+    if( ev->type == EV_KEY && ev->code == KEY_POWER && ev->value == 1 )
+        mdy_governor_boost_start("power key");
+    else if( ev->type == EV_MSC && ev->code == MSC_GESTURE )
+        mdy_governor_boost_start("gesture");
+    else if( ev->type == EV_KEY && ev->code == BTN_TOUCH && ev->value == 1 )
+        mdy_governor_boost_start("touch");
+#endif
+
+EXIT:
+    return;
+}
+
 /**
  * Handle touchscreen detections.
  *
@@ -2092,6 +2192,16 @@ static datapipe_handler_t mdy_datapipe_handlers[] =
         .datapipe  = &touch_detected_pipe,
         .output_cb = mdy_datapipe_touch_detected_cb,
     },
+    {
+        .datapipe  = &keypress_pipe,
+        .output_cb = mdy_datapipe_input_event_cb,
+    },
+#ifdef ENABLE_CPU_GOVERNOR
+    {
+        .datapipe  = &touchscreen_pipe,
+        .output_cb = mdy_datapipe_input_event_cb,
+    },
+#endif
     {
         .datapipe  = &packagekit_locked_pipe,
         .output_cb = mdy_datapipe_packagekit_locked_cb,
@@ -2524,60 +2634,12 @@ static void mdy_brightness_set_level(int number)
  */
 static void mdy_brightness_set_priority_boost(bool enable)
 {
-    /* Initialize cached state to default scheduler */
-    static int normal_scheduler = SCHED_OTHER;
-    static int normal_priority  = 0;
-
-    /* Initially boosted priority is not in use */
-    static bool is_enabled = false;
-
-    if( is_enabled == enable )
-        goto EXIT;
-
-    int scheduler = SCHED_OTHER;
-
-    struct sched_param param;
-    memset(&param, 0, sizeof param);
-
-    if( enable ) {
-        /* Cache current scheduling parameters */
-        if( (scheduler = sched_getscheduler(0)) == -1 )
-            mce_log(LL_WARN, "sched_getscheduler: %m");
-        else if( sched_getparam(0, &param) == -1 )
-            mce_log(LL_WARN, "sched_getparam: %m");
-        else {
-            normal_scheduler = scheduler;
-            normal_priority = param.sched_priority;
-        }
-
-        /* Switch to medium priority fifo scheduling */
-        scheduler = SCHED_FIFO;
-        param.sched_priority = (sched_get_priority_min(scheduler) +
-                                sched_get_priority_max(scheduler)) / 2;
-    }
-    else {
-        /* Switch back to cached scheduling parameters */
-        scheduler = normal_scheduler;
-        param.sched_priority = normal_priority;
-    }
-
-    mce_log(LL_DEBUG, "sched=%d, prio=%d", scheduler, param.sched_priority);
-
-    if( sched_setscheduler(0, scheduler, &param) == -1 ) {
-        static bool warned = false;
-        if( !warned ) {
-            warned = true;
-            mce_log(LL_WARN, "can't %s high priority mode: %m",
-                    enable ? "enter" : "leave");
-        }
-    }
-
-    /* The logical change is made even if we fail to actually change
-     * the scheduling parameters */
-    is_enabled = enable;
-
-EXIT:
-    return;
+    /* Fade timer is stopped explicitly, the expiry delay just
+     * makes sure the boost does not get stuck on */
+    if( enable )
+        mce_sched_boost_start("display_fade", 0);
+    else
+        mce_sched_boost_stop("display_fade");
 }
 
 /** Helper for cancelling brightness fade and forcing a brightness level
@@ -6068,9 +6130,10 @@ compositor_stm_schedule_killer(compositor_stm_t *self)
 
     mce_log(LL_DEBUG, "schedule compositor killer");
 
-    self->csi_kill_timer_id = g_timeout_add(mdy_compositor_core_delay * 1000,
-                                            compositor_stm_core_timer_cb,
-                                            self);
+    self->csi_kill_timer_id =
+        mce_timeout_add_slack(mdy_compositor_core_delay * 1000,
+                              COMPOSITOR_STM_KILL_SLACK_MS,
+                              compositor_stm_core_timer_cb, self);
 
 EXIT:
     return;
@@ -6136,9 +6199,10 @@ compositor_stm_core_timer_cb(void *aptr)
     if( kill(self->csi_service_pid, SIGXCPU) == -1 && errno == ESRCH )
         goto EXIT;
 
-    self->csi_kill_timer_id = g_timeout_add(mdy_compositor_kill_delay * 1000,
-                                            compositor_stm_kill_timer_cb,
-                                            self);
+    self->csi_kill_timer_id =
+        mce_timeout_add_slack(mdy_compositor_kill_delay * 1000,
+                              COMPOSITOR_STM_KILL_SLACK_MS,
+                              compositor_stm_kill_timer_cb, self);
 
 EXIT:
     return FALSE;
@@ -6164,9 +6228,10 @@ compositor_stm_kill_timer_cb(void *aptr)
     if( kill(self->csi_service_pid, SIGKILL) == -1 && errno == ESRCH )
         goto EXIT;
 
-    self->csi_kill_timer_id = g_timeout_add(mdy_compositor_bury_delay * 1000,
-                                            compositor_stm_bury_timer_cb,
-                                            self);
+    self->csi_kill_timer_id =
+        mce_timeout_add_slack(mdy_compositor_bury_delay * 1000,
+                              COMPOSITOR_STM_KILL_SLACK_MS,
+                              compositor_stm_bury_timer_cb, self);
 
 EXIT:
     return FALSE;
@@ -7588,6 +7653,129 @@ static bool mdy_stm_is_fb_resume_finished(void)
     return res;
 }
 
+/** Flag for: speculative frame buffer power up is wanted */
+static bool mdy_stm_speculation_wanted = false;
+
+/** Flag for: frame buffer has been speculatively powered up */
+static bool mdy_stm_speculation_active = false;
+
+/** Flag for: speculative power up roll back has not finished yet */
+static bool mdy_stm_speculation_rollback = false;
+
+/** Timer id for ending speculative frame buffer power up */
+static guint mdy_stm_speculation_timer_id = 0;
+
+/** Timer callback for ending speculative frame buffer power up
+ *
+ * @param aptr (unused) user data pointer
+ *
+ * @return FALSE to stop the timer from repeating
+ */
+static gboolean mdy_stm_speculation_timer_cb(gpointer aptr)
+{
+    (void)aptr;
+
+    if( !mdy_stm_speculation_timer_id )
+        goto EXIT;
+
+    mdy_stm_speculation_timer_id = 0;
+
+    mce_log(LL_DEBUG, "speculative power up timeout");
+    mdy_stm_speculation_stop();
+
+EXIT:
+    return FALSE;
+}
+
+/** Request speculative frame buffer power up
+ *
+ * Called on power key press / release. If the display is
+ * off, frame buffer power up is started while power key handling
+ * decides whether the display should be turned on or not.
+ *
+ * If the display does not get turned on before hold time expires,
+ * the frame buffer is powered off again.
+ *
+ * @param hold_ms how long to keep frame buffer powered up [ms]
+ */
+static void mdy_stm_speculation_start(int hold_ms)
+{
+    if( !mdy_speculative_power_up )
+        goto EXIT;
+
+    /* Applicable only when display is off / going to be off */
+    switch( display_state_next ) {
+    case MCE_DISPLAY_OFF:
+    case MCE_DISPLAY_LPM_OFF:
+        break;
+    default:
+        goto EXIT;
+    }
+
+    /* Do not bother if power key is going to be ignored anyway */
+    if( proximity_state == COVER_CLOSED )
+        goto EXIT;
+
+    if( mdy_stm_speculation_timer_id )
+        g_source_remove(mdy_stm_speculation_timer_id);
+    mdy_stm_speculation_timer_id =
+        g_timeout_add(hold_ms, mdy_stm_speculation_timer_cb, 0);
+
+    if( !mdy_stm_speculation_wanted ) {
+        mce_log(LL_DEBUG, "speculative power up requested");
+        mdy_stm_speculation_wanted = true;
+        mdy_stm_schedule_rethink();
+    }
+
+EXIT:
+    return;
+}
+
+/** Cancel speculative frame buffer power up
+ *
+ * If the frame buffer has already been powered up and the display
+ * state machine has not made use of it, it is powered back off.
+ */
+static void mdy_stm_speculation_stop(void)
+{
+    if( mdy_stm_speculation_timer_id ) {
+        g_source_remove(mdy_stm_speculation_timer_id),
+            mdy_stm_speculation_timer_id = 0;
+    }
+
+    if( mdy_stm_speculation_wanted ) {
+        mce_log(LL_DEBUG, "speculative power up canceled");
+        mdy_stm_speculation_wanted = false;
+        mdy_stm_schedule_rethink();
+    }
+}
+
+/** Apply speculative frame buffer power up / roll back
+ *
+ * Must be called only from STM_STAY_POWER_OFF state.
+ *
+ * @return true if speculative power up is active, false otherwise
+ */
+static bool mdy_stm_speculation_rethink(void)
+{
+    if( mdy_stm_speculation_active == mdy_stm_speculation_wanted )
+        goto EXIT;
+
+    if( (mdy_stm_speculation_active = mdy_stm_speculation_wanted) ) {
+        mce_log(LL_NOTICE, "speculative power up");
+        mdy_stm_speculation_rollback = false;
+        mdy_stm_start_fb_resume();
+    }
+    else {
+        mce_log(LL_NOTICE, "speculative power up rolled back");
+        mdy_stm_speculation_rollback = true;
+        mdy_stm_start_fb_suspend();
+    }
+
+EXIT:
+    return mdy_stm_speculation_active;
+}
+
 /** Release display wakelock to allow late suspend
  */
 static void mdy_stm_release_wakelock(void)
@@ -7622,6 +7810,7 @@ static void mdy_stm_trans(stm_state_t state)
         mce_log(LL_INFO, "STM: %s -> %s",
                 mdy_stm_state_name(mdy_stm_dstate),
                 mdy_stm_state_name(state));
+        mdy_statistics_transition_step(mdy_stm_dstate);
         mdy_stm_dstate = state;
     }
 }
@@ -7664,6 +7853,10 @@ static bool mdy_stm_pull_target_change(void)
     }
 
     // do pre-transition actions
+    mdy_statistics_transition_begin(mdy_stm_curr, mdy_stm_next);
+    if( mdy_stm_display_state_needs_power(mdy_stm_next) &&
+        !mdy_stm_display_state_needs_power(mdy_stm_curr) )
+        mce_sched_boost_start("display_power_up", 0);
     mdy_display_state_leave(mdy_stm_curr, mdy_stm_next);
     return true;
 }
@@ -7676,6 +7869,8 @@ static void mdy_stm_finish_target_change(void)
     display_state_t prev = mdy_stm_curr;
     mdy_stm_curr = mdy_stm_next;
     mdy_display_state_enter(prev, mdy_stm_curr);
+    mdy_statistics_transition_end();
+    mce_sched_boost_stop("display_power_up");
 }
 
 /** Execute one state machine step
@@ -7861,6 +8056,15 @@ static void mdy_stm_step(void)
         break;
 
     case STM_STAY_POWER_OFF:
+        /* Wait for speculative power up / roll back to finish */
+        if( mdy_stm_speculation_active || mdy_stm_speculation_rollback ) {
+            if( mdy_stm_autosuspend_pending )
+                break;
+
+            if( mdy_stm_fbdev_pending_set_power )
+                break;
+        }
+
         if( mdy_stm_pull_target_change() ) {
             mdy_stm_trans(STM_LEAVE_POWER_OFF);
             break;
@@ -7871,6 +8075,23 @@ static void mdy_stm_step(void)
             break;
         }
 
+        /* Frame buffer must not be left powered on over late suspend */
+        if( mdy_stm_speculation_rethink() ) {
+            /* Cancel fbdev led timer when resumed */
+            mdy_stm_is_fb_resume_finished();
+            mdy_stm_acquire_wakelock();
+            break;
+        }
+
+        /* Roll back must finish before late suspend is allowed */
+        if( mdy_stm_speculation_rollback ) {
+            /* Received frame buffer sleep notification? */
+            if( !mdy_stm_is_fb_suspend_finished() )
+                break;
+
+            mdy_stm_speculation_rollback = false;
+        }
+
         /* FIXME: Need separate states for stopping/starting
          *        sensors during suspend/resume */
 
@@ -7896,7 +8117,16 @@ static void mdy_stm_step(void)
         break;
 
     case STM_INIT_RESUME:
-        mdy_stm_start_fb_resume();
+        if( mdy_stm_speculation_active ) {
+            /* Frame buffer power up has already been started */
+            mce_log(LL_NOTICE, "speculative power up committed");
+            mdy_stm_speculation_active = false;
+            mdy_stm_speculation_stop();
+        }
+        else {
+            mdy_stm_start_fb_resume();
+        }
+        mdy_stm_speculation_rollback = false;
         mdy_stm_trans(STM_WAIT_RESUME);
         break;
 
@@ -8134,6 +8364,170 @@ static void mdy_statistics_update(void)
     prev_update = now;
 }
 
+/** Number of buckets in display state transition latency histograms
+ *
+ * Bucket 0 holds durations below 1 ms, bucket N durations in
+ * [2^(N-1), 2^N) ms range, and the last bucket everything longer.
+ */
+#define MDY_LATENCY_BUCKETS MCE_DISPLAY_TRANSITION_STATS_BUCKETS
+
+/** Statistics: Duration of display state transitions and their steps */
+typedef struct
+{
+    int64_t         count;
+    int64_t         sum_ms;
+    int64_t         min_ms;
+    int64_t         max_ms;
+    int64_t         hist[MDY_LATENCY_BUCKETS];
+} mdy_latency_t;
+
+/** Lookup table: "FROM->TO" / "FROM->TO:STEP" -> mdy_latency_t */
+static GHashTable *mdy_statistics_latency_lut = 0;
+
+/** Display state transition being measured */
+static display_state_t mdy_statistics_transition_prev = MCE_DISPLAY_UNDEF;
+static display_state_t mdy_statistics_transition_next = MCE_DISPLAY_UNDEF;
+
+/** Boot tick when display state transition was started, or zero */
+static int64_t mdy_statistics_transition_started = 0;
+
+/** Boot tick when the current state machine step was entered, or zero */
+static int64_t mdy_statistics_step_started = 0;
+
+/** Map duration to latency histogram bucket
+ *
+ * @param ms  duration in milliseconds
+ *
+ * @return histogram bucket index
+ */
+static int mdy_statistics_latency_bucket(int64_t ms)
+{
+    int bucket = 0;
+
+    while( ms > 0 && bucket < MDY_LATENCY_BUCKETS - 1 )
+        ms >>= 1, ++bucket;
+
+    return bucket;
+}
+
+/** Accumulate a latency sample
+ *
+ * @param name  name of the measured transition / step
+ * @param ms    duration in milliseconds
+ */
+static void mdy_statistics_latency_add(const char *name, int64_t ms)
+{
+    mdy_latency_t *lat = 0;
+
+    if( !mdy_statistics_latency_lut ) {
+        mdy_statistics_latency_lut =
+            g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    }
+
+    lat = g_hash_table_lookup(mdy_statistics_latency_lut, name);
+
+    if( !lat ) {
+        lat = g_malloc0(sizeof *lat);
+        lat->min_ms = ms;
+        lat->max_ms = ms;
+        g_hash_table_replace(mdy_statistics_latency_lut, g_strdup(name), lat);
+    }
+
+    lat->count  += 1;
+    lat->sum_ms += ms;
+
+    if( lat->min_ms > ms )
+        lat->min_ms = ms;
+
+    if( lat->max_ms < ms )
+        lat->max_ms = ms;
+
+    lat->hist[mdy_statistics_latency_bucket(ms)] += 1;
+}
+
+/** Start measuring display state transition
+ *
+ * @param prev  display state we are leaving
+ * @param next  display state we are heading to
+ */
+static void mdy_statistics_transition_begin(display_state_t prev,
+                                            display_state_t next)
+{
+    int64_t now = mce_lib_get_boot_tick();
+
+    mdy_statistics_transition_prev    = prev;
+    mdy_statistics_transition_next    = next;
+    mdy_statistics_transition_started = now;
+    mdy_statistics_step_started       = now;
+}
+
+/** Finish measuring display state transition
+ */
+static void mdy_statistics_transition_end(void)
+{
+    if( !mdy_statistics_transition_started )
+        goto EXIT;
+
+    int64_t now = mce_lib_get_boot_tick();
+    char    name[64];
+
+    snprintf(name, sizeof name, "%s->%s",
+             display_state_repr(mdy_statistics_transition_prev),
+             display_state_repr(mdy_statistics_transition_next));
+
+    mdy_statistics_latency_add(name, now - mdy_statistics_transition_started);
+
+    mce_log(LL_DEBUG, "%s took %"PRId64" ms", name,
+            now - mdy_statistics_transition_started);
+
+    mdy_statistics_transition_started = 0;
+
+EXIT:
+    return;
+}
+
+/** Account time spent in a display state machine step
+ *
+ * @param state  state machine state that is being left
+ */
+static void mdy_statistics_transition_step(stm_state_t state)
+{
+    int64_t now = mce_lib_get_boot_tick();
+
+    switch( state ) {
+    case STM_UNSET:
+    case STM_STAY_POWER_ON:
+    case STM_STAY_POWER_OFF:
+    case STM_STAY_LOGICAL_OFF:
+        /* Stable states are not part of any transition */
+        break;
+
+    default:
+        if( !mdy_statistics_step_started )
+            break;
+
+        char name[96];
+        snprintf(name, sizeof name, "%s->%s:%s",
+                 display_state_repr(mdy_statistics_transition_prev),
+                 display_state_repr(mdy_statistics_transition_next),
+                 mdy_stm_state_name(state));
+        mdy_statistics_latency_add(name, now - mdy_statistics_step_started);
+        break;
+    }
+
+    mdy_statistics_step_started = now;
+}
+
+/** Release display state transition statistics
+ */
+static void mdy_statistics_quit(void)
+{
+    if( mdy_statistics_latency_lut ) {
+        g_hash_table_unref(mdy_statistics_latency_lut),
+            mdy_statistics_latency_lut = 0;
+    }
+}
+
 /* ========================================================================= *
  * CPU_SCALING_GOVERNOR
  * ========================================================================= */
@@ -8198,11 +8592,11 @@ static governor_setting_t *mdy_governor_get_settings(const char *tag)
 
         if( used == have ) {
             have += 8;
-            res = realloc(res, have * sizeof *res);
+            res = g_renew(governor_setting_t, res, have);
         }
 
-        res[used].path = strdup(path);
-        res[used].data = strdup(data);
+        res[used].path = g_strdup(path);
+        res[used].data = g_strdup(data);
         ++used;
         mce_log(LL_DEBUG, "%s[%zd]: echo > %s %s",
                 sec, used, path, data);
@@ -8214,7 +8608,7 @@ static governor_setting_t *mdy_governor_get_settings(const char *tag)
 
 EXIT:
     have = used + 1;
-    res = realloc(res, have * sizeof *res);
+    res = g_renew(governor_setting_t, res, have);
 
     res[used].path = 0;
     res[used].data = 0;
@@ -8230,10 +8624,10 @@ static void mdy_governor_free_settings(governor_setting_t *settings)
 {
     if( settings ) {
         for( size_t i = 0; settings[i].path; ++i ) {
-            free(settings[i].path);
-            free(settings[i].data);
+            g_free(settings[i].path);
+            g_free(settings[i].data);
         }
-        free(settings);
+        g_free(settings);
     }
 }
 
@@ -8359,6 +8753,10 @@ static void mdy_governor_set_state(int state)
 {
     const governor_setting_t *settings = 0;
 
+    /* Restore values overridden by input boost before
+     * applying the new state */
+    mdy_governor_boost_stop();
+
     switch( state )
     {
     case GOVERNOR_DEFAULT:
@@ -8451,6 +8849,196 @@ static void mdy_governor_setting_cb(GConfClient *const client, const guint id,
         mdy_governor_rethink();
     }
 }
+
+/* ------------------------------------------------------------------------- *
+ * Input boost
+ *
+ * When the device is woken up via power key, double tap or touch, the
+ * cpu is likely to be parked at the lowest operating point. To make
+ * unblanking faster, settings from [CPUScalingGovernorBoost] config
+ * group - for example raised scaling_min_freq - are applied for a
+ * while. The values that were in place before are restored when the
+ * boost ends.
+ *
+ *   [CPUScalingGovernorBoost]
+ *   Duration=1000
+ *   path1=/sys/devices/system/cpu/cpufreq/policy0/scaling_min_freq
+ *   data1=1190400
+ * ------------------------------------------------------------------------- */
+
+/** Name of the input boost configuration group */
+#define GOVERNOR_BOOST_GROUP "CPUScalingGovernorBoost"
+
+/** Default input boost duration [ms] */
+#define GOVERNOR_BOOST_DEFAULT_DURATION 1000
+
+/** Input boost CPU scaling settings */
+static governor_setting_t *mdy_governor_boost = 0;
+
+/** Values to write back when input boost ends, or NULL */
+static governor_setting_t *mdy_governor_boost_restore = 0;
+
+/** How long input boost is kept active [ms] */
+static gint mdy_governor_boost_duration = GOVERNOR_BOOST_DEFAULT_DURATION;
+
+/** Timer id for ending input boost */
+static guint mdy_governor_boost_end_id = 0;
+
+/** Timer callback for ending input boost
+ *
+ * @param aptr (not used)
+ *
+ * @return FALSE to stop the timer from repeating
+ */
+static gboolean mdy_governor_boost_end_cb(gpointer aptr)
+{
+    (void)aptr;
+
+    if( mdy_governor_boost_end_id ) {
+        mdy_governor_boost_end_id = 0;
+        mce_log(LL_DEBUG, "input boost ended");
+        mdy_governor_boost_stop();
+    }
+
+    return FALSE;
+}
+
+/** Apply input boost settings, or extend already active boost
+ *
+ * @param reason human readable trigger description, for debugging
+ */
+static void mdy_governor_boost_start(const char *reason)
+{
+    size_t have = 0;
+    size_t used = 0;
+
+    if( !mdy_governor_boost || !mdy_governor_boost->path )
+        goto EXIT;
+
+    /* Restart timer when already boosting */
+    if( mdy_governor_boost_end_id ) {
+        g_source_remove(mdy_governor_boost_end_id);
+        goto SCHEDULE;
+    }
+
+    mce_log(LL_DEBUG, "input boost started: %s", reason);
+
+    for( const governor_setting_t *setting = mdy_governor_boost;
+         setting->path; ++setting ) {
+        glob_t gb;
+
+        memset(&gb, 0, sizeof gb);
+
+        if( glob(setting->path, 0, 0, &gb) != 0 ) {
+            mce_log(LL_WARN, "%s: no matches found", setting->path);
+            globfree(&gb);
+            continue;
+        }
+
+        for( size_t i = 0; i < gb.gl_pathc; ++i ) {
+            gchar *data = 0;
+
+            /* Remember the current value so that it can be restored */
+            if( !mce_read_string_from_file(gb.gl_pathv[i], &data) )
+                continue;
+
+            g_strstrip(data);
+
+            if( !mdy_governor_write_data(gb.gl_pathv[i], setting->data) ) {
+                g_free(data);
+                continue;
+            }
+
+            if( used + 1 >= have ) {
+                have += 8;
+                mdy_governor_boost_restore =
+                    g_renew(governor_setting_t,
+                            mdy_governor_boost_restore, have);
+            }
+
+            mdy_governor_boost_restore[used].path = g_strdup(gb.gl_pathv[i]);
+            mdy_governor_boost_restore[used].data = g_strdup(data);
+            ++used;
+
+            mce_log(LL_DEBUG, "boost \"%s\" -> \"%s\" to: %s",
+                    data, setting->data, gb.gl_pathv[i]);
+            g_free(data);
+        }
+
+        globfree(&gb);
+    }
+
+    if( !mdy_governor_boost_restore )
+        goto EXIT;
+
+    mdy_governor_boost_restore[used].path = 0;
+    mdy_governor_boost_restore[used].data = 0;
+
+SCHEDULE:
+    mdy_governor_boost_end_id =
+        g_timeout_add(mdy_governor_boost_duration,
+                      mdy_governor_boost_end_cb, 0);
+
+EXIT:
+    return;
+}
+
+/** Restore values that were in place before input boost was applied
+ */
+static void mdy_governor_boost_stop(void)
+{
+    if( mdy_governor_boost_end_id ) {
+        g_source_remove(mdy_governor_boost_end_id),
+            mdy_governor_boost_end_id = 0;
+    }
+
+    if( !mdy_governor_boost_restore )
+        goto EXIT;
+
+    /* Restore in reverse order, in case the same file was written
+     * multiple times */
+    size_t count = 0;
+    while( mdy_governor_boost_restore[count].path )
+        ++count;
+
+    while( count-- > 0 ) {
+        const governor_setting_t *setting = mdy_governor_boost_restore + count;
+        if( mdy_governor_write_data(setting->path, setting->data) ) {
+            mce_log(LL_DEBUG, "restored \"%s\" to: %s",
+                    setting->data, setting->path);
+        }
+    }
+
+    mdy_governor_free_settings(mdy_governor_boost_restore),
+        mdy_governor_boost_restore = 0;
+
+EXIT:
+    return;
+}
+
+/** Get input boost configuration from mce ini-files
+ */
+static void mdy_governor_boost_init(void)
+{
+    mdy_governor_boost = mdy_governor_get_settings("Boost");
+
+    mdy_governor_boost_duration =
+        mce_conf_get_int(GOVERNOR_BOOST_GROUP, "Duration",
+                         GOVERNOR_BOOST_DEFAULT_DURATION);
+
+    if( mdy_governor_boost_duration < 1 )
+        mdy_governor_boost_duration = GOVERNOR_BOOST_DEFAULT_DURATION;
+}
+
+/** End active input boost and release configuration
+ */
+static void mdy_governor_boost_quit(void)
+{
+    mdy_governor_boost_stop();
+
+    mdy_governor_free_settings(mdy_governor_boost),
+        mdy_governor_boost = 0;
+}
 #endif /* ENABLE_CPU_GOVERNOR */
 
 /* ========================================================================= *
@@ -9390,6 +9978,136 @@ EXIT:
     return TRUE;
 }
 
+/** D-Bus callback for the get display transition statistics method call
+ *
+ * Each entry holds: sample count, minimum, maximum and total duration
+ * in milliseconds, and a MDY_LATENCY_BUCKETS slot log2 histogram.
+ *
+ * @param req The D-Bus method call message to be replied
+ *
+ * @return TRUE
+ */
+static gboolean mdy_dbus_handle_transition_stats_get_req(DBusMessage *const req)
+{
+    DBusMessage      *rsp  = 0;
+    GList            *keys = 0;
+    DBusMessageIter  body;
+    DBusMessageIter  array;
+    DBusMessageIter  dict;
+    DBusMessageIter  entry;
+    DBusMessageIter  hist;
+
+    mce_log(LL_DEVEL, "display transition statistics req from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    if( dbus_message_get_no_reply(req) )
+        goto EXIT;
+
+    rsp = dbus_new_method_reply(req);
+
+    dbus_message_iter_init_append(rsp, &body);
+
+    if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+                                          DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                          DBUS_TYPE_STRING_AS_STRING
+                                          DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+                                          DBUS_TYPE_INT64_AS_STRING
+                                          DBUS_TYPE_INT64_AS_STRING
+                                          DBUS_TYPE_INT64_AS_STRING
+                                          DBUS_TYPE_INT64_AS_STRING
+                                          DBUS_TYPE_ARRAY_AS_STRING
+                                          DBUS_TYPE_INT64_AS_STRING
+                                          DBUS_STRUCT_END_CHAR_AS_STRING
+                                          DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
+                                          &array) )
+        goto EXIT;
+
+    if( mdy_statistics_latency_lut ) {
+        keys = g_hash_table_get_keys(mdy_statistics_latency_lut);
+        keys = g_list_sort(keys, (GCompareFunc)strcmp);
+    }
+
+    for( GList *item = keys; item; item = item->next ) {
+        const char    *name = item->data;
+        mdy_latency_t *lat  = g_hash_table_lookup(mdy_statistics_latency_lut,
+                                                  name);
+        dbus_any_t dta;
+
+        if( !dbus_message_iter_open_container(&array, DBUS_TYPE_DICT_ENTRY,
+                                              0, &dict) )
+            goto ABANDON_ARRAY;
+
+        dta.s = name;
+        if( !dbus_message_iter_append_basic(&dict, DBUS_TYPE_STRING, &dta) )
+            goto ABANDON_DICT;
+
+        if( !dbus_message_iter_open_container(&dict, DBUS_TYPE_STRUCT,
+                                              0, &entry) )
+            goto ABANDON_DICT;
+
+        dta.i64 = lat->count;
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64,  &dta) )
+            goto ABANDON_ENTRY;
+
+        dta.i64 = lat->min_ms;
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64,  &dta) )
+            goto ABANDON_ENTRY;
+
+        dta.i64 = lat->max_ms;
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64,  &dta) )
+            goto ABANDON_ENTRY;
+
+        dta.i64 = lat->sum_ms;
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64,  &dta) )
+            goto ABANDON_ENTRY;
+
+        if( !dbus_message_iter_open_container(&entry, DBUS_TYPE_ARRAY,
+                                              DBUS_TYPE_INT64_AS_STRING,
+                                              &hist) )
+            goto ABANDON_ENTRY;
+
+        const dbus_int64_t *vec = lat->hist;
+        if( !dbus_message_iter_append_fixed_array(&hist, DBUS_TYPE_INT64,
+                                                  &vec, MDY_LATENCY_BUCKETS) ) {
+            dbus_message_iter_abandon_container(&entry, &hist);
+            goto ABANDON_ENTRY;
+        }
+
+        if( !dbus_message_iter_close_container(&entry, &hist) )
+            goto ABANDON_ENTRY;
+
+        if( !dbus_message_iter_close_container(&dict, &entry) )
+            goto ABANDON_DICT;
+
+        if( !dbus_message_iter_close_container(&array, &dict) )
+            goto ABANDON_ARRAY;
+    }
+
+    if( !dbus_message_iter_close_container(&body, &array) )
+        goto EXIT;
+
+    dbus_send_message(rsp), rsp = 0;
+
+    goto EXIT;
+
+ABANDON_ENTRY:
+    dbus_message_iter_abandon_container(&dict, &entry);
+
+ABANDON_DICT:
+    dbus_message_iter_abandon_container(&array, &dict);
+
+ABANDON_ARRAY:
+    dbus_message_iter_abandon_container(&body, &array);
+
+EXIT:
+    g_list_free(keys);
+
+    if( rsp )
+        dbus_message_unref(rsp);
+
+    return TRUE;
+}
+
 /**
  * D-Bus callback for the desktop startup notification signal
  *
@@ -9627,6 +10345,14 @@ static mce_dbus_handler_t mdy_dbus_handlers[] =
         .args      =
             "    <arg direction=\"out\" name=\"display_state_statistics\" type=\"a{s(xx)}\"/>\n"
     },
+    {
+        .interface = MCE_REQUEST_IF,
+        .name      = MCE_DISPLAY_TRANSITION_STATS_GET,
+        .type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback  = mdy_dbus_handle_transition_stats_get_req,
+        .args      =
+            "    <arg direction=\"out\" name=\"display_transition_statistics\" type=\"a{s(xxxxax)}\"/>\n"
+    },
     /* sentinel */
     {
         .interface = 0
@@ -10030,6 +10756,11 @@ static void mdy_setting_cb(GConfClient *const gcc, const guint id,
             mce_datapipe_req_display_state(MCE_DISPLAY_LPM_ON);
         }
     }
+    else if( id == mdy_speculative_power_up_setting_id ) {
+        mdy_speculative_power_up = gconf_value_get_bool(gcv);
+        if( !mdy_speculative_power_up )
+            mdy_stm_speculation_stop();
+    }
     else if (id == mdy_adaptive_dimming_enabled_setting_id) {
         mdy_adaptive_dimming_enabled = gconf_value_get_bool(gcv);
         mdy_blanking_reset_adaptive_dimming_delay();
@@ -10399,6 +11130,13 @@ static void mdy_setting_init(void)
                           mdy_setting_cb,
                           &mdy_disp_never_blank_setting_id);
 
+    /* Speculative display power up on power key press toggle */
+    mce_setting_track_bool(MCE_SETTING_DISPLAY_SPECULATIVE_POWER_UP,
+                           &mdy_speculative_power_up,
+                           MCE_DEFAULT_DISPLAY_SPECULATIVE_POWER_UP,
+                           mdy_setting_cb,
+                           &mdy_speculative_power_up_setting_id);
+
     /* Use adaptive display dim timeout toggle */
     mce_setting_track_bool(MCE_SETTING_DISPLAY_ADAPTIVE_DIMMING,
                            &mdy_adaptive_dimming_enabled,
@@ -10583,6 +11321,9 @@ static void mdy_setting_quit(void)
     mce_setting_notifier_remove(mdy_disp_never_blank_setting_id),
         mdy_disp_never_blank_setting_id = 0;
 
+    mce_setting_notifier_remove(mdy_speculative_power_up_setting_id),
+        mdy_speculative_power_up_setting_id = 0;
+
     mce_setting_notifier_remove(mdy_adaptive_dimming_enabled_setting_id),
         mdy_adaptive_dimming_enabled_setting_id = 0;
 
@@ -10740,6 +11481,7 @@ const gchar *g_module_check_init(GModule *module)
     /* Get CPU scaling governor settings from INI-files */
     mdy_governor_default = mdy_governor_get_settings("Default");
     mdy_governor_interactive = mdy_governor_get_settings("Interactive");
+    mdy_governor_boost_init();
 
     /* Get cpu scaling governor configuration & track changes */
     mce_setting_track_int(MCE_SETTING_CPU_SCALING_GOVERNOR,
@@ -10839,6 +11581,7 @@ void g_module_unload(GModule *module)
 
     /* Remove dbus message handlers */
     mdy_dbus_quit();
+    mdy_statistics_quit();
 
     /* Stop tracking setting changes */
     mdy_setting_quit();
@@ -10857,6 +11600,9 @@ void g_module_unload(GModule *module)
     mce_setting_notifier_remove(mdy_governor_conf_setting_id),
         mdy_governor_conf_setting_id = 0;
 
+    /* End input boost before switching back to defaults */
+    mdy_governor_boost_quit();
+
     /* Switch back to defaults */
     mdy_governor_rethink();
 
@@ -10897,6 +11643,9 @@ void g_module_unload(GModule *module)
      * it needs to be done 1st */
     mdy_compositor_quit();
 
+    /* Cancel speculative power up; can schedule state machine wakeup */
+    mdy_stm_speculation_stop();
+
     /* Cancel pending state machine updates */
     mdy_stm_cancel_rethink();
 
@@ -397,6 +397,17 @@
 # define MCE_SETTING_DISPLAY_NEVER_BLANK                 MCE_SETTING_DISPLAY_PATH "/display_never_blank"
 # define MCE_DEFAULT_DISPLAY_NEVER_BLANK                 0
 
+/** Whether display power up should be started on power key press
+ *
+ * When enabled, frame buffer power up is started already when power
+ * key is pressed down while display is off - instead of waiting for
+ * power key press to be classified as short / long / double press.
+ * If display does not get turned on within a short delay after the
+ * key is released, the frame buffer is powered back off.
+ */
+# define MCE_SETTING_DISPLAY_SPECULATIVE_POWER_UP        MCE_SETTING_DISPLAY_PATH "/speculative_power_up"
+# define MCE_DEFAULT_DISPLAY_SPECULATIVE_POWER_UP        false
+
 /** Inhibit type */
 typedef enum {
     /** Inhibit value invalid */
@@ -576,4 +587,19 @@ enum
 # define MCE_SETTING_LIPSTICK_CORE_DELAY                 MCE_SETTING_DISPLAY_PATH "/lipstick_core_dump_delay"
 # define MCE_DEFAULT_LIPSTICK_CORE_DELAY                 30
 
+/* ========================================================================= *
+ * D-Bus
+ * ========================================================================= */
+
+/** Query display state transition latency statistics
+ *
+ * Defined here until it becomes available in mce-dev
+ */
+# ifndef MCE_DISPLAY_TRANSITION_STATS_GET
+#  define MCE_DISPLAY_TRANSITION_STATS_GET       "get_display_transition_stats"
+# endif
+
+/** Number of log2 buckets in MCE_DISPLAY_TRANSITION_STATS_GET histograms */
+# define MCE_DISPLAY_TRANSITION_STATS_BUCKETS    16
+
 #endif /* DISPLAY_H_ */
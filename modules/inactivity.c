@@ -25,6 +25,7 @@
 #include "../mce-log.h"
 #include "../mce-dbus.h"
 #include "../mce-hbtimer.h"
+#include "../mce-lib.h"
 
 #ifdef ENABLE_WAKELOCKS
 # include "../libwakelock.h"
@@ -64,6 +65,9 @@ G_MODULE_EXPORT module_info_struct module_info = {
 /** Duration of suspend blocking after sending inactivity signals */
 #define MIA_KEEPALIVE_DURATION_MS 5000
 
+/** How much suspend blocking is allowed to last longer than nominal */
+#define MIA_KEEPALIVE_SLACK_MS 1000
+
 /* ========================================================================= *
  * PROTOTYPES
  * ========================================================================= */
@@ -756,8 +760,9 @@ static void mia_keepalive_start(void)
             mia_keepalive_id = 0;
     }
 
-    mia_keepalive_id = g_timeout_add(MIA_KEEPALIVE_DURATION_MS,
-                                     mia_keepalive_cb, 0);
+    mia_keepalive_id = mce_timeout_add_slack(MIA_KEEPALIVE_DURATION_MS,
+                                             MIA_KEEPALIVE_SLACK_MS,
+                                             mia_keepalive_cb, 0);
     mia_keepalive_rethink();
 }
 
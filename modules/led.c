@@ -77,10 +77,14 @@ G_MODULE_EXPORT module_info_struct module_info = {
 
 /** The pattern queue */
 static GQueue *pattern_stack = NULL;
+/** Lookup table for finding patterns by name */
+static GHashTable *pattern_lut = NULL;
 /** The pattern combination rule queue */
 static GQueue *combination_rule_list = NULL;
-/** The pattern combination rule queue */
-static GQueue *combination_rule_xref_list = NULL;
+/** Combination rules resolved to pattern objects */
+static GSList *combination_graph = NULL;
+/** Flag for: pattern changes might affect the active pattern */
+static gboolean active_pattern_dirty = TRUE;
 /** The D-Bus controlled LED switch */
 static gboolean led_enabled = FALSE;
 
@@ -157,9 +161,10 @@ typedef struct {
 	guint setting_id;		/**< Callback ID for GConf entry */
 	guint rgb_color;                /**< RGB24 data for libhybris use */
 	gboolean undecided;		/**< Flag for policy=6 lock in */
+	GSList *dependents;		/**< Rules having this as pre-requisite */
 } pattern_struct;
 
-/** Pattern combination rule struct; this is also used for cross-referencing */
+/** Pattern combination rule struct */
 typedef struct {
 	/** Name of the combined pattern */
 	gchar *rulename;
@@ -167,6 +172,21 @@ typedef struct {
 	GQueue *pre_requisites;
 } combination_rule_struct;
 
+/** Pattern combination rule resolved to pattern objects
+ *
+ * Instead of re-evaluating all pre-requisites whenever some pattern
+ * changes state, a count of active pre-requisites is maintained and
+ * the rule is satisfied when all of them are active.
+ */
+typedef struct {
+	/** The combined pattern */
+	pattern_struct *target;
+	/** Number of pre-requisite patterns */
+	guint required;
+	/** Number of currently active pre-requisite patterns */
+	guint satisfied;
+} combination_node_struct;
+
 /** Pointer to the top pattern */
 static pattern_struct *active_pattern = NULL;
 
@@ -218,6 +238,21 @@ typedef enum {
 #endif
 } led_type_t;
 
+#ifdef ENABLE_HYBRIS
+/** Number of color channels used for pattern trigger offload */
+#define LED_KPAT_CHANNELS 3
+
+/** Sysfs control paths for one pattern trigger capable led */
+typedef struct
+{
+	/** Led sysfs directory, e.g. /sys/class/leds/red */
+	gchar *dir;
+
+	/** Value read from max_brightness */
+	gint   max_brightness;
+} led_kpat_channel_t;
+#endif
+
 /**
  * The configuration group containing the LED pattern
  */
@@ -335,13 +370,26 @@ static void              njoy_program_led               (const pattern_struct *c
 static void              mono_program_led               (const pattern_struct *const pattern);
 static void              hybris_program_led             (const pattern_struct *const pattern);
 static void              program_led                    (const pattern_struct *const pattern);
+#ifdef ENABLE_HYBRIS
+static bool              led_kpat_probe_channel         (led_kpat_channel_t *self, const char *name);
+static bool              led_kpat_program_channel       (const led_kpat_channel_t *self, int level, const pattern_struct *pattern, bool *hw);
+static void              led_kpat_set_wakelock          (bool lock);
+static bool              led_kpat_start                 (const pattern_struct *pattern);
+static void              led_kpat_detach                (void);
+static void              led_kpat_stop                  (void);
+static void              led_kpat_init                  (void);
+static void              led_kpat_quit                  (void);
+#endif
 static void              allow_sw_breathing             (bool enable);
 static void              led_set_active_pattern         (pattern_struct *pattern);
 static gboolean          display_off_p                  (display_state_t state);
 static void              led_update_active_pattern      (void);
+static void              led_rethink_active_pattern     (void);
 static pattern_struct   *find_pattern_struct            (const gchar *const name);
-static void              update_combination_rule        (gpointer name, gpointer data);
-static void              update_combination_rules       (const gchar *const name);
+static void              register_pattern_struct        (pattern_struct *psp);
+static void              update_combination_rules       (const pattern_struct *psp);
+static void              init_combination_graph         (void);
+static void              quit_combination_graph         (void);
 static void              led_activate_pattern           (const gchar *const name);
 static void              led_deactivate_pattern         (const gchar *const name);
 static void              led_enable                     (void);
@@ -797,7 +845,338 @@ static void mono_set_brightness(gint brightness)
 }
 
 #ifdef ENABLE_HYBRIS
-static void hybris_program_led(const pattern_struct *const pattern);
+/* ========================================================================= *
+ * KERNEL PATTERN TRIGGER OFFLOAD
+ *
+ * The breathing provided by the hybris plugin is implemented by stepping
+ * led brightness from a timer, which means a wakelock must be held for
+ * as long as breathing is active. If the kernel offers the "pattern"
+ * led trigger for the rgb leds, the whole breathing waveform can be
+ * uploaded once and then either the led controller (hw_pattern) or the
+ * kernel (pattern) takes care of it without waking up mce.
+ *
+ * Kernel side stepping (pattern) uses timers that do not run while the
+ * device is suspended, so in that case a wakelock is still needed.
+ * ========================================================================= */
+
+/** Pattern trigger capable r, g and b leds */
+static led_kpat_channel_t led_kpat_channel[LED_KPAT_CHANNELS];
+
+/** Flag for: all color channels support the pattern trigger */
+static bool led_kpat_available = false;
+
+/** Pattern currently offloaded to kernel, or NULL */
+static const pattern_struct *led_kpat_pattern = NULL;
+
+/** Flag for: led has been reprogrammed behind pattern trigger's back */
+static bool led_kpat_stale = false;
+
+/** Flag for: kernel timers step the brightness, wakelock is held */
+static bool led_kpat_wakelock = false;
+
+/** Check if sysfs led supports the pattern trigger
+ *
+ * @param self  channel object to fill in
+ * @param name  led name under MCE_LED_DIRECT_SYS_PATH
+ *
+ * @return true if led can be used for offloading, false otherwise
+ */
+static bool led_kpat_probe_channel(led_kpat_channel_t *self, const char *name)
+{
+	bool   ack      = false;
+	gchar *path     = 0;
+	gchar *triggers = 0;
+	gulong maxval   = 0;
+
+	self->dir = g_strdup_printf("%s/%s", MCE_LED_DIRECT_SYS_PATH, name);
+
+	path = g_strconcat(self->dir, MCE_LED_TRIGGER_SUFFIX, NULL);
+	if( access(path, W_OK) == -1 )
+		goto EXIT;
+
+	if( !mce_read_string_from_file(path, &triggers) )
+		goto EXIT;
+
+	/* Available triggers are listed space separated, with the
+	 * currently active one in square brackets */
+	char *save = 0;
+	for( char *tok = strtok_r(triggers, " \t\n[]", &save); ;
+	     tok = strtok_r(0, " \t\n[]", &save) ) {
+		if( !tok )
+			goto EXIT;
+		if( !strcmp(tok, MCE_LED_TRIGGER_PATTERN) )
+			break;
+	}
+
+	g_free(path);
+	path = g_strconcat(self->dir, MCE_LED_MAX_BRIGHTNESS_SUFFIX, NULL);
+	if( !mce_read_number_string_from_file(path, &maxval, NULL, FALSE, TRUE) )
+		goto EXIT;
+
+	if( maxval < 1 )
+		goto EXIT;
+
+	self->max_brightness = (gint)maxval;
+	ack = true;
+
+EXIT:
+	mce_log(LL_DEBUG, "%s: pattern trigger %ssupported",
+		self->dir, ack ? "" : "not ");
+
+	g_free(triggers);
+	g_free(path);
+
+	return ack;
+}
+
+/** Upload breathing waveform for one color channel
+ *
+ * @param self    channel object
+ * @param level   channel intensity in 0 ... 255 range
+ * @param pattern led pattern to mimic
+ * @param hw      where to store flag for: breathing works without
+ *                kernel timers, i.e. also while suspended
+ *
+ * @return true on success, false on failure
+ */
+static bool led_kpat_program_channel(const led_kpat_channel_t *self,
+				     int level,
+				     const pattern_struct *pattern,
+				     bool *hw)
+{
+	bool   ack  = false;
+	gchar *path = 0;
+	gchar *data = 0;
+
+	/* Turned off channel does not need stepping */
+	*hw = true;
+
+	path = g_strconcat(self->dir, MCE_LED_TRIGGER_SUFFIX, NULL);
+
+	if( level <= 0 ) {
+		/* Detaching the trigger turns the led off */
+		ack = mce_write_string_to_file(path, MCE_LED_TRIGGER_NONE);
+		goto EXIT;
+	}
+
+	if( !mce_write_string_to_file(path, MCE_LED_TRIGGER_PATTERN) )
+		goto EXIT;
+
+	/* Scale color intensity to led range and apply led brightness */
+	level = level * self->max_brightness / 255;
+	level = level * active_brightness / (gint)maximum_led_brightness;
+	if( level < 1 )
+		level = 1;
+
+	/* Ramp up and down during on period, then stay off. The pattern
+	 * is given as brightness + duration pairs and the kernel does
+	 * linear interpolation between consecutive brightness values */
+	int rise = pattern->on_period / 2;
+	int fall = pattern->on_period - rise;
+	data = g_strdup_printf("0 %d %d %d 0 %d",
+			       rise, level, fall, pattern->off_period);
+
+	/* The pattern attributes exist only while the trigger is active.
+	 * Use hw_pattern if led controller supports it, otherwise let
+	 * kernel step the brightness. */
+	g_free(path);
+	path = g_strconcat(self->dir, MCE_LED_HW_PATTERN_SUFFIX, NULL);
+	if( access(path, W_OK) == -1 ||
+	    !mce_write_string_to_file(path, data) ) {
+		*hw = false;
+		g_free(path);
+		path = g_strconcat(self->dir, MCE_LED_PATTERN_SUFFIX, NULL);
+		if( !mce_write_string_to_file(path, data) )
+			goto EXIT;
+	}
+
+	g_free(path);
+	path = g_strconcat(self->dir, MCE_LED_REPEAT_SUFFIX, NULL);
+	if( !mce_write_string_to_file(path, "-1") )
+		goto EXIT;
+
+	ack = true;
+
+EXIT:
+	g_free(data);
+	g_free(path);
+
+	return ack;
+}
+
+/** Start breathing via kernel pattern trigger
+ *
+ * @param pattern led pattern to breathe
+ *
+ * @return true if breathing was offloaded, false otherwise
+ */
+static bool led_kpat_start(const pattern_struct *pattern)
+{
+	if( !led_kpat_available || !pattern )
+		return false;
+
+	if( active_brightness <= 0 )
+		return false;
+
+	if( led_kpat_pattern == pattern && !led_kpat_stale )
+		return true;
+
+	int rgb[LED_KPAT_CHANNELS] = {
+		(pattern->rgb_color >> 16) & 0xff,
+		(pattern->rgb_color >>  8) & 0xff,
+		(pattern->rgb_color >>  0) & 0xff,
+	};
+
+	bool hw_all = true;
+
+	led_kpat_pattern = pattern;
+	led_kpat_stale   = false;
+
+	for( size_t i = 0; i < LED_KPAT_CHANNELS; ++i ) {
+		bool hw = false;
+
+		if( led_kpat_program_channel(&led_kpat_channel[i], rgb[i],
+					     pattern, &hw) ) {
+			if( !hw )
+				hw_all = false;
+			continue;
+		}
+
+		mce_log(LL_WARN, "%s: pattern upload failed; "
+			"using sw breathing", led_kpat_channel[i].dir);
+		led_kpat_available = false;
+		led_kpat_detach();
+		return false;
+	}
+
+	/* Software pattern stepping stops while suspended */
+	led_kpat_set_wakelock(!hw_all);
+
+	mce_log(LL_DEBUG, "breathing offloaded to pattern trigger (%s)",
+		hw_all ? "hw_pattern" : "pattern");
+	return true;
+}
+
+/** Hold wakelock while kernel timers step the led brightness
+ *
+ * @param lock true to obtain wakelock, false to release it
+ */
+static void led_kpat_set_wakelock(bool lock)
+{
+	if( led_kpat_wakelock == lock )
+		goto EXIT;
+
+	if( (led_kpat_wakelock = lock) )
+		wakelock_lock("mce_led_pattern", -1);
+	else
+		wakelock_unlock("mce_led_pattern");
+
+EXIT:
+	return;
+}
+
+/** Detach pattern trigger from all color channels
+ *
+ * Note: This leaves the leds turned off.
+ */
+static void led_kpat_detach(void)
+{
+	if( !led_kpat_pattern )
+		goto EXIT;
+
+	led_kpat_pattern = NULL;
+
+	for( size_t i = 0; i < LED_KPAT_CHANNELS; ++i ) {
+		if( !led_kpat_channel[i].dir )
+			continue;
+
+		gchar *path = g_strconcat(led_kpat_channel[i].dir,
+					  MCE_LED_TRIGGER_SUFFIX, NULL);
+		(void)mce_write_string_to_file(path, MCE_LED_TRIGGER_NONE);
+		g_free(path);
+	}
+
+	led_kpat_set_wakelock(false);
+
+	mce_log(LL_DEBUG, "breathing offload stopped");
+
+EXIT:
+	return;
+}
+
+/** Stop breathing via kernel pattern trigger
+ */
+static void led_kpat_stop(void)
+{
+	if( !led_kpat_pattern )
+		goto EXIT;
+
+	led_kpat_detach();
+
+	/* Let the hybris plugin reprogram the active pattern */
+	if( active_pattern )
+		hybris_program_led(active_pattern);
+
+EXIT:
+	return;
+}
+
+/** Probe kernel pattern trigger support
+ */
+static void led_kpat_init(void)
+{
+	static const char * const def[LED_KPAT_CHANNELS] = {
+		MCE_LED_PATTERN_TRIGGER_DEFAULT_LEDS
+	};
+
+	gchar **names = 0;
+	gsize   count = 0;
+
+	led_kpat_quit();
+
+	names = mce_conf_get_string_list(MCE_CONF_LED_GROUP,
+					 MCE_CONF_LED_PATTERN_TRIGGER_LEDS,
+					 &count);
+
+	if( names && count != LED_KPAT_CHANNELS ) {
+		mce_log(LL_WARN, "%s: expected %d led names, got %zd",
+			MCE_CONF_LED_PATTERN_TRIGGER_LEDS,
+			LED_KPAT_CHANNELS, (size_t)count);
+		goto EXIT;
+	}
+
+	for( size_t i = 0; i < LED_KPAT_CHANNELS; ++i ) {
+		const char *name = names ? names[i] : def[i];
+		if( !led_kpat_probe_channel(&led_kpat_channel[i], name) )
+			goto EXIT;
+	}
+
+	led_kpat_available = true;
+
+EXIT:
+	mce_log(LL_NOTICE, "kernel pattern trigger breathing: %s",
+		led_kpat_available ? "available" : "not available");
+
+	g_strfreev(names);
+}
+
+/** Release kernel pattern trigger offload resources
+ */
+static void led_kpat_quit(void)
+{
+	led_kpat_stop();
+
+	led_kpat_available = false;
+
+	for( size_t i = 0; i < LED_KPAT_CHANNELS; ++i ) {
+		g_free(led_kpat_channel[i].dir),
+			led_kpat_channel[i].dir = 0;
+		led_kpat_channel[i].max_brightness = 0;
+	}
+}
+#endif /* ENABLE_HYBRIS */
+
+#ifdef ENABLE_HYBRIS
 
 /**
  * Set libhybris-LED brightness
@@ -824,6 +1203,12 @@ static void hybris_set_brightness(gint brightness)
 	/* Scale from [1...100%] to [1...255] range */
 	brightness = mce_xlat_int(1,maximum_led_brightness, 1,255, brightness);
 	mce_hybris_indicator_set_brightness(brightness);
+
+	/* Offloaded breathing waveform needs to be rescaled */
+	if( led_kpat_pattern ) {
+		led_kpat_stale = true;
+		sw_breathing_rethink();
+	}
 }
 #endif /* ENABLE_HYBRIS */
 
@@ -894,6 +1279,7 @@ static void mono_disable_led(void)
  */
 static void hybris_disable_led(void)
 {
+	led_kpat_detach();
 	mce_hybris_indicator_set_pattern(0,0,0, 0,0);
 }
 #endif /* ENABLE_HYBRIS */
@@ -943,6 +1329,7 @@ static pattern_struct *led_pattern_create(void)
 	self->name       = 0;
 	self->timeout_id = 0;
 	self->setting_id = 0;
+	self->dependents = 0;
 
 EXIT:
 	return self;
@@ -959,6 +1346,7 @@ static void led_pattern_delete(pattern_struct *self)
 
 	mce_hbtimer_delete(self->timeout_id);
 	mce_setting_notifier_remove(self->setting_id);
+	g_slist_free(self->dependents);
 	free(self->name);
 
 	g_slice_free(pattern_struct, self);
@@ -991,9 +1379,24 @@ static void led_pattern_set_active(pattern_struct *self, gboolean active)
 
 	self->active = active;
 
+	/* Update active pre-requisite counts of combination rules */
+	for( GSList *item = self->dependents; item; item = item->next ) {
+		combination_node_struct *node = item->data;
+		if( self->active )
+			++node->satisfied;
+		else
+			--node->satisfied;
+	}
+
 	if( !self->enabled )
 		goto EXIT;
 
+	/* Patterns that have lower priority than the currently shown
+	 * one can't affect the outcome of led_update_active_pattern() */
+	if( !active_pattern || active_pattern == self ||
+	    self->priority <= active_pattern->priority )
+		active_pattern_dirty = TRUE;
+
 	if( self->active )
 		mce_hbtimer_start(self->timeout_id);
 	else
@@ -1286,6 +1689,9 @@ static void hybris_program_led(const pattern_struct *const pattern)
 	int g = (pattern->rgb_color >>  8) & 0xff;
 	int b = (pattern->rgb_color >>  0) & 0xff;
 
+	/* Plugin can't control leds owned by pattern trigger */
+	led_kpat_detach();
+
 	mce_hybris_indicator_set_pattern(r, g, b,
 					 pattern->on_period,
 					 pattern->off_period);
@@ -1333,11 +1739,24 @@ static void allow_sw_breathing(bool enable)
 {
 	static bool current = false;
 
+	bool offload = false;
+
 	/* If led backend does not support breathing make sure we do
 	 * not grab a useless wakelock and block suspend unnecessarily */
 	if( !mce_hybris_indicator_can_breathe() )
 		enable = false;
 
+#ifdef ENABLE_HYBRIS
+	/* Prefer uploading the waveform to kernel pattern trigger
+	 * over stepping brightness from a timer while holding a
+	 * wakelock */
+	if( enable && led_kpat_available && active_pattern &&
+	    active_brightness > 0 ) {
+		offload = true;
+		enable  = false;
+	}
+#endif
+
 	if( current == enable )
 		goto EXIT;
 
@@ -1358,6 +1777,16 @@ static void allow_sw_breathing(bool enable)
 		break;
 	}
 EXIT:
+#ifdef ENABLE_HYBRIS
+	if( !offload ) {
+		led_kpat_stop();
+	}
+	else if( !led_kpat_start(active_pattern) ) {
+		/* Offloading failed and is now disabled -> fall
+		 * back to sw breathing */
+		allow_sw_breathing(true);
+	}
+#endif
 	return;
 }
 
@@ -1502,10 +1931,20 @@ static void led_update_active_pattern(void)
 	}
 
 EXIT:
+	active_pattern_dirty = FALSE;
 	led_set_active_pattern(new_active_pattern);
 	return;
 }
 
+/**
+ * Recalculate active pattern if pattern state changes made it necessary
+ */
+static void led_rethink_active_pattern(void)
+{
+	if( active_pattern_dirty )
+		led_update_active_pattern();
+}
+
 /**
  * Find the pattern struct for a pattern
  *
@@ -1515,90 +1954,120 @@ EXIT:
 static pattern_struct *find_pattern_struct(const gchar *const name)
 {
 	pattern_struct *psp = NULL;
-	GList *glp;
 
-	if (name == NULL)
+	if (name == NULL || pattern_lut == NULL)
 		goto EXIT;
 
-	if ((glp = g_queue_find_custom(pattern_stack,
-				       name, queue_find)) != NULL) {
-		psp = (pattern_struct *)glp->data;
-	}
+	psp = g_hash_table_lookup(pattern_lut, name);
 
 EXIT:
 	return psp;
 }
 
 /**
- * Update combination rule
+ * Add pattern to the pattern stack and the name lookup table
  *
- * @param name The rule to process
- * @param data Unused
+ * @param psp The pattern to add; the name must be already set
  */
-static void update_combination_rule(gpointer name, gpointer data)
+static void register_pattern_struct(pattern_struct *psp)
 {
-	combination_rule_struct *cr;
-	gboolean enabled = TRUE;
-	pattern_struct *psp;
-	GList *glp;
-	gchar *tmp;
-	gint i;
-
-	(void)data;
-
-	if ((glp = g_queue_find_custom(combination_rule_list,
-				       name, queue_find)) == NULL)
-		goto EXIT;
+	pattern_struct *old = find_pattern_struct(psp->name);
 
-	cr = glp->data;
+	g_queue_insert_sorted(pattern_stack, psp,
+			      queue_prio_compare,
+			      NULL);
 
-	/* If all patterns in the pre_requisite list are enabled,
-	 * then enable this pattern, else disable it
-	 */
-	for (i = 0; (tmp = g_queue_peek_nth(cr->pre_requisites, i)) != NULL; i++) {
-		/* We've got a pattern name; check if that pattern is active */
-		if (((psp = find_pattern_struct(tmp)) == NULL) ||
-		    (psp->active == FALSE)) {
-			enabled = FALSE;
-			break;
-		}
-	}
+	/* Name lookups resolve to the highest priority pattern, or to
+	 * the most recently registered one in case of equal priority */
+	if( !old || old->priority >= psp->priority )
+		g_hash_table_replace(pattern_lut, psp->name, psp);
+}
 
-	if ((psp = find_pattern_struct(name)) == NULL)
+/**
+ * Update activate patterns based on combination rules
+ *
+ * @param psp The pattern that changed state
+ */
+static void update_combination_rules(const pattern_struct *psp)
+{
+	if (psp == NULL) {
+		mce_log(LL_CRIT,
+			"called with psp == NULL");
 		goto EXIT;
+	}
 
-	led_pattern_set_active(psp, enabled);
+	/* Update all combination rules that this pattern influences;
+	 * the active pre-requisite counts are already up to date */
+	for( GSList *item = psp->dependents; item; item = item->next ) {
+		combination_node_struct *node = item->data;
+		led_pattern_set_active(node->target,
+				       node->satisfied == node->required);
+	}
 
 EXIT:
 	return;
 }
 
 /**
- * Update activate patterns based on combination rules
- *
- * @param name THe name of the pattern that changed state
+ * Resolve combination rules into pattern dependency graph
  */
-static void update_combination_rules(const gchar *const name)
+static void init_combination_graph(void)
 {
-	GList *glp;
+	quit_combination_graph();
 
-	if (name == NULL) {
-		mce_log(LL_CRIT,
-			"called with name == NULL");
-		goto EXIT;
-	}
+	for( GList *iter = combination_rule_list->head; iter; iter = iter->next ) {
+		combination_rule_struct *cr = iter->data;
+		pattern_struct *target = find_pattern_struct(cr->rulename);
 
-	if ((glp = g_queue_find_custom(combination_rule_xref_list, name,
-				       queue_find)) != NULL) {
-		combination_rule_struct *xrf = glp->data;
+		if( !target ) {
+			mce_log(LL_WARN, "LED pattern combination rule `%s' "
+				"refers to unknown pattern", cr->rulename);
+			continue;
+		}
+
+		combination_node_struct *node =
+			g_slice_new0(combination_node_struct);
+
+		node->target = target;
+
+		for( GList *pre = cr->pre_requisites->head; pre; pre = pre->next ) {
+			pattern_struct *psp = find_pattern_struct(pre->data);
+
+			/* Unknown pre-requisites keep the rule unsatisfied */
+			node->required += 1;
+
+			if( !psp )
+				continue;
 
-		/* Update all combination rules that this pattern influences */
-		g_queue_foreach(xrf->pre_requisites,
-				update_combination_rule, NULL);
+			psp->dependents = g_slist_prepend(psp->dependents,
+							  node);
+			if( psp->active )
+				node->satisfied += 1;
+		}
+
+		combination_graph = g_slist_prepend(combination_graph, node);
 	}
+}
 
-EXIT:
-	return;
+/**
+ * Release pattern dependency graph
+ */
+static void quit_combination_graph(void)
+{
+	if( pattern_stack ) {
+		for( GList *iter = pattern_stack->head; iter; iter = iter->next ) {
+			pattern_struct *psp = iter->data;
+			g_slist_free(psp->dependents),
+				psp->dependents = 0;
+		}
+	}
+
+	while( combination_graph ) {
+		combination_node_struct *node = combination_graph->data;
+		combination_graph = g_slist_delete_link(combination_graph,
+							combination_graph);
+		g_slice_free(combination_node_struct, node);
+	}
 }
 
 /**
@@ -1620,8 +2089,8 @@ static void led_activate_pattern(const gchar *const name)
 		if( !psp->active && psp->policy == 6 )
 			psp->undecided = TRUE;
 		led_pattern_set_active(psp, TRUE);
-		update_combination_rules(name);
-		led_update_active_pattern();
+		update_combination_rules(psp);
+		led_rethink_active_pattern();
 	} else {
 		mce_log(LL_DEBUG,
 			"Received request to activate "
@@ -1643,8 +2112,8 @@ static void led_deactivate_pattern(const gchar *const name)
 
 	if ((psp = find_pattern_struct(name)) != NULL) {
 		led_pattern_set_active(psp, FALSE);
-		update_combination_rules(name);
-		led_update_active_pattern();
+		update_combination_rules(psp);
+		led_rethink_active_pattern();
 	} else {
 		mce_log(LL_DEBUG,
 			"Received request to deactivate "
@@ -1755,7 +2224,7 @@ static void type6_revert_cb(void *data, void *aptr)
 
 	if( psp->undecided && psp->active && psp->policy == 6 ) {
 		led_pattern_set_active(psp, FALSE);
-		update_combination_rules(psp->name);
+		update_combination_rules(psp);
 		mce_log(LL_DEBUG, "LED pattern %s: reverted", psp->name);
 	}
 	psp->undecided = FALSE;
@@ -1774,7 +2243,7 @@ static void type6_deactivate_cb(void *data, void *aptr)
 
 	if( psp->active && psp->policy == 6 ) {
 		led_pattern_set_active(psp, FALSE);
-		update_combination_rules(psp->name);
+		update_combination_rules(psp);
 		mce_log(LL_DEBUG, "LED pattern %s: deactivated", psp->name);
 	}
 	psp->undecided = FALSE;
@@ -2221,35 +2690,19 @@ static gboolean init_combination_rules(void)
 
 			for (j = 1; j < length; j++) {
 				gchar *str = strdup(tmp[j]);
-				GList *glp;
-				combination_rule_struct *xrf = NULL;
 
 				g_queue_push_head(cr->pre_requisites, str);
-
-				glp = g_queue_find_custom(combination_rule_xref_list, str, queue_find);
-
-				if ((glp == NULL) || (glp->data == NULL)) {
-					xrf = g_slice_new(combination_rule_struct);
-					xrf->rulename = str;
-					xrf->pre_requisites = g_queue_new();
-					g_queue_push_head(combination_rule_xref_list, xrf);
-				} else {
-					xrf = (combination_rule_struct *)glp->data;
-				}
-
-				/* If the cross reference isn't in the list
-				 * already, add it
-				 */
-				if (g_queue_find_custom(xrf->pre_requisites, cr->rulename, queue_find) == NULL) {
-					g_queue_push_head(xrf->pre_requisites,
-							  cr->rulename);
-				}
 			}
 
+			g_strfreev(tmp);
+
 			g_queue_push_head(combination_rule_list, cr);
 		}
 	}
 
+	/* Resolve rules now that all patterns are known */
+	init_combination_graph();
+
 	status = TRUE;
 
 EXIT2:
@@ -2405,9 +2858,7 @@ static gboolean init_lysti_patterns(void)
 
 			g_strfreev(tmp);
 
-			g_queue_insert_sorted(pattern_stack, psp,
-					      queue_prio_compare,
-					      NULL);
+			register_pattern_struct(psp);
 		}
 	}
 
@@ -2540,9 +2991,7 @@ static gboolean init_njoy_patterns(void)
 
 			g_strfreev(tmp);
 
-			g_queue_insert_sorted(pattern_stack, psp,
-					      queue_prio_compare,
-					      NULL);
+			register_pattern_struct(psp);
 		}
 	}
 
@@ -2631,9 +3080,7 @@ static gboolean init_mono_patterns(void)
 
 			g_free(tmp);
 
-			g_queue_insert_sorted(pattern_stack, psp,
-					      queue_prio_compare,
-					      NULL);
+			register_pattern_struct(psp);
 		}
 	}
 
@@ -2804,9 +3251,7 @@ static gboolean init_hybris_patterns(void)
 			psp->enabled    = pattern_get_enabled(name,
 							      &psp->setting_id);
 
-			g_queue_insert_sorted(pattern_stack, psp,
-					      queue_prio_compare,
-					      NULL);
+			register_pattern_struct(psp);
 		}
 		g_strfreev(v);
 	}
@@ -2857,6 +3302,7 @@ static gboolean init_patterns(void)
 #ifdef ENABLE_HYBRIS
 	case LED_TYPE_HYBRIS:
 		status = init_hybris_patterns();
+		led_kpat_init();
 		break;
 #endif
 
@@ -3189,8 +3635,8 @@ const gchar *g_module_check_init(GModule *module)
 	 * and initialise the patterns
 	 */
 	pattern_stack = g_queue_new();
+	pattern_lut = g_hash_table_new(g_str_hash, g_str_equal);
 	combination_rule_list = g_queue_new();
-	combination_rule_xref_list = g_queue_new();
 
 	if (init_patterns() == FALSE)
 		goto EXIT;
@@ -3239,6 +3685,11 @@ void g_module_unload(GModule *module)
 	/* Remove breathing timers and wakelocks */
 	sw_breathing_quit();
 
+#ifdef ENABLE_HYBRIS
+	/* Release leds from kernel pattern trigger */
+	led_kpat_quit();
+#endif
+
 	/* Don't disable the LED on shutdown/reboot/acting dead */
 	if ((system_state != MCE_STATE_ACTDEAD) &&
 	    (system_state != MCE_STATE_SHUTDOWN) &&
@@ -3282,6 +3733,12 @@ void g_module_unload(GModule *module)
 	g_free(engine2_leds_path);
 	g_free(engine3_leds_path);
 
+	/* Free the pattern lookup table; keys are owned by patterns */
+	if (pattern_lut != NULL) {
+		g_hash_table_unref(pattern_lut);
+		pattern_lut = NULL;
+	}
+
 	/* Free the pattern stack */
 	if (pattern_stack != NULL) {
 		pattern_struct *psp;
@@ -3315,19 +3772,8 @@ void g_module_unload(GModule *module)
 		combination_rule_list = NULL;
 	}
 
-	/* Free the combination rule cross reference list */
-	if (combination_rule_xref_list != NULL) {
-		combination_rule_struct *xrf;
-
-		while ((xrf = g_queue_pop_head(combination_rule_xref_list)) != NULL) {
-			g_queue_free(xrf->pre_requisites);
-			xrf->pre_requisites = NULL;
-			g_slice_free(combination_rule_struct, xrf);
-		}
-
-		g_queue_free(combination_rule_xref_list);
-		combination_rule_xref_list = NULL;
-	}
+	/* Free the combination rule dependency graph */
+	quit_combination_graph();
 
 	return;
 }
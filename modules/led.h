@@ -37,6 +37,14 @@
 /** Name of configuration key for the list of LED Pattern combination-rules */
 #define MCE_CONF_LED_COMBINATION_RULES		"CombinationRules"
 
+/** Name of configuration key for the list of sysfs leds that can be used
+ *  for offloading breathing via the kernel pattern trigger
+ *
+ * Three entries in red;green;blue order are expected. If the key is not
+ * defined, MCE_LED_PATTERN_TRIGGER_DEFAULT_LEDS are probed instead.
+ */
+#define MCE_CONF_LED_PATTERN_TRIGGER_LEDS	"PatternTriggerLeds"
+
 /**
  * Name of LED single-colour pattern configuration group for
  * RX-34
@@ -148,6 +156,27 @@
 /** No trigger */
 #define MCE_LED_TRIGGER_NONE			"none"
 
+/** Kernel pattern trigger */
+#define MCE_LED_TRIGGER_PATTERN			"pattern"
+
+/** Sysfs led names probed for pattern trigger offload by default */
+#define MCE_LED_PATTERN_TRIGGER_DEFAULT_LEDS	"red", "green", "blue"
+
+/** Trigger control file suffix */
+#define MCE_LED_TRIGGER_SUFFIX			"/trigger"
+
+/** Maximum brightness file suffix */
+#define MCE_LED_MAX_BRIGHTNESS_SUFFIX		"/max_brightness"
+
+/** Pattern trigger: software stepped pattern file suffix */
+#define MCE_LED_PATTERN_SUFFIX			"/pattern"
+
+/** Pattern trigger: hardware pattern file suffix */
+#define MCE_LED_HW_PATTERN_SUFFIX		"/hw_pattern"
+
+/** Pattern trigger: repeat count file suffix */
+#define MCE_LED_REPEAT_SUFFIX			"/repeat"
+
 /* LED modes */
 
 /** LED disabled */
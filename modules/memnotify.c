@@ -25,6 +25,7 @@
 #include "../mce-log.h"
 #include "../mce-dbus.h"
 #include "../mce-setting.h"
+#include "../mce-conf.h"
 
 #include <mce/dbus-names.h>
 #include <mce/mode-names.h>
@@ -47,35 +48,6 @@ static int    memnotify_char_is_white  (int ch);
 static char  *memnotify_token_parse    (char **ppos);
 static guint  memnotify_iowatch_add    (int fd, bool close_on_unref, GIOCondition cnd, GIOFunc io_cb, gpointer aptr);
 
-/* ========================================================================= *
- * MEMORY_LEVELS
- * ========================================================================= */
-
-/** Supported memory usage levels
- *
- * Note: The ordering must match:
- *       1) memnotify_limit[] array
- *       2) memnotify_dev[] array
- */
-typedef enum
-{
-    /** No excess memory pressure */
-    MEMNOTIFY_LEVEL_NORMAL,
-
-    /** Non-essential caches etc should be released */
-    MEMNOTIFY_LEVEL_WARNING,
-
-    /** Non-essential prosesses should be terminated */
-    MEMNOTIFY_LEVEL_CRITICAL,
-
-    /* Not initialized yet or memnotify is not supported */
-    MEMNOTIFY_LEVEL_UNKNOWN,
-
-    MEMNOTIFY_LEVEL_COUNT
-} memnotify_level_t;
-
-static const char *memnotify_level_name(memnotify_level_t lev);
-
 /* ========================================================================= *
  * LIMIT_OBJECTS
  * ========================================================================= */
@@ -141,10 +113,65 @@ static gboolean memnotify_dev_rx_cb        (GIOChannel *chn, GIOCondition cnd, g
 
 static void     memnotify_dev_close        (memnotify_level_t lev);
 static bool     memnotify_dev_open         (memnotify_level_t lev);
+static bool     memnotify_dev_open_all     (void);
 
 static bool     memnotify_dev_set_trigger  (memnotify_level_t lev, const memnotify_limit_t *limit);
 static bool     memnotify_dev_get_status   (memnotify_level_t lev, memnotify_limit_t *state);
 
+/* ========================================================================= *
+ * PRESSURE_TRACKING
+ * ========================================================================= */
+
+static gint     memnotify_pressure_window  (void);
+static void     memnotify_pressure_raise   (memnotify_level_t lev);
+static gboolean memnotify_pressure_hold_cb (gpointer aptr);
+static void     memnotify_pressure_quit    (void);
+
+/* ========================================================================= *
+ * PSI_INTERFACE
+ * ========================================================================= */
+
+/** Structure for holding pressure stall trigger file descriptors etc */
+typedef struct
+{
+    /** Flag for: Slot is not a dummy */
+    bool        mnp_in_use;
+
+    /** Stall type to track: "some" or "full" */
+    const char *mnp_kind;
+
+    /** File descriptor for /proc/pressure/memory
+     *
+     * If mnp_in_use is true, must be initialized to -1.
+     */
+    int         mnp_fd;
+
+    /** Glib io watch id for mnp_fd
+     *
+     * If mnp_in_use is true, must be initialized to 0.
+     */
+    guint       mnp_rx_id;
+} memnotify_psi_t;
+
+static bool     memnotify_psi_is_available (void);
+
+static gboolean memnotify_psi_rx_cb        (GIOChannel *chn, GIOCondition cnd, gpointer aptr);
+
+static void     memnotify_psi_close        (memnotify_level_t lev);
+static bool     memnotify_psi_open         (memnotify_level_t lev);
+
+static void     memnotify_psi_close_all    (void);
+static bool     memnotify_psi_open_all     (void);
+
+/* ========================================================================= *
+ * CGROUP_INTERFACE
+ * ========================================================================= */
+
+static bool     memnotify_cgroup_read_events (bool notify);
+static gboolean memnotify_cgroup_rx_cb       (GIOChannel *chn, GIOCondition cnd, gpointer aptr);
+static void     memnotify_cgroup_close       (void);
+static bool     memnotify_cgroup_open        (void);
+
 /* ========================================================================= *
  * DYNAMIC_SETTINGS
  * ========================================================================= */
@@ -244,29 +271,6 @@ EXIT:
 
 }
 
-/* ========================================================================= *
- * MEMORY_LEVELS
- * ========================================================================= */
-
-/** Translate level enum to human readable string
- *
- * Note: Also used as argument for the change signal and thus
- *       changes here can cause API breaks.
- */
-static const char *
-memnotify_level_name(memnotify_level_t lev)
-{
-    static const char * const lut[MEMNOTIFY_LEVEL_COUNT] =
-    {
-        [MEMNOTIFY_LEVEL_NORMAL]   = MCE_MEMORY_LEVEL_NORMAL,
-        [MEMNOTIFY_LEVEL_WARNING]  = MCE_MEMORY_LEVEL_WARNING,
-        [MEMNOTIFY_LEVEL_CRITICAL] = MCE_MEMORY_LEVEL_CRITICAL,
-        [MEMNOTIFY_LEVEL_UNKNOWN]  = MCE_MEMORY_LEVEL_UNKNOWN,
-    };
-
-    return (lev < MEMNOTIFY_LEVEL_COUNT) ? lut[lev] : "undefined";
-}
-
 /* ========================================================================= *
  * LIMIT_OBJECTS
  * ========================================================================= */
@@ -403,6 +407,18 @@ static memnotify_limit_t memnotify_state =
 /** Cached memory use level */
 static memnotify_level_t memnotify_level = MEMNOTIFY_LEVEL_UNKNOWN;
 
+/** Memory use level indicated by pressure stall / cgroup events */
+static memnotify_level_t memnotify_pressure_level = MEMNOTIFY_LEVEL_NORMAL;
+
+/** Flag for: Legacy memnotify device is used for tracking */
+static bool memnotify_dev_active = false;
+
+/** Flag for: Pressure stall information is used for tracking */
+static bool memnotify_psi_active = false;
+
+/** Cgroup v2 memory.events file descriptor, or -1 */
+static int memnotify_cgroup_fd = -1;
+
 /** Check current memory status against triggering levels
  */
 static memnotify_level_t
@@ -414,6 +430,8 @@ memnotify_status_evaluate_level(void)
         if( memnotify_limit_exceeded(memnotify_limit+lev, &memnotify_state) )
             res = lev;
     }
+    if( res < memnotify_pressure_level )
+        res = memnotify_pressure_level;
     return res;
 }
 
@@ -429,6 +447,10 @@ memnotify_status_update_level(void)
 
     memnotify_level = level;
 
+    execute_datapipe(&memnotify_level_pipe,
+                     GINT_TO_POINTER(memnotify_level),
+                     USE_INDATA, CACHE_INDATA);
+
     memnotify_dbus_broadcast_level();
 
 EXIT:
@@ -441,6 +463,17 @@ EXIT:
 static void
 memnotify_status_update_triggers(void)
 {
+    /* Pressure stall triggers can't be modified, open new ones */
+    if( memnotify_psi_active && !memnotify_psi_open_all() ) {
+        mce_log(LL_WARN, "pressure stall triggers could not be set up");
+        memnotify_psi_active = false;
+
+        /* Fall back to memnotify device node, if available */
+        if( !memnotify_dev_active && memnotify_dev_is_available() &&
+            memnotify_dev_open_all() )
+            memnotify_dev_active = true;
+    }
+
     /* Program new limits to kernel side */
     memnotify_dev_set_trigger(MEMNOTIFY_LEVEL_WARNING,
                               memnotify_limit + MEMNOTIFY_LEVEL_WARNING);
@@ -453,8 +486,14 @@ memnotify_status_update_triggers(void)
      * The MEMNOTIFY_LEVEL_WARNING is just a slot for which we should
      * have an open /dev/memnotify file descriptor.
      */
-    if( memnotify_dev_get_status(MEMNOTIFY_LEVEL_WARNING, &memnotify_state) )
+    if( memnotify_dev_active ) {
+        if( memnotify_dev_get_status(MEMNOTIFY_LEVEL_WARNING,
+                                     &memnotify_state) )
+            memnotify_status_update_level();
+    }
+    else if( memnotify_psi_active || memnotify_cgroup_fd != -1 ) {
         memnotify_status_update_level();
+    }
 }
 
 /** Log current memory level configuration for debugging purposes
@@ -465,7 +504,7 @@ memnotify_status_show_triggers(void)
     for( size_t i = 0; i < G_N_ELEMENTS(memnotify_limit); ++i ) {
         char tmp[256];
         memnotify_limit_repr(memnotify_limit+i, tmp, sizeof tmp);
-        mce_log(LL_DEBUG, "%s: %s", memnotify_level_name(i), tmp);
+        mce_log(LL_DEBUG, "%s: %s", memnotify_level_repr(i), tmp);
     }
 }
 
@@ -517,7 +556,7 @@ memnotify_dev_rx_cb(GIOChannel *chn, GIOCondition cnd, gpointer aptr)
     if( !memnotify_dev[lev].mnd_rx_id )
         goto EXIT;
 
-    mce_log(LL_DEBUG, "notify trigger (%s)", memnotify_level_name(lev));
+    mce_log(LL_DEBUG, "notify trigger (%s)", memnotify_level_repr(lev));
 
     if( cnd & ~G_IO_IN ) {
         mce_log(LL_WARN, "unexpected input watch condition");
@@ -656,7 +695,7 @@ memnotify_dev_set_trigger(memnotify_level_t lev, const memnotify_limit_t *limit)
     if( done != todo )
         goto EXIT;
 
-    mce_log(LL_DEBUG, "write %s -> %s", memnotify_level_name(lev), tmp);
+    mce_log(LL_DEBUG, "write %s -> %s", memnotify_level_repr(lev), tmp);
 
     res = true;
 
@@ -689,7 +728,7 @@ memnotify_dev_get_status(memnotify_level_t lev, memnotify_limit_t *state)
 
     tmp[done-1] = 0;
 
-    mce_log(LL_DEBUG, "read %s <- %s", memnotify_level_name(lev), tmp);
+    mce_log(LL_DEBUG, "read %s <- %s", memnotify_level_repr(lev), tmp);
 
     if( !memnotify_limit_parse(state, tmp) )
         goto EXIT;
@@ -701,6 +740,489 @@ EXIT:
     return res;
 }
 
+/* ========================================================================= *
+ * PRESSURE_TRACKING
+ * ========================================================================= */
+
+/** How many stall windows elevated level is held after the last event
+ *
+ * Pressure stall triggers and cgroup events only tell when things get
+ * worse. Returning to lower levels is done by a timer that is active
+ * only while memory pressure level is elevated.
+ */
+#define MEMNOTIFY_PRESSURE_HOLD_WINDOWS 3
+
+/** Pressure stall thresholds for warning/critical levels [ms] */
+static gint memnotify_stall[MEMNOTIFY_LEVEL_COUNT] =
+{
+    [MEMNOTIFY_LEVEL_WARNING]  = MCE_DEFAULT_MEMNOTIFY_WARNING_STALL,
+    [MEMNOTIFY_LEVEL_CRITICAL] = MCE_DEFAULT_MEMNOTIFY_CRITICAL_STALL,
+};
+
+/** Pressure stall tracking window [ms] */
+static gint memnotify_stall_window = MCE_DEFAULT_MEMNOTIFY_STALL_WINDOW;
+
+/** Timer id for dropping elevated pressure level */
+static guint memnotify_pressure_hold_id = 0;
+
+/** Get pressure stall tracking window clamped to kernel supported range
+ */
+static gint
+memnotify_pressure_window(void)
+{
+    /* Kernel accepts windows in 500 ms ... 10 s range */
+    if( memnotify_stall_window < 500 )
+        return 500;
+    if( memnotify_stall_window > 10000 )
+        return 10000;
+    return memnotify_stall_window;
+}
+
+/** Timer callback for stepping down elevated pressure level
+ */
+static gboolean
+memnotify_pressure_hold_cb(gpointer aptr)
+{
+    (void)aptr;
+
+    gboolean keep_going = FALSE;
+
+    if( !memnotify_pressure_hold_id )
+        goto EXIT;
+
+    if( memnotify_pressure_level > MEMNOTIFY_LEVEL_NORMAL )
+        memnotify_pressure_level -= 1;
+
+    mce_log(LL_DEBUG, "pressure level -> %s",
+            memnotify_level_repr(memnotify_pressure_level));
+
+    memnotify_status_update_level();
+
+    if( memnotify_pressure_level > MEMNOTIFY_LEVEL_NORMAL )
+        keep_going = TRUE;
+    else
+        memnotify_pressure_hold_id = 0;
+
+EXIT:
+    return keep_going;
+}
+
+/** Raise pressure level and (re)start the step down timer
+ */
+static void
+memnotify_pressure_raise(memnotify_level_t lev)
+{
+    if( memnotify_pressure_level < lev ) {
+        memnotify_pressure_level = lev;
+        mce_log(LL_DEBUG, "pressure level -> %s",
+                memnotify_level_repr(memnotify_pressure_level));
+    }
+
+    if( memnotify_pressure_hold_id )
+        g_source_remove(memnotify_pressure_hold_id);
+
+    memnotify_pressure_hold_id =
+        g_timeout_add(memnotify_pressure_window() *
+                      MEMNOTIFY_PRESSURE_HOLD_WINDOWS,
+                      memnotify_pressure_hold_cb, 0);
+
+    memnotify_status_update_level();
+}
+
+/** Cancel step down timer and reset pressure level
+ */
+static void
+memnotify_pressure_quit(void)
+{
+    if( memnotify_pressure_hold_id ) {
+        g_source_remove(memnotify_pressure_hold_id),
+            memnotify_pressure_hold_id = 0;
+    }
+
+    memnotify_pressure_level = MEMNOTIFY_LEVEL_NORMAL;
+}
+
+/* ========================================================================= *
+ * PSI_INTERFACE
+ * ========================================================================= */
+
+/** Path to memory pressure stall information */
+static const char memnotify_psi_path[] = "/proc/pressure/memory";
+
+/** Tracking data for pressure stall triggers */
+static memnotify_psi_t memnotify_psi[MEMNOTIFY_LEVEL_COUNT] =
+{
+    [MEMNOTIFY_LEVEL_WARNING] = {
+        .mnp_in_use = true,
+        .mnp_kind   = "some",
+        .mnp_fd     = -1,
+        .mnp_rx_id  = 0,
+    },
+    [MEMNOTIFY_LEVEL_CRITICAL] = {
+        .mnp_in_use = true,
+        .mnp_kind   = "full",
+        .mnp_fd     = -1,
+        .mnp_rx_id  = 0,
+    },
+
+    /* Note: Any uninitialized slots will have mnp_in_use==false and
+     *       are ignored by memnotify_psi_xxx() functions. */
+};
+
+/** Probe if pressure stall information is available
+ */
+static bool
+memnotify_psi_is_available(void)
+{
+    return access(memnotify_psi_path, R_OK|W_OK) == 0;
+}
+
+/** Input watch callback for pressure stall trigger
+ */
+static gboolean
+memnotify_psi_rx_cb(GIOChannel *chn, GIOCondition cnd, gpointer aptr)
+{
+    (void) chn;
+
+    memnotify_level_t lev = GPOINTER_TO_INT(aptr);
+
+    gboolean keep_going = FALSE;
+
+    if( !memnotify_psi[lev].mnp_rx_id )
+        goto EXIT;
+
+    mce_log(LL_DEBUG, "stall trigger (%s)", memnotify_level_repr(lev));
+
+    if( cnd & ~G_IO_PRI ) {
+        mce_log(LL_WARN, "unexpected input watch condition");
+        goto EXIT;
+    }
+
+    keep_going = TRUE;
+
+    memnotify_pressure_raise(lev);
+
+EXIT:
+
+    if( !keep_going && memnotify_psi[lev].mnp_rx_id ) {
+        memnotify_psi[lev].mnp_rx_id = 0;
+        mce_log(LL_CRIT, "disabling input watch");
+    }
+    return keep_going;
+}
+
+/** Remove pressure stall trigger
+ */
+static void
+memnotify_psi_close(memnotify_level_t lev)
+{
+    if( !memnotify_psi[lev].mnp_in_use )
+        goto EXIT;
+
+    if( memnotify_psi[lev].mnp_rx_id ) {
+        g_source_remove(memnotify_psi[lev].mnp_rx_id),
+            memnotify_psi[lev].mnp_rx_id = 0;
+    }
+
+    if( memnotify_psi[lev].mnp_fd != -1 ) {
+        close(memnotify_psi[lev].mnp_fd),
+            memnotify_psi[lev].mnp_fd = -1;
+    }
+
+EXIT:
+
+    return;
+}
+
+/** Install pressure stall trigger and io watch for it
+ *
+ * Levels with zero stall threshold are left disabled.
+ */
+static bool
+memnotify_psi_open(memnotify_level_t lev)
+{
+    bool res = false;
+    char tmp[64];
+
+    if( !memnotify_psi[lev].mnp_in_use )
+        goto EXIT;
+
+    gint window = memnotify_pressure_window();
+    gint stall  = memnotify_stall[lev];
+
+    if( stall <= 0 ) {
+        mce_log(LL_DEBUG, "%s: stall tracking disabled",
+                memnotify_level_repr(lev));
+        res = true;
+        goto EXIT;
+    }
+
+    if( stall > window )
+        stall = window;
+
+    memnotify_psi[lev].mnp_fd = open(memnotify_psi_path,
+                                     O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if( memnotify_psi[lev].mnp_fd == -1 ) {
+        mce_log(LL_ERR, "could not open: %s: %m", memnotify_psi_path);
+        goto EXIT;
+    }
+
+    /* Trigger format: <some|full> <stall us> <window us> */
+    int todo = snprintf(tmp, sizeof tmp, "%s %d %d",
+                        memnotify_psi[lev].mnp_kind,
+                        stall * 1000, window * 1000);
+
+    /* Note: Kernel expects the terminating nul to be included */
+    if( write(memnotify_psi[lev].mnp_fd, tmp, todo + 1) == -1 ) {
+        mce_log(LL_ERR, "could not set trigger: %s: %s: %m",
+                memnotify_psi_path, tmp);
+        goto EXIT;
+    }
+
+    memnotify_psi[lev].mnp_rx_id =
+        memnotify_iowatch_add(memnotify_psi[lev].mnp_fd,
+                              false,
+                              G_IO_PRI,
+                              memnotify_psi_rx_cb,
+                              GINT_TO_POINTER(lev));
+
+    if( !memnotify_psi[lev].mnp_rx_id ) {
+        mce_log(LL_ERR, "could add iowatch: %s", memnotify_psi_path);
+        goto EXIT;
+    }
+
+    mce_log(LL_DEBUG, "trigger %s -> %s", memnotify_level_repr(lev), tmp);
+
+    res = true;
+
+EXIT:
+
+    // all or nothing
+    if( !res )
+        memnotify_psi_close(lev);
+
+    return res;
+}
+
+static void
+memnotify_psi_close_all(void)
+{
+    for( memnotify_level_t lev = 0; lev < MEMNOTIFY_LEVEL_COUNT; ++lev )
+        memnotify_psi_close(lev);
+}
+
+static bool
+memnotify_psi_open_all(void)
+{
+    bool res = false;
+
+    memnotify_psi_close_all();
+
+    for( memnotify_level_t lev = 0; lev < MEMNOTIFY_LEVEL_COUNT; ++lev ) {
+        if( !memnotify_psi[lev].mnp_in_use )
+            continue;
+        if( !memnotify_psi_open(lev) )
+            goto EXIT;
+    }
+
+    res = true;
+
+EXIT:
+
+    // all or nothing
+    if( !res )
+        memnotify_psi_close_all();
+
+    return res;
+}
+
+/* ========================================================================= *
+ * CGROUP_INTERFACE
+ * ========================================================================= */
+
+/** Path to cgroup v2 memory.events file, or NULL */
+static gchar *memnotify_cgroup_path = 0;
+
+/** Glib io watch id for memnotify_cgroup_fd */
+static guint memnotify_cgroup_rx_id = 0;
+
+/** Previously seen memory.events counter values */
+static struct
+{
+    gint64 high;
+    gint64 max;
+    gint64 oom;
+    gint64 oom_kill;
+} memnotify_cgroup_events;
+
+/** Read memory.events and raise pressure level on counter increments
+ *
+ * @param notify  false to just update the cached counter values
+ */
+static bool
+memnotify_cgroup_read_events(bool notify)
+{
+    bool res = false;
+    char tmp[512];
+
+    if( lseek(memnotify_cgroup_fd, 0, SEEK_SET) == -1 ) {
+        mce_log(LL_ERR, "%s: seek failed: %m", memnotify_cgroup_path);
+        goto EXIT;
+    }
+
+    int done = read(memnotify_cgroup_fd, tmp, sizeof tmp - 1);
+    if( done <= 0 ) {
+        mce_log(LL_ERR, "%s: no data: %m", memnotify_cgroup_path);
+        goto EXIT;
+    }
+
+    tmp[done] = 0;
+
+    memnotify_level_t lev = MEMNOTIFY_LEVEL_NORMAL;
+
+    for( char *pos = tmp; *pos; ) {
+        char   *key = memnotify_token_parse(&pos);
+        char   *val = memnotify_token_parse(&pos);
+        gint64  num = g_ascii_strtoll(val, 0, 10);
+        gint64 *ptr = 0;
+
+        if( !strcmp(key, "high") )
+            ptr = &memnotify_cgroup_events.high;
+        else if( !strcmp(key, "max") )
+            ptr = &memnotify_cgroup_events.max;
+        else if( !strcmp(key, "oom") )
+            ptr = &memnotify_cgroup_events.oom;
+        else if( !strcmp(key, "oom_kill") )
+            ptr = &memnotify_cgroup_events.oom_kill;
+        else
+            continue;
+
+        if( *ptr < num ) {
+            mce_log(LL_DEBUG, "%s: %"G_GINT64_FORMAT" -> %"G_GINT64_FORMAT,
+                    key, *ptr, num);
+            if( ptr == &memnotify_cgroup_events.high ) {
+                if( lev < MEMNOTIFY_LEVEL_WARNING )
+                    lev = MEMNOTIFY_LEVEL_WARNING;
+            }
+            else {
+                lev = MEMNOTIFY_LEVEL_CRITICAL;
+            }
+        }
+        *ptr = num;
+    }
+
+    if( notify && lev != MEMNOTIFY_LEVEL_NORMAL )
+        memnotify_pressure_raise(lev);
+
+    res = true;
+
+EXIT:
+
+    return res;
+}
+
+/** Input watch callback for cgroup memory.events file
+ */
+static gboolean
+memnotify_cgroup_rx_cb(GIOChannel *chn, GIOCondition cnd, gpointer aptr)
+{
+    (void) chn;
+    (void) aptr;
+
+    gboolean keep_going = FALSE;
+
+    if( !memnotify_cgroup_rx_id )
+        goto EXIT;
+
+    /* Kernfs signals modifications with POLLPRI | POLLERR */
+    if( cnd & ~(G_IO_PRI | G_IO_ERR) ) {
+        mce_log(LL_WARN, "unexpected input watch condition");
+        goto EXIT;
+    }
+
+    if( !memnotify_cgroup_read_events(true) )
+        goto EXIT;
+
+    keep_going = TRUE;
+
+EXIT:
+
+    if( !keep_going && memnotify_cgroup_rx_id ) {
+        memnotify_cgroup_rx_id = 0;
+        mce_log(LL_CRIT, "disabling input watch");
+    }
+    return keep_going;
+}
+
+/** Stop tracking cgroup memory events
+ */
+static void
+memnotify_cgroup_close(void)
+{
+    if( memnotify_cgroup_rx_id ) {
+        g_source_remove(memnotify_cgroup_rx_id),
+            memnotify_cgroup_rx_id = 0;
+    }
+
+    if( memnotify_cgroup_fd != -1 ) {
+        close(memnotify_cgroup_fd),
+            memnotify_cgroup_fd = -1;
+    }
+
+    g_free(memnotify_cgroup_path),
+        memnotify_cgroup_path = 0;
+}
+
+/** Start tracking cgroup memory events, if configured
+ */
+static bool
+memnotify_cgroup_open(void)
+{
+    bool res = false;
+
+    memnotify_cgroup_path = mce_conf_get_string(MCE_CONF_MEMNOTIFY_GROUP,
+                                                MCE_CONF_MEMNOTIFY_CGROUP_EVENTS,
+                                                0);
+
+    if( !memnotify_cgroup_path || !*memnotify_cgroup_path )
+        goto EXIT;
+
+    memnotify_cgroup_fd = open(memnotify_cgroup_path, O_RDONLY | O_CLOEXEC);
+    if( memnotify_cgroup_fd == -1 ) {
+        mce_log(LL_ERR, "could not open: %s: %m", memnotify_cgroup_path);
+        goto EXIT;
+    }
+
+    /* Establish baseline counter values; events that happened
+     * before mce started must not elevate the level */
+    if( !memnotify_cgroup_read_events(false) )
+        goto EXIT;
+
+    memnotify_cgroup_rx_id =
+        memnotify_iowatch_add(memnotify_cgroup_fd,
+                              false,
+                              G_IO_PRI,
+                              memnotify_cgroup_rx_cb,
+                              0);
+
+    if( !memnotify_cgroup_rx_id ) {
+        mce_log(LL_ERR, "could add iowatch: %s", memnotify_cgroup_path);
+        goto EXIT;
+    }
+
+    mce_log(LL_DEBUG, "tracking %s", memnotify_cgroup_path);
+
+    res = true;
+
+EXIT:
+
+    // all or nothing
+    if( !res )
+        memnotify_cgroup_close();
+
+    return res;
+}
+
 /* ========================================================================= *
  * DYNAMIC_SETTINGS
  * ========================================================================= */
@@ -717,6 +1239,15 @@ static guint memnotify_setting_critical_used_id = 0;
 /** GConf notification id for memnotify.critical.active level */
 static guint memnotify_setting_critical_active_id = 0;
 
+/** GConf notification id for memnotify.warning.stall level */
+static guint memnotify_setting_warning_stall_id = 0;
+
+/** GConf notification id for memnotify.critical.stall level */
+static guint memnotify_setting_critical_stall_id = 0;
+
+/** GConf notification id for memnotify.stall_window */
+static guint memnotify_setting_stall_window_id = 0;
+
 /** GConf callback for memnotify related settings
  *
  * @param gcc    (not used)
@@ -776,6 +1307,33 @@ memnotify_setting_cb(GConfClient *const gcc, const guint id,
             memnotify_status_update_triggers();
         }
     }
+    else if( id == memnotify_setting_warning_stall_id ) {
+        gint old = memnotify_stall[MEMNOTIFY_LEVEL_WARNING];
+        gint val = gconf_value_get_int(gcv);
+        if( old != val ) {
+            mce_log(LL_DEBUG, "memnotify.warning.stall: %d -> %d", old, val);
+            memnotify_stall[MEMNOTIFY_LEVEL_WARNING] = val;
+            memnotify_status_update_triggers();
+        }
+    }
+    else if( id == memnotify_setting_critical_stall_id ) {
+        gint old = memnotify_stall[MEMNOTIFY_LEVEL_CRITICAL];
+        gint val = gconf_value_get_int(gcv);
+        if( old != val ) {
+            mce_log(LL_DEBUG, "memnotify.critical.stall: %d -> %d", old, val);
+            memnotify_stall[MEMNOTIFY_LEVEL_CRITICAL] = val;
+            memnotify_status_update_triggers();
+        }
+    }
+    else if( id == memnotify_setting_stall_window_id ) {
+        gint old = memnotify_stall_window;
+        gint val = gconf_value_get_int(gcv);
+        if( old != val ) {
+            mce_log(LL_DEBUG, "memnotify.stall_window: %d -> %d", old, val);
+            memnotify_stall_window = val;
+            memnotify_status_update_triggers();
+        }
+    }
     else {
         mce_log(LL_WARN, "Spurious GConf value received; confused!");
     }
@@ -825,6 +1383,33 @@ static void memnotify_setting_init(void)
     mce_setting_get_int(MCE_SETTING_MEMNOTIFY_CRITICAL_ACTIVE,
                         &memnotify_limit[MEMNOTIFY_LEVEL_CRITICAL].mnl_active);
 
+    /* memnotify.warning.stall level */
+    mce_setting_notifier_add(MCE_SETTING_MEMNOTIFY_WARNING_PATH,
+                             MCE_SETTING_MEMNOTIFY_WARNING_STALL,
+                             memnotify_setting_cb,
+                             &memnotify_setting_warning_stall_id);
+
+    mce_setting_get_int(MCE_SETTING_MEMNOTIFY_WARNING_STALL,
+                        &memnotify_stall[MEMNOTIFY_LEVEL_WARNING]);
+
+    /* memnotify.critical.stall level */
+    mce_setting_notifier_add(MCE_SETTING_MEMNOTIFY_CRITICAL_PATH,
+                             MCE_SETTING_MEMNOTIFY_CRITICAL_STALL,
+                             memnotify_setting_cb,
+                             &memnotify_setting_critical_stall_id);
+
+    mce_setting_get_int(MCE_SETTING_MEMNOTIFY_CRITICAL_STALL,
+                        &memnotify_stall[MEMNOTIFY_LEVEL_CRITICAL]);
+
+    /* memnotify.stall_window */
+    mce_setting_notifier_add(MCE_SETTING_MEMNOTIFY_PATH,
+                             MCE_SETTING_MEMNOTIFY_STALL_WINDOW,
+                             memnotify_setting_cb,
+                             &memnotify_setting_stall_window_id);
+
+    mce_setting_get_int(MCE_SETTING_MEMNOTIFY_STALL_WINDOW,
+                        &memnotify_stall_window);
+
     memnotify_status_show_triggers();
 }
 
@@ -843,6 +1428,15 @@ static void memnotify_setting_quit(void)
 
     mce_setting_notifier_remove(memnotify_setting_critical_active_id),
         memnotify_setting_critical_active_id = 0;
+
+    mce_setting_notifier_remove(memnotify_setting_warning_stall_id),
+        memnotify_setting_warning_stall_id = 0;
+
+    mce_setting_notifier_remove(memnotify_setting_critical_stall_id),
+        memnotify_setting_critical_stall_id = 0;
+
+    mce_setting_notifier_remove(memnotify_setting_stall_window_id),
+        memnotify_setting_stall_window_id = 0;
 }
 
 /* ========================================================================= *
@@ -855,7 +1449,7 @@ static void
 memnotify_dbus_broadcast_level(void)
 {
     const char *sig = MCE_MEMORY_LEVEL_SIG;
-    const char *arg = memnotify_level_name(memnotify_level);
+    const char *arg = memnotify_level_repr(memnotify_level);
     mce_log(LL_DEVEL, "sending dbus signal: %s %s", sig, arg);
     dbus_send(0, MCE_SIGNAL_PATH, MCE_SIGNAL_IF, sig, 0,
               DBUS_TYPE_STRING, &arg, DBUS_TYPE_INVALID);
@@ -874,7 +1468,7 @@ memnotify_dbus_get_level_cb(DBusMessage *const req)
             mce_dbus_get_message_sender_ident(req));
 
     DBusMessage *rsp = dbus_new_method_reply(req);
-    const char  *arg = memnotify_level_name(memnotify_level);
+    const char  *arg = memnotify_level_repr(memnotify_level);
 
     if( !dbus_message_append_args(rsp,
                                   DBUS_TYPE_STRING, &arg,
@@ -949,9 +1543,28 @@ const gchar *g_module_check_init(GModule *module)
     memnotify_dbus_init();
     memnotify_setting_init();
 
-    /* Do not even attempt to set up tracking if the memnotify
-     * device node is not available */
-    if( !memnotify_dev_is_available() ) {
+    bool active = false;
+
+    /* The legacy memnotify device node takes precedence, pressure
+     * stall information is used on kernels that do not have it */
+    if( memnotify_dev_is_available() ) {
+        if( !memnotify_dev_open_all() )
+            goto EXIT;
+        memnotify_dev_active = true;
+        active = true;
+    }
+    else if( memnotify_psi_is_available() ) {
+        memnotify_psi_active = true;
+        active = true;
+    }
+
+    /* Cgroup v2 memory events can be tracked alongside either */
+    if( memnotify_cgroup_open() )
+        active = true;
+
+    /* Do not even attempt to set up tracking if neither the memnotify
+     * device node nor pressure stall information is available */
+    if( !active ) {
         /* Since it is expectional that  /dev/memnotify is present,
          * we must not complain about it missing in default verbosity
          * level
@@ -963,9 +1576,6 @@ const gchar *g_module_check_init(GModule *module)
         goto EXIT;
     }
 
-    if( !memnotify_dev_open_all() )
-        goto EXIT;
-
     memnotify_status_update_triggers();
 
     mce_log(LL_NOTICE, "memnotify plugin active");
@@ -988,6 +1598,11 @@ void g_module_unload(GModule *module)
     memnotify_setting_quit();
     memnotify_dbus_quit();
     memnotify_dev_close_all();
+    memnotify_dev_active = false;
+    memnotify_psi_close_all();
+    memnotify_psi_active = false;
+    memnotify_cgroup_close();
+    memnotify_pressure_quit();
 
     return;
 }
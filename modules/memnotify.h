@@ -30,4 +30,38 @@
 # define MCE_SETTING_MEMNOTIFY_CRITICAL_ACTIVE  MCE_SETTING_MEMNOTIFY_PATH"/critical/active"
 # define MCE_DEFAULT_MEMNOTIFY_CRITICAL_ACTIVE  0 // = disabled
 
+/** Warning threshold for memory pressure stall [ms per window]
+ *
+ * Used when the kernel provides /proc/pressure/memory. The warning
+ * level is triggered by "some" tasks stalling on memory.
+ */
+# define MCE_SETTING_MEMNOTIFY_WARNING_STALL    MCE_SETTING_MEMNOTIFY_PATH"/warning/stall"
+# define MCE_DEFAULT_MEMNOTIFY_WARNING_STALL    70
+
+/** Critical threshold for memory pressure stall [ms per window]
+ *
+ * The critical level is triggered by "full" stalls, i.e. all
+ * non-idle tasks waiting for memory at the same time.
+ */
+# define MCE_SETTING_MEMNOTIFY_CRITICAL_STALL   MCE_SETTING_MEMNOTIFY_PATH"/critical/stall"
+# define MCE_DEFAULT_MEMNOTIFY_CRITICAL_STALL   100
+
+/** Memory pressure stall tracking window [ms] */
+# define MCE_SETTING_MEMNOTIFY_STALL_WINDOW     MCE_SETTING_MEMNOTIFY_PATH"/stall_window"
+# define MCE_DEFAULT_MEMNOTIFY_STALL_WINDOW     1000
+
+/* ========================================================================= *
+ * Configuration
+ * ========================================================================= */
+
+/** Name of memnotify configuration group */
+# define MCE_CONF_MEMNOTIFY_GROUP               "MemNotify"
+
+/** Path to cgroup v2 memory.events file to track; unset = disabled
+ *
+ * Increments of the "high" counter raise warning level, and increments
+ * of "max", "oom" and "oom_kill" counters raise critical level.
+ */
+# define MCE_CONF_MEMNOTIFY_CGROUP_EVENTS       "CgroupMemoryEvents"
+
 #endif /* MEMNOTIFY_H_ */
@@ -7,12 +7,16 @@
 #include "../mce.h"
 #include "../mce-log.h"
 #include "../mce-dbus.h"
+#include "../mce-modules.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 #include <gmodule.h>
 
+/** Module name */
+#define MODULE_NAME "packagekit"
+
 /* ========================================================================= *
  * D-BUS CONSTANTS
  * ========================================================================= */
@@ -93,6 +97,9 @@ static gboolean xpkgkit_property_changed_cb     (DBusMessage *sig);
 
 // MODULE_LOAD_UNLOAD
 
+static const gchar *xpkgkit_module_init(void);
+static void         xpkgkit_module_quit(void);
+
 G_MODULE_EXPORT const gchar *g_module_check_init(GModule *module);
 G_MODULE_EXPORT void         g_module_unload    (GModule *module);
 
@@ -638,16 +645,13 @@ static mce_dbus_handler_t handlers[] =
  * MODULE_LOAD_UNLOAD
  * ========================================================================= */
 
-/** Init function for the PackageKit module
- *
- * @param module (not used)
+/** Initialize the PackageKit module
  *
  * @return NULL on success, a string with an error message on failure
  */
-const gchar *g_module_check_init(GModule *module)
+static const gchar *
+xpkgkit_module_init(void)
 {
-    (void)module;
-
     /* install datapipe handlers */
     xpkgkit_datapipe_init();
 
@@ -660,14 +664,11 @@ const gchar *g_module_check_init(GModule *module)
     return NULL;
 }
 
-/** Exit function for the PackageKit module
- *
- * @param module (not used)
+/** Cleanup the PackageKit module
  */
-void g_module_unload(GModule *module)
+static void
+xpkgkit_module_quit(void)
 {
-    (void)module;
-
     /* remove dbus message handlers */
     mce_dbus_handler_unregister_array(handlers);
 
@@ -676,5 +677,34 @@ void g_module_unload(GModule *module)
 
     /* cancel pending dbus requests */
     xpkgkit_logging_cancel_start();
-    return;
+}
+
+/** Init function for the PackageKit module
+ *
+ * Update tracking is not needed for bringing up the display,
+ * so the actual initialization is deferred until after that.
+ *
+ * @param module (not used)
+ *
+ * @return NULL on success, a string with an error message on failure
+ */
+const gchar *g_module_check_init(GModule *module)
+{
+    (void)module;
+
+    return mce_modules_defer(MODULE_NAME,
+                             MCE_MODULE_STARTUP_AFTER_DISPLAY, NULL,
+                             xpkgkit_module_init,
+                             xpkgkit_module_quit);
+}
+
+/** Exit function for the PackageKit module
+ *
+ * Cleanup is done via xpkgkit_module_quit() from mce-modules.
+ *
+ * @param module (not used)
+ */
+void g_module_unload(GModule *module)
+{
+    (void)module;
 }
@@ -63,14 +63,10 @@ static submode_t submode = MCE_NORMAL_SUBMODE;
 /** Configuration value for use proximity sensor */
 static gboolean use_ps_conf_value = MCE_DEFAULT_PROXIMITY_PS_ENABLED;
 
-/** Configuration change id for use_ps_conf_value */
-static guint use_ps_conf_id = 0;
 
 /** Configuration value for ps acts as lid sensor */
 static gboolean ps_acts_as_lid = MCE_DEFAULT_PROXIMITY_PS_ACTS_AS_LID;
 
-/** Configuration change id for ps_acts_as_lid */
-static guint ps_acts_as_lid_conf_id = 0;
 
 /** Broadcast proximity state within MCE
  *
@@ -209,59 +205,60 @@ EXIT:
 	return;
 }
 
-/** GConf callback for use proximity sensor setting
+/** Change hook for use proximity sensor setting
  *
- * @param gcc   (not used)
- * @param id    Connection ID from gconf_client_notify_add()
- * @param entry The modified GConf entry
- * @param data  (not used)
+ * @param binding (not used)
  */
-static void use_ps_conf_cb(GConfClient *const gcc, const guint id,
-			   GConfEntry *const entry, gpointer const data)
+static void use_ps_conf_cb(const mce_setting_binding_t *binding)
 {
-	(void)gcc; (void)data;
+	(void)binding;
 
-	const GConfValue *gcv;
-
-	if( !(gcv = gconf_entry_get_value(entry)) ) {
-		mce_log(LL_WARN, "GConf value removed; confused!");
-		goto EXIT;
-	}
-
-	if( id == use_ps_conf_id ) {
-		gboolean old = use_ps_conf_value;
-		use_ps_conf_value = gconf_value_get_bool(gcv);
-
-		if( use_ps_conf_value == old )
-			goto EXIT;
-
-	}
-	else if( id == ps_acts_as_lid_conf_id ) {
-		gboolean old = ps_acts_as_lid;
-		ps_acts_as_lid = gconf_value_get_bool(gcv);
+	update_proximity_monitor();
+}
 
-		if( ps_acts_as_lid == old )
-			goto EXIT;
+/** Change hook for proximity sensor acts as lid setting
+ *
+ * @param binding (not used)
+ */
+static void ps_acts_as_lid_conf_cb(const mce_setting_binding_t *binding)
+{
+	(void)binding;
 
-		if( ps_acts_as_lid ) {
-			// ps is lid now -> set ps to open state
-			report_proximity(COVER_OPEN);
-		}
-		else {
-			// ps is ps again -> invalidate lid state
-			report_lid_input(COVER_UNDEF);
-		}
+	if( ps_acts_as_lid ) {
+		// ps is lid now -> set ps to open state
+		report_proximity(COVER_OPEN);
 	}
 	else {
-		mce_log(LL_WARN, "Spurious GConf value received; confused!");
-		goto EXIT;
+		// ps is ps again -> invalidate lid state
+		report_lid_input(COVER_UNDEF);
 	}
 
 	update_proximity_monitor();
-EXIT:
-	return;
 }
 
+/** Settings tracked by the proximity module */
+static mce_setting_binding_t proximity_setting_bindings[] =
+{
+	{
+		.key        = MCE_SETTING_PROXIMITY_PS_ENABLED,
+		.type       = MCE_SETTING_TYPE_BOOL,
+		.def_int    = MCE_DEFAULT_PROXIMITY_PS_ENABLED,
+		.value      = &use_ps_conf_value,
+		.changed_cb = use_ps_conf_cb,
+	},
+	{
+		.key        = MCE_SETTING_PROXIMITY_PS_ACTS_AS_LID,
+		.type       = MCE_SETTING_TYPE_BOOL,
+		.def_int    = MCE_DEFAULT_PROXIMITY_PS_ACTS_AS_LID,
+		.value      = &ps_acts_as_lid,
+		.changed_cb = ps_acts_as_lid_conf_cb,
+	},
+	// sentinel
+	{
+		.key = 0,
+	}
+};
+
 /**
  * Handle call state change
  *
@@ -338,19 +335,8 @@ const gchar *g_module_check_init(GModule *module)
 	append_output_trigger_to_datapipe(&submode_pipe,
 					  submode_trigger);
 
-	/* PS enabled setting */
-	mce_setting_track_bool(MCE_SETTING_PROXIMITY_PS_ENABLED,
-			       &use_ps_conf_value,
-			       MCE_DEFAULT_PROXIMITY_PS_ENABLED,
-			       use_ps_conf_cb,
-			       &use_ps_conf_id);
-
-	/* PS acts as LID sensor */
-	mce_setting_track_bool(MCE_SETTING_PROXIMITY_PS_ACTS_AS_LID,
-			       &ps_acts_as_lid,
-			       MCE_DEFAULT_PROXIMITY_PS_ACTS_AS_LID,
-			       use_ps_conf_cb,
-			       &ps_acts_as_lid_conf_id);
+	/* PS enabled and PS acts as LID sensor settings */
+	mce_setting_bindings_init(proximity_setting_bindings);
 
 	/* If the proximity sensor input is used for toggling
 	 * lid state, we must take care not to leave proximity
@@ -375,11 +361,7 @@ void g_module_unload(GModule *module)
 	(void)module;
 
 	/* Stop tracking setting changes  */
-	mce_setting_notifier_remove(use_ps_conf_id),
-		use_ps_conf_id = 0;
-
-	mce_setting_notifier_remove(ps_acts_as_lid_conf_id),
-		ps_acts_as_lid_conf_id = 0;
+	mce_setting_bindings_quit(proximity_setting_bindings);
 
 	/* Remove triggers/filters from datapipes */
 	remove_output_trigger_from_datapipe(&display_state_pipe,
@@ -57,11 +57,9 @@ static gint orientation_state_eff_id = 0;
 
 /** Use of flipover gesture enabled */
 static gboolean sg_flipover_gesture_enabled = MCE_DEFAULT_FLIPOVER_GESTURE_ENABLED;
-static guint    sg_flipover_gesture_enabled_setting_id = 0;
 
 /** Use of flipover gesture enabled */
 static gboolean sg_wrist_gesture_enabled = MCE_DEFAULT_WRIST_GESTURE_ENABLED;
-static guint    sg_wrist_gesture_enabled_setting_id = 0;
 
 /* ========================================================================= *
  * FUNCTIONS
@@ -97,7 +95,7 @@ static void     sg_datapipe_quit            (void);
  * DYNAMIC_SETTINGS
  * ------------------------------------------------------------------------- */
 
-static void     sg_setting_cb               (GConfClient *const gcc, const guint id, GConfEntry *const entry, gpointer const data);
+static void     sg_setting_wrist_gesture_cb (const mce_setting_binding_t *binding);
 
 static void     sg_setting_init             (void);
 static void     sg_setting_quit             (void);
@@ -464,73 +462,56 @@ static void sg_datapipe_quit(void)
  * DYNAMIC_SETTINGS
  * ========================================================================= */
 
-/**
- * GConf callback for display related settings
+/** Change hook for wrist gesture enabled setting
  *
- * @param gcc Unused
- * @param id Connection ID from gconf_client_notify_add()
- * @param entry The modified GConf entry
- * @param data Unused
+ * @param binding (not used)
  */
-static void sg_setting_cb(GConfClient *const gcc, const guint id,
-                          GConfEntry *const entry, gpointer const data)
+static void sg_setting_wrist_gesture_cb(const mce_setting_binding_t *binding)
 {
-    const GConfValue *gcv = gconf_entry_get_value(entry);
-
-    (void)gcc;
-    (void)data;
+    (void)binding;
 
-    /* Key is unset */
-    if (gcv == NULL) {
-        mce_log(LL_DEBUG, "GConf Key `%s' has been unset",
-                gconf_entry_get_key(entry));
-        goto EXIT;
+    mce_log(LL_DEBUG, "sg_wrist_gesture_enabled: %d", sg_wrist_gesture_enabled);
+    if (sg_wrist_gesture_enabled) {
+        mce_sensorfw_wrist_enable();
+    } else {
+        mce_sensorfw_wrist_disable();
     }
+}
 
-    if( id == sg_flipover_gesture_enabled_setting_id ) {
-        sg_flipover_gesture_enabled = gconf_value_get_bool(gcv);
-    }
-    else if( id == sg_wrist_gesture_enabled_setting_id ) {
-        sg_wrist_gesture_enabled = gconf_value_get_bool(gcv);
-		mce_log(LL_CRIT, "sg_wrist_gesture_enabled: %d", sg_wrist_gesture_enabled);
-        if (sg_wrist_gesture_enabled) {
-            mce_sensorfw_wrist_enable();
-        } else {
-            mce_sensorfw_wrist_disable();
-        }
-    }
-    else {
-        mce_log(LL_WARN, "Spurious GConf value received; confused!");
+/** Settings tracked by sensor-gestures module */
+static mce_setting_binding_t sg_setting_bindings[] =
+{
+    {
+        .key     = MCE_SETTING_FLIPOVER_GESTURE_ENABLED,
+        .type    = MCE_SETTING_TYPE_BOOL,
+        .def_int = MCE_DEFAULT_FLIPOVER_GESTURE_ENABLED,
+        .value   = &sg_flipover_gesture_enabled,
+    },
+    {
+        .key        = MCE_SETTING_WRIST_GESTURE_ENABLED,
+        .type       = MCE_SETTING_TYPE_BOOL,
+        .def_int    = MCE_DEFAULT_WRIST_GESTURE_ENABLED,
+        .value      = &sg_wrist_gesture_enabled,
+        .changed_cb = sg_setting_wrist_gesture_cb,
+    },
+    // sentinel
+    {
+        .key = 0,
     }
-
-EXIT:
-    return;
-}
+};
 
 /** Get initial setting values and start tracking changes
  */
 static void sg_setting_init(void)
 {
-    mce_setting_track_bool(MCE_SETTING_FLIPOVER_GESTURE_ENABLED,
-                           &sg_flipover_gesture_enabled,
-                           MCE_DEFAULT_FLIPOVER_GESTURE_ENABLED,
-                           sg_setting_cb,
-                           &sg_flipover_gesture_enabled_setting_id);
-    mce_setting_track_bool(MCE_SETTING_WRIST_GESTURE_ENABLED,
-                           &sg_wrist_gesture_enabled,
-                           MCE_DEFAULT_WRIST_GESTURE_ENABLED,
-                           sg_setting_cb,
-                           &sg_wrist_gesture_enabled_setting_id);
-    mce_log(LL_CRIT, "sg_setting_init        sg_wrist_gesture_enabled: %d", sg_wrist_gesture_enabled);
+    mce_setting_bindings_init(sg_setting_bindings);
+    mce_log(LL_DEBUG, "sg_setting_init        sg_wrist_gesture_enabled: %d", sg_wrist_gesture_enabled);
 }
 
 /** Stop tracking setting changes */
 static void sg_setting_quit(void)
 {
-    mce_setting_notifier_remove(sg_flipover_gesture_enabled_setting_id),
-        sg_flipover_gesture_enabled_setting_id = 0;
-    mce_setting_notifier_remove(sg_wrist_gesture_enabled_setting_id),
-        sg_wrist_gesture_enabled_setting_id = 0;
+    mce_setting_bindings_quit(sg_setting_bindings);
 }
 
 /* ========================================================================= *
@@ -32,6 +32,7 @@
 #include "mce-setting.h"
 #include "mce-dbus.h"
 #include "mce-dsme.h"
+#include "mce-sched.h"
 
 #include "modules/doubletap.h"
 
@@ -464,6 +465,7 @@ static bool pwrkey_stm_ignore_action        (void);
 static bool pwrkey_stm_pending_timers       (void);
 
 static void pwrkey_stm_rethink_wakelock     (void);
+static void pwrkey_stm_rethink_boost        (void);
 
 static void pwrkey_stm_store_initial_state  (void);
 static void pwrkey_stm_terminate            (void);
@@ -1658,6 +1660,8 @@ cleanup:
 static void
 pwrkey_stm_rethink_wakelock(void)
 {
+    pwrkey_stm_rethink_boost();
+
 #ifdef ENABLE_WAKELOCKS
     static bool have_lock = false;
 
@@ -1679,6 +1683,30 @@ EXIT:
 #endif
 }
 
+/** Check if we need scheduling priority boost for power key handling
+ *
+ * Boost is held while long / double press timers are pending so that
+ * the press duration gets evaluated without scheduling delays.
+ */
+static void
+pwrkey_stm_rethink_boost(void)
+{
+    static bool have_boost = false;
+
+    bool want_boost = pwrkey_stm_pending_timers();
+
+    if( have_boost == want_boost )
+        goto EXIT;
+
+    if( (have_boost = want_boost) )
+        mce_sched_boost_start("mce_pwrkey_stm", 0);
+    else
+        mce_sched_boost_stop("mce_pwrkey_stm");
+
+EXIT:
+    return;
+}
+
 static bool
 pwrkey_stm_pending_timers(void)
 {
@@ -0,0 +1,195 @@
+#include <check.h>
+#include <glib.h>
+
+#include "common.h"
+
+/* Tested module */
+#include "../../datapipe.c"
+
+/* ------------------------------------------------------------------------- *
+ * STUBS
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Note that the following modules are linked instead of providing stubs:
+ *
+ * 	- mce-lib.c
+ */
+
+EXTERN_STUB (
+int, mce_log_p_, (loglevel_t loglevel, const char *const file,
+		  const char *const function))
+{
+	(void)file;
+	(void)function;
+
+	return loglevel <= LL_DEBUG;
+}
+
+/* ------------------------------------------------------------------------- *
+ * TEST PIPE
+ * ------------------------------------------------------------------------- */
+
+static datapipe_struct ut_pipe;
+
+static gint ut_input_count  = 0;
+static gint ut_output_count = 0;
+static gint ut_output_value = -1;
+
+/* Value to re-execute the pipe with from output trigger, or -1 */
+static gint ut_nested_value = -1;
+
+static void ut_input_trigger(gconstpointer data)
+{
+	(void)data;
+
+	ut_input_count += 1;
+}
+
+static void ut_output_trigger(gconstpointer data)
+{
+	ut_output_count += 1;
+	ut_output_value = GPOINTER_TO_INT(data);
+
+	if( ut_nested_value != -1 ) {
+		gint value = ut_nested_value;
+		ut_nested_value = -1;
+		execute_datapipe(&ut_pipe, GINT_TO_POINTER(value),
+				 USE_INDATA, CACHE_INDATA);
+	}
+}
+
+static void ut_setup_pipe(change_policy_t change_only)
+{
+	setup_datapipe(&ut_pipe, READ_ONLY, DONT_FREE_CACHE,
+		       change_only, 0, GINT_TO_POINTER(0));
+	append_input_trigger_to_datapipe(&ut_pipe, ut_input_trigger);
+	append_output_trigger_to_datapipe(&ut_pipe, ut_output_trigger);
+
+	ut_input_count  = 0;
+	ut_output_count = 0;
+	ut_output_value = -1;
+	ut_nested_value = -1;
+}
+
+static void ut_teardown_pipe(void)
+{
+	remove_output_trigger_from_datapipe(&ut_pipe, ut_output_trigger);
+	remove_input_trigger_from_datapipe(&ut_pipe, ut_input_trigger);
+	free_datapipe(&ut_pipe);
+}
+
+static void ut_execute(gint value)
+{
+	execute_datapipe(&ut_pipe, GINT_TO_POINTER(value),
+			 USE_INDATA, CACHE_INDATA);
+}
+
+/* ------------------------------------------------------------------------- *
+ * TESTS
+ * ------------------------------------------------------------------------- */
+
+START_TEST (ut_check_notify_always)
+{
+	ut_setup_pipe(NOTIFY_ALWAYS);
+
+	ut_execute(1);
+	ut_execute(1);
+	ut_execute(1);
+
+	ck_assert_int_eq(ut_input_count, 3);
+	ck_assert_int_eq(ut_output_count, 3);
+	ck_assert_int_eq(ut_pipe.suppressed, 0);
+
+	ut_teardown_pipe();
+}
+END_TEST
+
+START_TEST (ut_check_notify_on_change)
+{
+	ut_setup_pipe(NOTIFY_ON_CHANGE);
+
+	/* The first execution is always notified */
+	ut_execute(0);
+	ck_assert_int_eq(ut_output_count, 1);
+	ck_assert_int_eq(ut_output_value, 0);
+
+	/* Repeated values skip output triggers only */
+	ut_execute(0);
+	ut_execute(0);
+	ck_assert_int_eq(ut_input_count, 3);
+	ck_assert_int_eq(ut_output_count, 1);
+	ck_assert_int_eq(ut_pipe.suppressed, 2);
+
+	/* Changes are notified */
+	ut_execute(1);
+	ck_assert_int_eq(ut_output_count, 2);
+	ck_assert_int_eq(ut_output_value, 1);
+	ck_assert_int_eq(GPOINTER_TO_INT(ut_pipe.cached_data), 1);
+
+	ut_execute(0);
+	ck_assert_int_eq(ut_output_count, 3);
+	ck_assert_int_eq(ut_output_value, 0);
+
+	/* Re-execution from cache is always notified */
+	execute_datapipe(&ut_pipe, NULL, USE_CACHE, DONT_CACHE_INDATA);
+	ck_assert_int_eq(ut_output_count, 4);
+	ck_assert_int_eq(ut_output_value, 0);
+	ck_assert_int_eq(ut_pipe.suppressed, 2);
+
+	ut_teardown_pipe();
+}
+END_TEST
+
+START_TEST (ut_check_notify_on_change_nested)
+{
+	ut_setup_pipe(NOTIFY_ON_CHANGE);
+
+	/* Nested execution with the value being notified is skipped */
+	ut_nested_value = 1;
+	ut_execute(1);
+	ck_assert_int_eq(ut_input_count, 2);
+	ck_assert_int_eq(ut_output_count, 1);
+	ck_assert_int_eq(ut_pipe.suppressed, 1);
+
+	/* Nested execution with a different value is notified, and
+	 * the following outer level repeat is then a change again */
+	ut_nested_value = 0;
+	ut_execute(2);
+	ck_assert_int_eq(ut_output_count, 3);
+	ck_assert_int_eq(ut_output_value, 0);
+
+	ut_execute(0);
+	ck_assert_int_eq(ut_output_count, 3);
+	ck_assert_int_eq(ut_pipe.suppressed, 2);
+
+	ut_teardown_pipe();
+}
+END_TEST
+
+static Suite *ut_datapipe_suite (void)
+{
+	Suite *s = suite_create ("ut_datapipe");
+
+	TCase *tc_core = tcase_create ("core");
+	tcase_add_test (tc_core, ut_check_notify_always);
+	tcase_add_test (tc_core, ut_check_notify_on_change);
+	tcase_add_test (tc_core, ut_check_notify_on_change_nested);
+	suite_add_tcase (s, tc_core);
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	int number_failed;
+	Suite *s = ut_datapipe_suite ();
+	SRunner *sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -95,6 +95,15 @@ typedef enum
 /** How long to wait for high lux after lid open [ms] */
 #define TKLOCK_LIDFILTER_SET_WAIT_FOR_LIGHT_DELAY 1200
 
+/** How long to wait before ending ui notification state [ms] */
+#define TKLOCK_UI_NOTIFY_END_DELAY 2000
+
+/** How much ui notification end is allowed to fire late [ms] */
+#define TKLOCK_UI_NOTIFY_END_SLACK 500
+
+/** How much notification ui exception autostop is allowed to fire late [ms] */
+#define TKLOCK_NOTIF_AUTOSTOP_SLACK 250
+
 /* ========================================================================= *
  * DATATYPES
  * ========================================================================= */
@@ -5394,9 +5403,10 @@ static gboolean tklock_ui_notify_beg_cb(gpointer data)
     if( tklock_ui_notify_end_id )
         g_source_remove(tklock_ui_notify_end_id);
 
-    tklock_ui_notify_end_id = g_timeout_add(2000,
-                                            tklock_ui_notify_end_cb,
-                                            0);
+    tklock_ui_notify_end_id =
+        mce_timeout_add_slack(TKLOCK_UI_NOTIFY_END_DELAY,
+                              TKLOCK_UI_NOTIFY_END_SLACK,
+                              tklock_ui_notify_end_cb, 0);
 
 EXIT:
 
@@ -6464,7 +6474,8 @@ tklock_notif_schedule_autostop(gint delay)
     tklock_notif_cancel_autostop();
     mce_log(LL_DEBUG, "scheduled in %d ms", delay);
     tklock_notif_state.tn_autostop_id =
-        g_timeout_add(delay, tklock_notif_autostop_cb, 0);
+        mce_timeout_add_slack(delay, TKLOCK_NOTIF_AUTOSTOP_SLACK,
+                              tklock_notif_autostop_cb, 0);
 }
 
 static void
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
@@ -21,6 +22,8 @@
 #include <poll.h>
 #include <glob.h>
 #include <getopt.h>
+#include <signal.h>
+#include <sys/ioctl.h>
 
 /** Flag for: emit event time stamps */
 static bool emit_event_time  = true;
@@ -28,16 +31,324 @@ static bool emit_event_time  = true;
 /** Flag for: emit time of day (of event read time) */
 static bool emit_time_of_day = false;
 
+/* ------------------------------------------------------------------------- *
+ * STATISTICS
+ * ------------------------------------------------------------------------- */
+
+/** Flag for: collect statistics instead of emitting events */
+static bool stats_mode = false;
+
+/** Statistics reporting interval [s]; 0 = report only at exit */
+static int stats_interval = 0;
+
+/** Clock to request for event time stamps via EVIOCSCLOCKID */
+static clockid_t stats_clock = CLOCK_MONOTONIC;
+
+/** Flag for: termination signal has been received */
+static volatile sig_atomic_t terminate_requested = 0;
+
+/** Number of histogram buckets; bucket n holds values in [2^n, 2^(n+1)) */
+#define HISTOGRAM_BUCKETS 32
+
+/** Histogram with power of two sized buckets */
+typedef struct
+{
+  /** Number of samples in each bucket; values < 1 go to bucket zero */
+  unsigned count[HISTOGRAM_BUCKETS];
+
+  /** Number of samples */
+  unsigned samples;
+
+  /** Smallest sample */
+  int64_t  min;
+
+  /** Largest sample */
+  int64_t  max;
+
+  /** Sum of samples */
+  int64_t  sum;
+} histogram_t;
+
+/** Per input device statistics */
+typedef struct
+{
+  /** Clock used for event time stamps */
+  clockid_t   clock;
+
+  /** Time when the first event was received [us] */
+  int64_t     first_us;
+
+  /** Time when the latest event was received [us] */
+  int64_t     last_us;
+
+  /** Number of events received */
+  unsigned    events;
+
+  /** Number of SYN_REPORT frames received */
+  unsigned    frames;
+
+  /** Number of events in the frame being received */
+  unsigned    frame_events;
+
+  /** Kernel time stamp of the previous SYN_REPORT [us]; 0 = none */
+  int64_t     frame_prev_us;
+
+  /** Previous inter-frame interval [us]; -1 = none */
+  int64_t     interval_prev_us;
+
+  /** Number of events in a frame, including SYN_REPORT */
+  histogram_t frame_size;
+
+  /** Time between SYN_REPORT kernel time stamps [us] */
+  histogram_t interval;
+
+  /** Change in inter-frame interval between frames [us] */
+  histogram_t jitter;
+
+  /** Delay from SYN_REPORT kernel time stamp to userspace receipt [us] */
+  histogram_t delay;
+} devstats_t;
+
+/** Signal handler for terminating statistics collection
+ *
+ * @param sig signal number (not used)
+ */
+static
+void
+stats_terminate_cb(int sig)
+{
+  (void)sig;
+
+  terminate_requested = 1;
+}
+
+/** Parse clock name given at command line
+ *
+ * @param name clock name: monotonic, boottime or realtime
+ * @param clk  where to store the clock id
+ *
+ * @return true on success, false if name is not known
+ */
+static
+bool
+stats_parse_clock(const char *name, clockid_t *clk)
+{
+  if( !strcmp(name, "monotonic") )
+    *clk = CLOCK_MONOTONIC;
+  else if( !strcmp(name, "boottime") )
+    *clk = CLOCK_BOOTTIME;
+  else if( !strcmp(name, "realtime") )
+    *clk = CLOCK_REALTIME;
+  else
+    return false;
+
+  return true;
+}
+
+/** Get current time of given clock
+ *
+ * @param clk clock id
+ *
+ * @return current time [us]
+ */
+static
+int64_t
+stats_get_time(clockid_t clk)
+{
+  struct timespec ts = { 0, 0 };
+
+  clock_gettime(clk, &ts);
+
+  return ts.tv_sec * INT64_C(1000000) + ts.tv_nsec / 1000;
+}
+
+/** Add sample to histogram
+ *
+ * @param self  histogram
+ * @param value sample value
+ */
+static
+void
+histogram_add(histogram_t *self, int64_t value)
+{
+  int bucket = 0;
+
+  while( bucket < HISTOGRAM_BUCKETS - 1 && (INT64_C(2) << bucket) <= value )
+  {
+    ++bucket;
+  }
+
+  self->count[bucket] += 1;
+
+  if( self->samples == 0 || self->min > value )
+    self->min = value;
+  if( self->samples == 0 || self->max < value )
+    self->max = value;
+
+  self->sum     += value;
+  self->samples += 1;
+}
+
+/** Write histogram to stdout
+ *
+ * @param self  histogram
+ * @param title what the samples are
+ * @param unit  unit of the samples
+ */
+static
+void
+histogram_print(const histogram_t *self, const char *title, const char *unit)
+{
+  unsigned peak = 0;
+
+  printf("  %s [%s]: n=%u", title, unit, self->samples);
+
+  if( self->samples == 0 )
+  {
+    printf("\n");
+    return;
+  }
+
+  printf(" min=%lld avg=%.1f max=%lld\n",
+         (long long)self->min,
+         (double)self->sum / self->samples,
+         (long long)self->max);
+
+  for( int i = 0; i < HISTOGRAM_BUCKETS; ++i )
+  {
+    if( peak < self->count[i] )
+      peak = self->count[i];
+  }
+
+  for( int i = 0; i < HISTOGRAM_BUCKETS; ++i )
+  {
+    if( self->count[i] == 0 )
+      continue;
+
+    long long lo = i ? (1LL << i) : 0;
+    long long hi = (2LL << i) - 1;
+    int       w  = (int)(40ULL * self->count[i] / peak);
+
+    printf("    %9lld - %9lld: %8u %5.1f%% %.*s\n",
+           lo, hi, self->count[i],
+           100.0 * self->count[i] / self->samples,
+           w ? w : 1, "########################################");
+  }
+}
+
+/** Update device statistics with received events
+ *
+ * @param self  device statistics
+ * @param eve   array of input events
+ * @param n     number of input events
+ * @param now   time when the events were read [us]
+ */
+static
+void
+stats_update(devstats_t *self, const struct input_event *eve, int n,
+             int64_t now)
+{
+  if( self->events == 0 )
+  {
+    self->first_us = now;
+    self->interval_prev_us = -1;
+  }
+
+  self->last_us = now;
+
+  for( int i = 0; i < n; ++i )
+  {
+    const struct input_event *e = &eve[i];
+
+    self->events       += 1;
+    self->frame_events += 1;
+
+    if( e->type != EV_SYN || e->code != SYN_REPORT )
+      continue;
+
+    int64_t t = e->time.tv_sec * INT64_C(1000000) + e->time.tv_usec;
+
+    self->frames += 1;
+
+    histogram_add(&self->frame_size, self->frame_events);
+    self->frame_events = 0;
+
+    histogram_add(&self->delay, now - t);
+
+    if( self->frame_prev_us )
+    {
+      int64_t interval = t - self->frame_prev_us;
+
+      histogram_add(&self->interval, interval);
+
+      if( self->interval_prev_us >= 0 )
+      {
+        int64_t jitter = interval - self->interval_prev_us;
+        histogram_add(&self->jitter, jitter < 0 ? -jitter : jitter);
+      }
+
+      self->interval_prev_us = interval;
+    }
+
+    self->frame_prev_us = t;
+  }
+}
+
+/** Write device statistics to stdout
+ *
+ * @param self  device statistics
+ * @param title device path
+ */
+static
+void
+stats_print(const devstats_t *self, const char *title)
+{
+  const char *clk = "realtime";
+
+  switch( self->clock )
+  {
+  case CLOCK_MONOTONIC: clk = "monotonic"; break;
+  case CLOCK_BOOTTIME:  clk = "boottime";  break;
+  default: break;
+  }
+
+  double secs = (self->last_us - self->first_us) * 1e-6;
+
+  printf("----====( %s )====----\n", title);
+  printf("  clock: %s\n", clk);
+  printf("  events: %u, frames: %u, duration: %.3f s\n",
+         self->events, self->frames, secs);
+
+  if( secs > 0 )
+  {
+    printf("  rate: %.1f events/s, %.1f frames/s\n",
+           self->events / secs, self->frames / secs);
+  }
+
+  histogram_print(&self->frame_size, "frame size", "events");
+  histogram_print(&self->interval,   "frame interval", "us");
+  histogram_print(&self->jitter,     "frame interval jitter", "us");
+  histogram_print(&self->delay,      "kernel to userspace delay", "us");
+  printf("\n");
+}
+
+/* ------------------------------------------------------------------------- *
+ * EVENT_PROCESSING
+ * ------------------------------------------------------------------------- */
+
 /** Read and show input events
  *
- * @param fd   input device file descriptor to read from
+ * In statistics mode events are not shown, just accounted.
+ *
+ * @param fd    input device file descriptor to read from
  * @param title text to print before event details
+ * @param stats device statistics to update
  *
  * @return positive value on success, 0 on eof, -1 on errors
  */
 static
 int
-process_events(int fd, const char *title)
+process_events(int fd, const char *title, devstats_t *stats)
 {
   struct input_event eve[256];
   char tod[64], toe[64];
@@ -58,6 +369,12 @@ process_events(int fd, const char *title)
 
   n /= sizeof *eve;
 
+  if( stats_mode )
+  {
+    stats_update(stats, eve, n, stats_get_time(stats->clock));
+    return 1;
+  }
+
   *tod = 0;
   if( emit_time_of_day )
   {
@@ -115,8 +432,12 @@ void
 mainloop(char **path, int count, int identify, int trace)
 {
   struct pollfd pfd[count];
+  devstats_t    stats[count];
 
   int closed = 0;
+  int64_t report_us = 0;
+
+  memset(stats, 0, sizeof stats);
 
   for( int i = 0; i < count; ++i )
   {
@@ -126,6 +447,19 @@ mainloop(char **path, int count, int identify, int trace)
       continue;
     }
 
+    /* Kernel uses realtime stamps unless told otherwise */
+    stats[i].clock = CLOCK_REALTIME;
+
+    if( stats_mode )
+    {
+      int clk = stats_clock;
+
+      if( ioctl(pfd[i].fd, EVIOCSCLOCKID, &clk) == -1 )
+        mce_log(LL_WARN, "%s: EVIOCSCLOCKID: %m", path[i]);
+      else
+        stats[i].clock = stats_clock;
+    }
+
     if( identify )
     {
       printf("----====( %s )====----\n", path[i]);
@@ -152,20 +486,52 @@ mainloop(char **path, int count, int identify, int trace)
     goto cleanup;
   }
 
-  while( closed < count )
+  if( stats_mode && stats_interval > 0 )
+  {
+    report_us = stats_get_time(CLOCK_MONOTONIC) + stats_interval * INT64_C(1000000);
+  }
+
+  while( closed < count && !terminate_requested )
   {
+    int timeout = -1;
+
+    if( report_us )
+    {
+      int64_t now = stats_get_time(CLOCK_MONOTONIC);
+
+      if( now >= report_us )
+      {
+        for( int i = 0; i < count; ++i )
+        {
+          if( stats[i].events )
+            stats_print(&stats[i], path[i]);
+        }
+        report_us += stats_interval * INT64_C(1000000);
+        if( report_us < now )
+          report_us = now + stats_interval * INT64_C(1000000);
+      }
+      timeout = (int)((report_us - now + 999) / 1000);
+    }
+
     for( int i = 0; i < count; ++i )
     {
       pfd[i].events = (pfd[i].fd < 0) ? 0 : POLLIN;
+      pfd[i].revents = 0;
     }
 
-    poll(pfd, count, -1);
+    if( poll(pfd, count, timeout) == -1 )
+    {
+      if( errno == EINTR )
+        continue;
+      mce_log(LL_ERR, "poll: %m");
+      break;
+    }
 
     for( int i = 0; i < count; ++i )
     {
       if( pfd[i].revents )
       {
-        if( process_events(pfd[i].fd, path[i]) <= 0 )
+        if( process_events(pfd[i].fd, path[i], &stats[i]) <= 0 )
         {
           close(pfd[i].fd);
           pfd[i].fd = -1;
@@ -175,6 +541,15 @@ mainloop(char **path, int count, int identify, int trace)
     }
   }
 
+  if( stats_mode )
+  {
+    for( int i = 0; i < count; ++i )
+    {
+      if( stats[i].events )
+        stats_print(&stats[i], path[i]);
+    }
+  }
+
 cleanup:
 
   for( int i = 0; i < count; ++i )
@@ -192,6 +567,8 @@ static struct option optL[] =
   { "show-readers",  0, 0, 'I' },
   { "emit-also-tod", 0, 0, 'e' },
   { "emit-only-tod", 0, 0, 'E' },
+  { "statistics",    2, 0, 's' },
+  { "clock",         1, 0, 'c' },
   { 0,0,0,0 }
 };
 
@@ -203,6 +580,8 @@ static const char optS[] =
 "I" // --show-readers
 "e" // --emit-also-tod
 "E" // --emit-only-tod
+"s::" // --statistics
+"c:" // --clock
 ;
 
 /** Program name string */
@@ -270,12 +649,22 @@ static void usage(void)
          "  -e, --emit-also-tod  -- emit also time of day\n"
          "  -E, --emit-only-tod  -- emit only time of day\n"
          "  -I, --show-readers   -- identify processes using devices\n"
+         "  -s, --statistics[=<secs>]\n"
+         "                       -- collect event timing statistics; print\n"
+         "                          histograms every <secs> and at exit\n"
+         "  -c, --clock=<clock>  -- clock for event time stamps in statistics\n"
+         "                          mode: monotonic (default), boottime or\n"
+         "                          realtime\n"
          "\n"
          "NOTES\n"
          "  If no device paths are given, /dev/input/event* is assumed.\n"
          "  \n"
          "  Full device path is not required, \"/dev/input/event1\" can\n"
          "  be shortened to \"event1\" or just \"1\".\n"
+         "  \n"
+         "  Statistics mode implies --trace and runs until interrupted.\n"
+         "  Delays are measured from kernel SYN_REPORT time stamp to the\n"
+         "  time evdev_trace read the event.\n"
          "\n",
          progname);
 }
@@ -372,6 +761,21 @@ main(int argc, char **argv)
       emit_event_time  = false;
       break;
 
+    case 's':
+      stats_mode = true;
+      f_trace = 1;
+      if( optarg )
+        stats_interval = atoi(optarg);
+      break;
+
+    case 'c':
+      if( !stats_parse_clock(optarg, &stats_clock) )
+      {
+        fprintf(stderr, "%s: unknown clock\n", optarg);
+        goto cleanup;
+      }
+      break;
+
     case '?':
     case ':':
       goto cleanup;
@@ -392,6 +796,12 @@ main(int argc, char **argv)
     fileusers_init();
   }
 
+  if( stats_mode )
+  {
+    signal(SIGINT,  stats_terminate_cb);
+    signal(SIGTERM, stats_terminate_cb);
+  }
+
   if( optind < argc )
   {
     argc = 0;
@@ -22,6 +22,8 @@
 #include "../tklock.h"
 #include "../powerkey.h"
 #include "../event-input.h"
+#include "../datapipe.h"
+#include "../mce-prof.h"
 #include "../modules/display.h"
 #include "../modules/doubletap.h"
 #include "../modules/powersavemode.h"
@@ -40,6 +42,7 @@
 #include <errno.h>
 #include <math.h>
 #include <syslog.h>
+#include <setjmp.h>
 
 #include <dbus/dbus.h>
 
@@ -983,6 +986,177 @@ static void dbushelper_abandon_stack(DBusMessageIter *stack,
                 dbus_message_iter_abandon_container(iter, iter+1);
 }
 
+/* ------------------------------------------------------------------------- *
+ * BATCH MODE PIPELINING
+ * ------------------------------------------------------------------------- */
+
+/** Default number of method calls in flight in batch mode */
+#define XBATCH_WINDOW_DEFAULT 16
+
+/** Book keeping data for one batch mode command */
+typedef struct
+{
+        /** Line number in batch input */
+        int      line;
+
+        /** Command as written in batch input */
+        gchar   *text;
+
+        /** Set if option handler and all pipelined calls succeeded */
+        gboolean ok;
+
+        /** Number of pipelined calls still in flight */
+        int      pending;
+
+        /** Time when handling was started [us, monotonic] */
+        int64_t  started;
+
+        /** Time when handling was finished [us, monotonic] */
+        int64_t  finished;
+} xbatch_cmd_t;
+
+/** Pipelined method call */
+typedef struct
+{
+        /** Pending reply */
+        DBusPendingCall *pc;
+
+        /** Batch command the call was made from */
+        xbatch_cmd_t    *cmd;
+
+        /** Method name, for diagnostic messages */
+        gchar           *member;
+
+        /** Reply validation callback, or NULL */
+        gboolean       (*check_cb)(DBusMessage *rsp);
+} xbatch_call_t;
+
+/** Maximum number of pipelined calls in flight; 0 = disabled */
+static int xbatch_window = XBATCH_WINDOW_DEFAULT;
+
+/** Batch command that is being executed, or NULL */
+static xbatch_cmd_t *xbatch_cmd = 0;
+
+/** Pipelined calls in flight, oldest first */
+static GQueue xbatch_calls = G_QUEUE_INIT;
+
+/** Return point for abandoning a batch command, valid while xbatch_cmd
+ *  is set */
+static jmp_buf xbatch_abort_env;
+
+/** Terminate due to invalid input
+ *
+ * In batch mode only the batch command that is being executed is
+ * abandoned, and handling continues from the next batch input line.
+ */
+static void xbatch_abort(void) __attribute__((noreturn));
+
+static void xbatch_abort(void)
+{
+        if( xbatch_cmd )
+                longjmp(xbatch_abort_env, 1);
+
+        exit(EXIT_FAILURE);
+}
+
+/** Wait for reply to pipelined call and account it to the batch command
+ *
+ * @param call pipelined call, will be released
+ */
+static void xbatch_call_complete(xbatch_call_t *call)
+{
+        DBusMessage *rsp = 0;
+        DBusError    err = DBUS_ERROR_INIT;
+        gboolean     ack = FALSE;
+
+        dbus_pending_call_block(call->pc);
+
+        if( !(rsp = dbus_pending_call_steal_reply(call->pc)) ) {
+                errorf("%s: no reply\n", call->member);
+                goto EXIT;
+        }
+
+        if( dbus_set_error_from_message(&err, rsp) ) {
+                errorf("%s: %s: %s\n", call->member, err.name, err.message);
+                goto EXIT;
+        }
+
+        ack = call->check_cb ? call->check_cb(rsp) : TRUE;
+
+EXIT:
+        if( !ack )
+                call->cmd->ok = FALSE;
+
+        if( --call->cmd->pending == 0 )
+                call->cmd->finished = g_get_monotonic_time();
+
+        dbus_error_free(&err);
+
+        if( rsp ) dbus_message_unref(rsp);
+
+        dbus_pending_call_unref(call->pc);
+        g_free(call->member);
+        g_free(call);
+}
+
+/** Wait for all pipelined calls to finish
+ */
+static void xbatch_pipeline_flush(void)
+{
+        xbatch_call_t *call;
+
+        while( (call = g_queue_pop_head(&xbatch_calls)) )
+                xbatch_call_complete(call);
+}
+
+/** Send method call without waiting for the reply in batch mode
+ *
+ * If the number of calls in flight would exceed the batch window,
+ * waits for the oldest reply first. Replies are handled in sending
+ * order, which is also the order in which mce handles the calls.
+ *
+ * @param req      method call message
+ * @param check_cb reply validation callback, or NULL
+ *
+ * @return TRUE if the call was pipelined, or FALSE if the caller
+ *         needs to make a blocking call
+ */
+static gboolean xbatch_pipeline_push(DBusMessage *req,
+                                     gboolean (*check_cb)(DBusMessage *rsp))
+{
+        gboolean         ack = FALSE;
+        DBusPendingCall *pc  = 0;
+        xbatch_call_t   *call;
+
+        if( !xbatch_cmd || xbatch_window < 1 )
+                goto EXIT;
+
+        while( g_queue_get_length(&xbatch_calls) >= (guint)xbatch_window )
+                xbatch_call_complete(g_queue_pop_head(&xbatch_calls));
+
+        if( !dbus_connection_send_with_reply(xdbus_init(), req, &pc, -1) || !pc ) {
+                errorf("%s: failed to send method call\n",
+                       dbus_message_get_member(req));
+                goto EXIT;
+        }
+
+        call = g_malloc0(sizeof *call);
+        call->pc       = pc, pc = 0;
+        call->cmd      = xbatch_cmd;
+        call->member   = g_strdup(dbus_message_get_member(req));
+        call->check_cb = check_cb;
+
+        xbatch_cmd->pending += 1;
+        g_queue_push_tail(&xbatch_calls, call);
+
+        ack = TRUE;
+
+EXIT:
+        if( pc ) dbus_pending_call_unref(pc);
+
+        return ack;
+}
+
 /* ------------------------------------------------------------------------- *
  * MCE SETTING IPC HELPERS
  * ------------------------------------------------------------------------- */
@@ -1172,6 +1346,56 @@ EXIT:
         return res;
 }
 
+/** Helper for validating reply to MCE_CONFIG_SET method call
+ *
+ * @param rsp method return message
+ *
+ * @return TRUE if mce accepted the new value, FALSE otherwise
+ */
+static gboolean xmce_setting_check_reply(DBusMessage *rsp)
+{
+        gboolean        res = FALSE;
+        DBusMessageIter body;
+
+        if( !dbushelper_init_read_iterator(rsp, &body) )
+                goto EXIT;
+        if( !dbushelper_read_boolean(&body, &res) )
+                res = FALSE;
+
+EXIT:
+        return res;
+}
+
+/** Send MCE_CONFIG_SET method call and check the reply
+ *
+ * In batch mode the call is pipelined and the reply is
+ * checked later on.
+ *
+ * @param req MCE_CONFIG_SET method call message
+ *
+ * @return TRUE on success or if the call was pipelined, FALSE on failure
+ */
+static gboolean xmce_setting_commit(DBusMessage *req)
+{
+        gboolean     res = FALSE;
+        DBusMessage *rsp = 0;
+
+        if( xbatch_pipeline_push(req, xmce_setting_check_reply) ) {
+                res = TRUE;
+                goto EXIT;
+        }
+
+        if( !(rsp = dbushelper_call_method(req)) )
+                goto EXIT;
+
+        res = xmce_setting_check_reply(rsp);
+
+EXIT:
+        if( rsp ) dbus_message_unref(rsp);
+
+        return res;
+}
+
 /** Set a boolean setting key to the specified value
  *
  * @param key The setting key to set the value of
@@ -1187,11 +1411,9 @@ static gboolean xmce_setting_set_bool(const gchar *const key,
 
         gboolean     res = FALSE;
         DBusMessage *req = 0;
-        DBusMessage *rsp = 0;
 
         DBusMessageIter stack[2];
         DBusMessageIter *wpos = stack;
-        DBusMessageIter *rpos = stack;
 
         if( !(req = xmce_setting_request(MCE_CONFIG_SET)) )
                 goto EXIT;
@@ -1208,18 +1430,12 @@ static gboolean xmce_setting_set_bool(const gchar *const key,
         if( wpos != stack )
                 abort();
 
-        if( !(rsp = dbushelper_call_method(req)) )
-                goto EXIT;
-        if( !dbushelper_init_read_iterator(rsp, rpos) )
-                goto EXIT;
-        if( !dbushelper_read_boolean(rpos, &res) )
-                res = FALSE;
+        res = xmce_setting_commit(req);
 
 EXIT:
         // make sure write iterator stack is collapsed
         dbushelper_abandon_stack(stack, wpos);
 
-        if( rsp ) dbus_message_unref(rsp);
         if( req ) dbus_message_unref(req);
 
         return res;
@@ -1239,11 +1455,9 @@ static gboolean xmce_setting_set_int(const gchar *const key, const gint value)
 
         gboolean     res = FALSE;
         DBusMessage *req = 0;
-        DBusMessage *rsp = 0;
 
         DBusMessageIter stack[2];
         DBusMessageIter *wpos = stack;
-        DBusMessageIter *rpos = stack;
 
         // construct request
         if( !(req = xmce_setting_request(MCE_CONFIG_SET)) )
@@ -1261,19 +1475,13 @@ static gboolean xmce_setting_set_int(const gchar *const key, const gint value)
         if( wpos != stack )
                 abort();
 
-        // get reply and process it
-        if( !(rsp = dbushelper_call_method(req)) )
-                goto EXIT;
-        if( !dbushelper_init_read_iterator(rsp, rpos) )
-                goto EXIT;
-        if( !dbushelper_read_boolean(rpos, &res) )
-                res = FALSE;
+        // send request and process reply
+        res = xmce_setting_commit(req);
 
 EXIT:
         // make sure write iterator stack is collapsed
         dbushelper_abandon_stack(stack, wpos);
 
-        if( rsp ) dbus_message_unref(rsp);
         if( req ) dbus_message_unref(req);
 
         return res;
@@ -1293,11 +1501,9 @@ static gboolean xmce_setting_set_string(const gchar *const key, const char *valu
 
         gboolean     res = FALSE;
         DBusMessage *req = 0;
-        DBusMessage *rsp = 0;
 
         DBusMessageIter stack[2];
         DBusMessageIter *wpos = stack;
-        DBusMessageIter *rpos = stack;
 
         // construct request
         if( !(req = xmce_setting_request(MCE_CONFIG_SET)) )
@@ -1315,19 +1521,13 @@ static gboolean xmce_setting_set_string(const gchar *const key, const char *valu
         if( wpos != stack )
                 abort();
 
-        // get reply and process it
-        if( !(rsp = dbushelper_call_method(req)) )
-                goto EXIT;
-        if( !dbushelper_init_read_iterator(rsp, rpos) )
-                goto EXIT;
-        if( !dbushelper_read_boolean(rpos, &res) )
-                res = FALSE;
+        // send request and process reply
+        res = xmce_setting_commit(req);
 
 EXIT:
         // make sure write iterator stack is collapsed
         dbushelper_abandon_stack(stack, wpos);
 
-        if( rsp ) dbus_message_unref(rsp);
         if( req ) dbus_message_unref(req);
 
         return res;
@@ -1352,11 +1552,9 @@ static gboolean xmce_setting_set_int_array(const gchar *const key,
 
         gboolean     res = FALSE;
         DBusMessage *req = 0;
-        DBusMessage *rsp = 0;
 
         DBusMessageIter stack[3];
         DBusMessageIter *wpos = stack;
-        DBusMessageIter *rpos = stack;
 
         // construct request
         if( !(req = xmce_setting_request(MCE_CONFIG_SET)) )
@@ -1378,19 +1576,13 @@ static gboolean xmce_setting_set_int_array(const gchar *const key,
         if( wpos != stack )
                 abort();
 
-        // get reply and process it
-        if( !(rsp = dbushelper_call_method(req)) )
-                goto EXIT;
-        if( !dbushelper_init_read_iterator(rsp, rpos) )
-                goto EXIT;
-        if( !dbushelper_read_boolean(rpos, &res) )
-                res = FALSE;
+        // send request and process reply
+        res = xmce_setting_commit(req);
 
 EXIT:
         // make sure write iterator stack is collapsed
         dbushelper_abandon_stack(stack, wpos);
 
-        if( rsp ) dbus_message_unref(rsp);
         if( req ) dbus_message_unref(req);
 
         return res;
@@ -1518,7 +1710,7 @@ static int xmce_parse_powerkeyevent(const char *args)
         int res = lookup(powerkeyevent_lut, args);
         if( res < 0 ) {
                 errorf("%s: not a valid power key event\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         return res;
 }
@@ -1549,7 +1741,7 @@ static int parse_inhibitmode(const char *args)
         int res = lookup(inhibitmode_lut, args);
         if( res < 0 ) {
                 errorf("%s: not a valid inhibit mode value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         return res;
 }
@@ -1597,7 +1789,7 @@ static unsigned xmce_parse_radio_states(const char *args)
 
                 if( !(bit = lookup(radio_states_lut, pos)) ) {
                         errorf("%s: not a valid radio state\n", pos);
-                        exit(EXIT_FAILURE);
+                        xbatch_abort();
                 }
 
                 res |= bit;
@@ -1625,7 +1817,7 @@ static gboolean xmce_parse_enabled(const char *args)
         int res = lookup(enabled_lut, args);
         if( res < 0 ) {
                 errorf("%s: not a valid enable value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         return res != 0;
 }
@@ -1642,7 +1834,7 @@ static int xmce_parse_integer(const char *args)
         int   res = strtol(args, &end, 0);
         if( end <= args || *end != 0 ) {
                 errorf("%s: not a valid integer value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         return res;
 }
@@ -1659,7 +1851,7 @@ static double xmce_parse_double(const char *args)
         double  res = strtod(args, &end);
         if( end <= args || *end != 0 ) {
                 errorf("%s: not a valid double value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         return res;
 }
@@ -1818,7 +2010,8 @@ EXIT:
 
 /** Convert comma separated list of bit names into bitmask
  *
- * Note: the function will exit() if unknown bit names are given
+ * Note: the function will terminate via xbatch_abort() if unknown
+ *       bit names are given
  *
  * @param lut  array of symbol_t objects
  * @param args string with comma separated bit names
@@ -1848,7 +2041,7 @@ static unsigned mcetool_parse_bitmask(const symbol_t *lut, const char *args)
 
                 if( !(bit = lookup(lut, pos)) ) {
                         errorf("%s: not a valid bit name\n", pos);
-                        exit(EXIT_FAILURE);
+                        xbatch_abort();
                 }
 
                 mask |= bit;
@@ -1940,7 +2133,7 @@ static bool set_led_breathing_limit(const char *args)
 
         if( val < 0 || val > 100 ) {
                 errorf("%d: invalid battery limit value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_LED_SW_BREATH_BATTERY_LIMIT, val);
         return true;
@@ -2411,7 +2604,7 @@ static bool xmce_set_call_state(const char *args)
 
         if( !calltype ) {
                 errorf("%s: invalid call state value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
 
         *calltype++ = 0;
@@ -2592,7 +2785,7 @@ static bool xmce_set_blank_prevent_mode(const char *args)
         int val = lookup(blanking_pause_modes, args);
         if( val < 0 ) {
                 errorf("%s: invalid display blank prevent mode\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_BLANKING_PAUSE_MODE, val);
         return true;
@@ -2624,7 +2817,7 @@ static bool xmce_set_display_brightness(const char *args)
 
         if( val < 1 || val > 100 ) {
                 errorf("%d: invalid brightness value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_BRIGHTNESS, val);
         return true;
@@ -2653,7 +2846,7 @@ static bool xmce_set_dimmed_brightness_static(const char *args)
 
         if( val < 1 || val > 100 ) {
                 errorf("%d: invalid brightness value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_DIM_STATIC_BRIGHTNESS, val);
         return true;
@@ -2682,7 +2875,7 @@ static bool xmce_set_dimmed_brightness_dynamic(const char *args)
 
         if( val < 1 || val > 100 ) {
                 errorf("%d: invalid brightness value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_DIM_DYNAMIC_BRIGHTNESS, val);
         return true;
@@ -2711,7 +2904,7 @@ static bool xmce_set_compositor_dimming_hi(const char *args)
 
         if( val < 0 || val > 100 ) {
                 errorf("%d: invalid threshold value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_DIM_COMPOSITOR_HI, val);
         return true;
@@ -2728,7 +2921,7 @@ static bool xmce_set_compositor_dimming_lo(const char *args)
 
         if( val < 0 || val > 100 ) {
                 errorf("%d: invalid threshold value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_DIM_COMPOSITOR_LO, val);
         return true;
@@ -2780,7 +2973,7 @@ static bool xmce_set_cabc_mode(const char *args)
         for( size_t i = 0; ; ++i ) {
                 if( !lut[i] ) {
                         errorf("%s: invalid cabc mode\n", args);
-                        exit(EXIT_FAILURE);
+                        xbatch_abort();
                 }
                 if( !strcmp(lut[i], args) )
                         break;
@@ -2887,12 +3080,12 @@ static bool xmce_set_dim_timeouts(const char *args)
 
         if( len != 5 ) {
                 errorf("%s: invalid dim timeout list\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         for( gint i = 1; i < len; ++i ) {
                 if( arr[i] <= arr[i-1] ) {
                         errorf("%s: dim timeout list not in ascending order\n", args);
-                        exit(EXIT_FAILURE);
+                        xbatch_abort();
                 }
         }
 
@@ -3211,7 +3404,7 @@ static bool xmce_set_lid_open_actions(const char *args)
         int val = lookup(lid_open_actions, args);
         if( val < 0 ) {
                 errorf("%s: invalid lid open actions\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_TK_LID_OPEN_ACTIONS, val);
         return true;
@@ -3246,7 +3439,7 @@ static bool xmce_set_lid_close_actions(const char *args)
         int val = lookup(lid_close_actions, args);
         if( val < 0 ) {
                 errorf("%s: invalid lid close actions\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_TK_LID_CLOSE_ACTIONS, val);
         return true;
@@ -3922,7 +4115,7 @@ static bool xmce_powerkey_event(const char *args)
         int val = xmce_parse_powerkeyevent(args);
         if( val < 0 ) {
                 errorf("%s: invalid power key event\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         /* com.nokia.mce.request.req_trigger_powerkey_event */
         dbus_uint32_t data = val;
@@ -3952,7 +4145,7 @@ static bool xmce_set_powerkey_action(const char *args)
         int val = lookup(powerkey_action, args);
         if( val < 0 ) {
                 errorf("%s: invalid powerkey policy value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_POWERKEY_MODE, val);
         return true;
@@ -3987,7 +4180,7 @@ static bool xmce_set_powerkey_blanking(const char *args)
         int val = lookup(powerkey_blanking, args);
         if( val < 0 ) {
                 errorf("%s: invalid powerkey blanking value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_POWERKEY_BLANKING_MODE, val);
         return true;
@@ -4123,7 +4316,7 @@ static bool xmce_is_powerkey_action_mask(const char *names)
 static void xmce_set_powerkey_action_mask(const char *key, const char *names)
 {
         if( names && *names && !xmce_is_powerkey_action_mask(names) )
-                exit(EXIT_FAILURE);
+                xbatch_abort();
 
         xmce_setting_set_string(key, names);
 }
@@ -4513,7 +4706,7 @@ static bool xmce_set_display_off_override(const char *args)
         int val = lookup(display_off_override, args);
         if( val < 0 ) {
                 errorf("%s: invalid display off override value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_OFF_OVERRIDE, val);
         return true;
@@ -4612,7 +4805,7 @@ static bool xmce_set_doubletap_wakeup(const char *args)
         int val = lookup(doubletap_wakeup, args);
         if( val < 0 ) {
                 errorf("%s: invalid doubletap policy value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DOUBLETAP_MODE, val);
         return true;
@@ -4674,7 +4867,7 @@ static bool xmce_set_psm_threshold(const char *args)
 
         if( val < 10 || val > 50 || val % 10 ) {
                 errorf("%d: invalid psm threshold value\n", val);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_EM_PSM_THRESHOLD, val);
         return true;
@@ -4925,6 +5118,38 @@ static bool xmce_set_memnotify_critical_active(const char *args)
         return true;
 }
 
+static bool xmce_set_memnotify_warning_stall(const char *args)
+{
+        xmce_setting_set_int(MCE_SETTING_MEMNOTIFY_WARNING_STALL,
+                             xmce_parse_integer(args));
+        return true;
+}
+
+static bool xmce_set_memnotify_critical_stall(const char *args)
+{
+        xmce_setting_set_int(MCE_SETTING_MEMNOTIFY_CRITICAL_STALL,
+                             xmce_parse_integer(args));
+        return true;
+}
+
+static bool xmce_set_memnotify_stall_window(const char *args)
+{
+        xmce_setting_set_int(MCE_SETTING_MEMNOTIFY_STALL_WINDOW,
+                             xmce_parse_integer(args));
+        return true;
+}
+
+static void xmce_get_memnotify_stall_helper(const char *title, const char *key)
+{
+        gint val = 0;
+        if( !xmce_setting_get_int(key, &val) )
+                printf("%-"PAD1"s %s\n", title, "unknown");
+        else if( val <= 0 )
+                printf("%-"PAD1"s %s\n", title, "disabled");
+        else
+                printf("%-"PAD1"s %d (ms)\n", title, (int)val);
+}
+
 static void xmce_get_memnotify_helper(const char *title, const char *key)
 {
         gint val = 0;
@@ -4952,6 +5177,15 @@ static void xmce_get_memnotify_limits(void)
 
         xmce_get_memnotify_helper("Memory use critical [active]:",
                                   MCE_SETTING_MEMNOTIFY_CRITICAL_ACTIVE);
+
+        xmce_get_memnotify_stall_helper("Memory stall warning [some]:",
+                                        MCE_SETTING_MEMNOTIFY_WARNING_STALL);
+
+        xmce_get_memnotify_stall_helper("Memory stall critical [full]:",
+                                        MCE_SETTING_MEMNOTIFY_CRITICAL_STALL);
+
+        xmce_get_memnotify_stall_helper("Memory stall window:",
+                                        MCE_SETTING_MEMNOTIFY_STALL_WINDOW);
 }
 
 static void xmce_get_memnotify_level(void)
@@ -5028,7 +5262,7 @@ static bool xmce_set_cpu_scaling_governor(const char *args)
         int val = lookup(governor_values, args);
         if( val < 0 ) {
                 errorf("%s: invalid cpu scaling governor value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_CPU_SCALING_GOVERNOR, val);
         return true;
@@ -5055,7 +5289,7 @@ static bool xmce_set_never_blank(const char *args)
         int val = lookup(never_blank_values, args);
         if( val < 0 ) {
                 errorf("%s: invalid never blank value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_DISPLAY_NEVER_BLANK, val);
         return true;
@@ -5070,6 +5304,35 @@ static void xmce_get_never_blank(void)
         printf("%-"PAD1"s %s \n", "Display never blank:", txt ?: "unknown");
 }
 
+/* ------------------------------------------------------------------------- *
+ * speculative display power up
+ * ------------------------------------------------------------------------- */
+
+/** Enable/disable speculative display power up on power key press
+ *
+ * @param args string suitable for interpreting as enabled/disabled
+ */
+static bool xmce_set_speculative_power_up(const char *args)
+{
+        debugf("%s(%s)\n", __FUNCTION__, args);
+        gboolean val = xmce_parse_enabled(args);
+        xmce_setting_set_bool(MCE_SETTING_DISPLAY_SPECULATIVE_POWER_UP, val);
+        return true;
+}
+
+/** Show current speculative display power up mode
+ */
+static void xmce_get_speculative_power_up(void)
+{
+        gboolean val = 0;
+        char txt[32];
+
+        strcpy(txt, "unknown");
+        if( xmce_setting_get_bool(MCE_SETTING_DISPLAY_SPECULATIVE_POWER_UP, &val) )
+                snprintf(txt, sizeof txt, "%s", val ? "enabled" : "disabled");
+        printf("%-"PAD1"s %s\n", "Speculative power up:", txt);
+}
+
 /* ------------------------------------------------------------------------- *
  * autosuspend on display blank policy
  * ------------------------------------------------------------------------- */
@@ -5080,7 +5343,7 @@ static bool xmce_set_suspend_policy(const char *args)
         int val = lookup(suspendpol_values, args);
         if( val < 0 ) {
                 errorf("%s: invalid suspend policy value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_USE_AUTOSUSPEND, val);
         return true;
@@ -5132,6 +5395,75 @@ EXIT:
         return true;
 }
 
+/** Make mce write recorded datapipe executions to a file
+ */
+static bool xmce_dump_datapipe_recording(const char *args)
+{
+        (void)args;
+
+        char *path = 0;
+
+        if( !xmce_ipc_string_reply(MCE_DATAPIPE_RECORDING_DUMP, &path,
+                                   DBUS_TYPE_INVALID) )
+                goto EXIT;
+
+        printf("%s\n", path);
+
+EXIT:
+        free(path);
+        return true;
+}
+
+/** Control main loop dispatch profiling in mce
+ *
+ * @param args start, stop or show
+ */
+static bool xmce_dispatch_profile(const char *args)
+{
+        debugf("%s(%s)\n", __FUNCTION__, args);
+
+        char *report = 0;
+
+        if( !strcmp(args, "start") ) {
+                xmce_ipc_no_reply(MCE_DISPATCH_PROFILE_START,
+                                  DBUS_TYPE_INVALID);
+        }
+        else if( !strcmp(args, "stop") ) {
+                xmce_ipc_no_reply(MCE_DISPATCH_PROFILE_STOP,
+                                  DBUS_TYPE_INVALID);
+        }
+        else if( !strcmp(args, "show") ) {
+                if( xmce_ipc_string_reply(MCE_DISPATCH_PROFILE_GET, &report,
+                                          DBUS_TYPE_INVALID) )
+                        printf("%s", report);
+        }
+        else {
+                errorf("%s: invalid dispatch profile action\n", args);
+                xbatch_abort();
+        }
+
+        free(report);
+        return true;
+}
+
+/** Print out startup timeline recorded by mce
+ */
+static bool xmce_get_startup_timeline(const char *args)
+{
+        (void)args;
+
+        debugf("%s()\n", __FUNCTION__);
+
+        char *report = 0;
+
+        if( xmce_ipc_string_reply(MCE_STARTUP_TIMELINE_GET, &report,
+                                  DBUS_TYPE_INVALID) )
+                printf("%s", report);
+
+        free(report);
+        return true;
+}
+
 /* ------------------------------------------------------------------------- *
  * display state statistics
  * ------------------------------------------------------------------------- */
@@ -5240,36 +5572,184 @@ EXIT:
 }
 
 /* ------------------------------------------------------------------------- *
- * use mouse clicks to emulate touchscreen doubletap policy
+ * display state transition statistics
  * ------------------------------------------------------------------------- */
 
-#ifdef ENABLE_DOUBLETAP_EMULATION
-static bool xmce_set_fake_doubletap(const char *args)
+/** Estimate percentile from display transition latency histogram
+ *
+ * @param hist   log2 histogram, see MCE_DISPLAY_TRANSITION_STATS_BUCKETS
+ * @param count  total number of samples
+ * @param max_ms largest sample seen
+ * @param pct    percentile to estimate, 0 ... 100
+ *
+ * @return upper bound of histogram bucket containing the percentile
+ */
+static int64_t xmce_transition_stats_percentile(const int64_t *hist,
+                                                int64_t count,
+                                                int64_t max_ms,
+                                                int pct)
 {
-        debugf("%s(%s)\n", __FUNCTION__, args);
-        int val = lookup(fake_doubletap_values, args);
-        if( val < 0 ) {
-                errorf("%s: invalid fake doubletap value\n", args);
-                exit(EXIT_FAILURE);
+        int64_t limit = (count * pct + 99) / 100;
+        int64_t accum = 0;
+
+        for( int i = 0; i < MCE_DISPLAY_TRANSITION_STATS_BUCKETS; ++i ) {
+                accum += hist[i];
+                if( accum < limit )
+                        continue;
+
+                int64_t upper = (int64_t)1 << i;
+                return upper < max_ms ? upper : max_ms;
         }
-        xmce_setting_set_bool(MCE_SETTING_USE_FAKE_DOUBLETAP, val != 0);
-        return true;
+
+        return max_ms;
 }
 
-/** Get current fake double tap policy from mce and print it out
+/** Get display state transition latency statistics
  */
-static void xmce_get_fake_doubletap(void)
+static bool xmce_get_display_transition_stats(const char *args)
 {
-        gboolean    val = 0;
-        const char *txt = 0;
-        if( xmce_setting_get_bool(MCE_SETTING_USE_FAKE_DOUBLETAP, &val) )
-                txt = rlookup(fake_doubletap_values, val);
-        printf("%-"PAD1"s %s \n", "Use fake doubletap:", txt ?: "unknown");
-}
-#endif /* ENABLE_DOUBLETAP_EMULATION */
+        bool human_readable = true;
 
-/* ------------------------------------------------------------------------- *
- * tklock
+        if( args ) {
+                if( !strcmp(args, "machine") )
+                        human_readable = false;
+                else if( !strcmp(args, "human") )
+                        human_readable = true;
+                else {
+                        errorf("unkown output mode: %s\n", args);
+                        return false;
+                }
+        }
+
+        DBusMessage *rsp  = NULL;
+        DBusError    err  = DBUS_ERROR_INIT;
+        gchar       *name = 0;
+
+        DBusMessageIter body, array, dict, entry, hist;
+
+        if( !xmce_ipc_message_reply(MCE_DISPLAY_TRANSITION_STATS_GET, &rsp, DBUS_TYPE_INVALID) )
+                goto EXIT;
+
+        if( !dbushelper_init_read_iterator(rsp, &body) )
+                goto EXIT;
+
+        if( !dbushelper_require_array_type(&body, DBUS_TYPE_DICT_ENTRY) )
+                goto EXIT;
+
+        if( !dbushelper_read_array(&body, &array) )
+                goto EXIT;
+
+        if( human_readable ) {
+                printf("%-36s %6s %6s %6s %6s %6s %6s %6s\n",
+                       "TRANSITION[:STEP]", "COUNT", "MIN", "AVG",
+                       "P50", "P90", "P99", "MAX");
+        }
+
+        while( !dbushelper_read_at_end(&array) ) {
+                g_free(name), name = 0;
+
+                if( !dbushelper_read_dict(&array, &dict) )
+                        goto EXIT;
+
+                if( !dbushelper_read_string(&dict, &name) )
+                        goto EXIT;
+
+                if( !dbushelper_read_struct(&dict, &entry) )
+                        goto EXIT;
+
+                int64_t count  = 0;
+                int64_t min_ms = 0;
+                int64_t max_ms = 0;
+                int64_t sum_ms = 0;
+                int64_t bins[MCE_DISPLAY_TRANSITION_STATS_BUCKETS] = { 0 };
+
+                if( !dbushelper_read_int64(&entry, &count) )
+                        goto EXIT;
+
+                if( !dbushelper_read_int64(&entry, &min_ms) )
+                        goto EXIT;
+
+                if( !dbushelper_read_int64(&entry, &max_ms) )
+                        goto EXIT;
+
+                if( !dbushelper_read_int64(&entry, &sum_ms) )
+                        goto EXIT;
+
+                if( !dbushelper_read_array(&entry, &hist) )
+                        goto EXIT;
+
+                for( int i = 0; !dbushelper_read_at_end(&hist); ++i ) {
+                        int64_t val = 0;
+                        if( !dbushelper_read_int64(&hist, &val) )
+                                goto EXIT;
+                        if( i < MCE_DISPLAY_TRANSITION_STATS_BUCKETS )
+                                bins[i] = val;
+                }
+
+                if( count <= 0 )
+                        continue;
+
+                if( human_readable ) {
+                        printf("%-36s %6"PRIi64" %6"PRIi64" %6"PRIi64
+                               " %6"PRIi64" %6"PRIi64" %6"PRIi64" %6"PRIi64"\n",
+                               name, count, min_ms, sum_ms / count,
+                               xmce_transition_stats_percentile(bins, count, max_ms, 50),
+                               xmce_transition_stats_percentile(bins, count, max_ms, 90),
+                               xmce_transition_stats_percentile(bins, count, max_ms, 99),
+                               max_ms);
+                }
+                else {
+                        printf("%s %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64,
+                               name, count, min_ms, max_ms, sum_ms);
+                        for( int i = 0; i < MCE_DISPLAY_TRANSITION_STATS_BUCKETS; ++i )
+                                printf(" %"PRIi64, bins[i]);
+                        printf("\n");
+                }
+        }
+EXIT:
+        g_free(name);
+
+        if( dbus_error_is_set(&err) ) {
+                errorf("%s: %s: %s\n", MCE_DISPLAY_TRANSITION_STATS_GET, err.name, err.message);
+                dbus_error_free(&err);
+        }
+
+        if( rsp ) dbus_message_unref(rsp);
+
+        return true;
+}
+
+/* ------------------------------------------------------------------------- *
+ * use mouse clicks to emulate touchscreen doubletap policy
+ * ------------------------------------------------------------------------- */
+
+#ifdef ENABLE_DOUBLETAP_EMULATION
+static bool xmce_set_fake_doubletap(const char *args)
+{
+        debugf("%s(%s)\n", __FUNCTION__, args);
+        int val = lookup(fake_doubletap_values, args);
+        if( val < 0 ) {
+                errorf("%s: invalid fake doubletap value\n", args);
+                xbatch_abort();
+        }
+        xmce_setting_set_bool(MCE_SETTING_USE_FAKE_DOUBLETAP, val != 0);
+        return true;
+}
+
+/** Get current fake double tap policy from mce and print it out
+ */
+static void xmce_get_fake_doubletap(void)
+{
+        gboolean    val = 0;
+        const char *txt = 0;
+        if( xmce_setting_get_bool(MCE_SETTING_USE_FAKE_DOUBLETAP, &val) )
+                txt = rlookup(fake_doubletap_values, val);
+        printf("%-"PAD1"s %s \n", "Use fake doubletap:", txt ?: "unknown");
+}
+#endif /* ENABLE_DOUBLETAP_EMULATION */
+
+/* ------------------------------------------------------------------------- *
+ * tklock
  * ------------------------------------------------------------------------- */
 
 /** Lookup table for tklock open values
@@ -5296,7 +5776,7 @@ static bool xmce_tklock_open(const char *args)
         int val = lookup(tklock_open_values, args);
         if( val < 0 ) {
                 errorf("%s: invalid tklock open value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
 
         DBusConnection *bus = xdbus_init();
@@ -5403,7 +5883,7 @@ static bool xmce_tklock_callback(const char *args)
         dbus_int32_t val = lookup(tklock_callback_values, args);
         if( val < 0 ) {
                 errorf("%s: invalidt klock callback value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
 
         xmce_ipc_no_reply(MCE_TKLOCK_CB_REQ,
@@ -5446,7 +5926,7 @@ static bool xmce_set_tklock_blank(const char *args)
         int val = lookup(tklockblank_values, args);
         if( val < 0 ) {
                 errorf("%s: invalid lockscreen blanking policy value\n", args);
-                exit(EXIT_FAILURE);
+                xbatch_abort();
         }
         xmce_setting_set_int(MCE_SETTING_TK_AUTO_BLANK_DISABLE, val);
         return true;
@@ -5527,6 +6007,7 @@ static bool xmce_get_status(const char *args)
         xmce_get_adaptive_dimming_mode();
         xmce_get_adaptive_dimming_time();
         xmce_get_never_blank();
+        xmce_get_speculative_power_up();
         xmce_get_blank_timeout();
         xmce_get_inhibit_mode();
         xmce_get_kbd_slide_inhibit_mode();
@@ -5588,79 +6069,744 @@ static bool xmce_get_status(const char *args)
         xmce_get_touch_unblock_delay();
         xmce_get_exception_lengths();
 
-        get_led_breathing_enabled();
-        get_led_breathing_limit();
-        xmce_get_memnotify_limits();
-        xmce_get_memnotify_level();
-        printf("\n");
+        get_led_breathing_enabled();
+        get_led_breathing_limit();
+        xmce_get_memnotify_limits();
+        xmce_get_memnotify_level();
+        printf("\n");
+
+        return true;
+}
+
+/* ------------------------------------------------------------------------- *
+ * special
+ * ------------------------------------------------------------------------- */
+
+/** Handle --block command line option
+ *
+ * @param args optarg from command line, or NULL
+ */
+static bool mcetool_block(const char *args)
+{
+        debugf("%s(%s)\n", __FUNCTION__, args ?: "inf");
+        struct timespec ts;
+
+        if( mcetool_parse_timspec(&ts, args) )
+                TEMP_FAILURE_RETRY(nanosleep(&ts, &ts));
+        else
+                pause();
+
+        return true;
+}
+
+/** Handle --demo-mode command line option
+ *
+ * @param args optarg from command line
+ */
+static bool xmce_set_demo_mode(const char *args)
+{
+        bool res = true;
+        debugf("%s(%s)\n", __FUNCTION__, args);
+        if( !strcmp(args, "on") ) {
+                // mcetool --unblank-screen
+                //         --set-inhibit-mode=stay-on
+                //         --set-tklock-mode=unlocked
+                //         --set-tklock-blank=disabled
+                xmce_set_display_state("on");
+                xmce_set_inhibit_mode("stay-on");
+                xmce_set_tklock_mode("unlocked");
+                xmce_set_tklock_blank("disabled");
+        }
+        else if( !strcmp(args, "dim")) {
+                // mcetool --dim-screen
+                //         --set-inhibit-mode=stay-dim
+                //         --set-tklock-mode=unlocked
+                //         --set-tklock-blank=disabled
+                xmce_set_display_state("dim");
+                xmce_set_inhibit_mode("stay-dim");
+                xmce_set_tklock_mode("unlocked");
+                xmce_set_tklock_blank("disabled");
+        }
+        else if( !strcmp(args, "off")) {
+                // mcetool --blank-screen
+                //         --set-inhibit-mode=disabled
+                //         --set-tklock-mode=locked
+                //         --set-tklock-blank=enabled
+                xmce_set_display_state("off");
+                xmce_set_inhibit_mode("disabled");
+                xmce_set_tklock_mode("locked");
+                xmce_set_tklock_blank("enabled");
+        }
+        else {
+                errorf("%s: invalid demo mode value\n", args);
+                res = false;
+        }
+
+        return res;
+}
+
+/* ========================================================================= *
+ * IPC BENCHMARK
+ * ========================================================================= */
+
+/** Default number of method calls to make in IPC benchmark */
+#define XBENCH_CALLS_DEFAULT       1000
+
+/** Default number of method calls in flight in IPC benchmark */
+#define XBENCH_CONCURRENCY_DEFAULT 4
+
+/** Read-only mce method calls usable in IPC benchmark */
+static const char * const xbench_methods_all[] =
+{
+        MCE_DISPLAY_STATUS_GET,
+        MCE_TKLOCK_MODE_GET,
+        MCE_CONFIG_GET,
+        MCE_VERSION_GET,
+        MCE_CALL_STATE_GET,
+        0
+};
+
+/** Method calls to make in IPC benchmark; NULL = benchmark not requested */
+static gchar **xbench_methods = 0;
+
+/** Total number of method calls to make */
+static int xbench_calls = XBENCH_CALLS_DEFAULT;
+
+/** Maximum number of method calls in flight */
+static int xbench_concurrency = XBENCH_CONCURRENCY_DEFAULT;
+
+/** Method call rate limit [calls/s]; 0 = unlimited */
+static int xbench_rate = 0;
+
+/** Benchmark method call in flight */
+typedef struct
+{
+        /** Time when the call was sent [us, monotonic] */
+        int64_t started;
+} xbench_call_t;
+
+/** Collected round trip times [us] */
+static int64_t *xbench_rtt = 0;
+
+/** Number of replies received */
+static int xbench_done = 0;
+
+/** Number of error replies received */
+static int xbench_errors = 0;
+
+/** Number of method calls in flight */
+static int xbench_inflight = 0;
+
+/** Handle --benchmark-ipc command line option
+ *
+ * @param arg comma separated list of method names, or NULL for default set
+ */
+static bool xmce_benchmark_ipc(const char *arg)
+{
+        g_strfreev(xbench_methods);
+
+        if( !arg ) {
+                xbench_methods = g_strdupv((gchar **)xbench_methods_all);
+                return true;
+        }
+
+        xbench_methods = g_strsplit(arg, ",", 0);
+
+        for( size_t i = 0; xbench_methods[i]; ++i ) {
+                if( !g_strv_contains(xbench_methods_all, xbench_methods[i]) ) {
+                        errorf("%s: not a benchmarkable method\n",
+                               xbench_methods[i]);
+                        return false;
+                }
+        }
+
+        if( !xbench_methods[0] ) {
+                errorf("no methods given\n");
+                return false;
+        }
+
+        return true;
+}
+
+/** Handle --benchmark-ipc-calls command line option
+ *
+ * @param arg total number of method calls to make
+ */
+static bool xmce_benchmark_ipc_calls(const char *arg)
+{
+        int val = xmce_parse_integer(arg);
+
+        if( val < 1 ) {
+                errorf("%s: invalid number of calls\n", arg);
+                return false;
+        }
+
+        xbench_calls = val;
+        return true;
+}
+
+/** Handle --benchmark-ipc-concurrency command line option
+ *
+ * @param arg maximum number of method calls in flight
+ */
+static bool xmce_benchmark_ipc_concurrency(const char *arg)
+{
+        int val = xmce_parse_integer(arg);
+
+        if( val < 1 ) {
+                errorf("%s: invalid concurrency\n", arg);
+                return false;
+        }
+
+        xbench_concurrency = val;
+        return true;
+}
+
+/** Handle --benchmark-ipc-rate command line option
+ *
+ * @param arg method call rate limit [calls/s], or 0 for unlimited
+ */
+static bool xmce_benchmark_ipc_rate(const char *arg)
+{
+        int val = xmce_parse_integer(arg);
+
+        if( val < 0 ) {
+                errorf("%s: invalid call rate\n", arg);
+                return false;
+        }
+
+        xbench_rate = val;
+        return true;
+}
+
+/** Construct benchmark method call message
+ *
+ * @param method mce method name
+ *
+ * @return method call message, or NULL on failure
+ */
+static DBusMessage *xbench_create_request(const char *method)
+{
+        DBusMessage     *req = 0;
+        DBusMessageIter  body;
+
+        if( !(req = xmce_setting_request(method)) )
+                goto EXIT;
+
+        if( !strcmp(method, MCE_CONFIG_GET) ) {
+                if( !dbushelper_init_write_iterator(req, &body) ||
+                    !dbushelper_write_path(&body,
+                                           MCE_SETTING_DISPLAY_BRIGHTNESS) ) {
+                        dbus_message_unref(req), req = 0;
+                        goto EXIT;
+                }
+        }
+
+EXIT:
+        return req;
+}
+
+/** Pending call notification callback for benchmark method calls
+ *
+ * @param pc   pending call
+ * @param aptr benchmark call data
+ */
+static void xbench_reply_cb(DBusPendingCall *pc, void *aptr)
+{
+        xbench_call_t *call = aptr;
+        DBusMessage   *rsp  = dbus_pending_call_steal_reply(pc);
+
+        if( !rsp || dbus_message_get_type(rsp) == DBUS_MESSAGE_TYPE_ERROR )
+                xbench_errors += 1;
+
+        xbench_rtt[xbench_done++] = g_get_monotonic_time() - call->started;
+        xbench_inflight -= 1;
+
+        if( rsp ) dbus_message_unref(rsp);
+}
+
+/** Compare function for sorting round trip times
+ */
+static int xbench_rtt_compare(const void *a, const void *b)
+{
+        int64_t lhs = *(const int64_t *)a;
+        int64_t rhs = *(const int64_t *)b;
+
+        return (lhs > rhs) - (lhs < rhs);
+}
+
+/** Get percentile from sorted array of round trip times
+ *
+ * @param pct percentile 0 ... 100
+ *
+ * @return round trip time [ms]
+ */
+static double xbench_rtt_percentile(int pct)
+{
+        /* Nearest rank: ceil(pct / 100 * N) - 1 */
+        int idx = (pct * xbench_done + 99) / 100 - 1;
+
+        if( idx < 0 )
+                idx = 0;
+        if( idx >= xbench_done )
+                idx = xbench_done - 1;
+
+        return xbench_rtt[idx] * 1e-3;
+}
+
+/** Execute IPC benchmark and print out results
+ *
+ * Method calls are sent asynchronously keeping at most the configured
+ * number of them in flight and, if rate limit is used, spreading them
+ * evenly over time.
+ *
+ * @return true if the benchmark was completed without errors,
+ *         false otherwise
+ */
+static bool xbench_run(void)
+{
+        bool            res     = false;
+        DBusConnection *bus     = xdbus_init();
+        int             sent    = 0;
+        int             methods = g_strv_length(xbench_methods);
+        int64_t         t_beg   = 0;
+        int64_t         t_end   = 0;
+
+        xbench_rtt      = g_malloc0(xbench_calls * sizeof *xbench_rtt);
+        xbench_done     = 0;
+        xbench_errors   = 0;
+        xbench_inflight = 0;
+
+        t_beg = g_get_monotonic_time();
+
+        while( xbench_done < sent || sent < xbench_calls ) {
+                int64_t now     = g_get_monotonic_time();
+                int     wait_ms = -1;
+
+                while( sent < xbench_calls &&
+                       xbench_inflight < xbench_concurrency ) {
+                        if( xbench_rate > 0 ) {
+                                int64_t due = t_beg + sent * 1000000LL / xbench_rate;
+                                if( now < due ) {
+                                        wait_ms = (int)((due - now + 999) / 1000);
+                                        break;
+                                }
+                        }
+
+                        const char      *method = xbench_methods[sent % methods];
+                        DBusMessage     *req    = xbench_create_request(method);
+                        DBusPendingCall *pc     = 0;
+
+                        if( !req )
+                                goto EXIT;
+
+                        xbench_call_t *call = g_malloc0(sizeof *call);
+                        call->started = g_get_monotonic_time();
+
+                        if( !dbus_connection_send_with_reply(bus, req, &pc, -1) || !pc ) {
+                                errorf("%s: failed to send method call\n", method);
+                                dbus_message_unref(req);
+                                g_free(call);
+                                goto EXIT;
+                        }
+
+                        dbus_pending_call_set_notify(pc, xbench_reply_cb,
+                                                     call, g_free);
+                        dbus_pending_call_unref(pc);
+                        dbus_message_unref(req);
+
+                        sent += 1;
+                        xbench_inflight += 1;
+                }
+
+                if( !dbus_connection_read_write_dispatch(bus, wait_ms) ) {
+                        errorf("disconnected from system bus\n");
+                        goto EXIT;
+                }
+        }
+
+        t_end = g_get_monotonic_time();
+
+        qsort(xbench_rtt, xbench_done, sizeof *xbench_rtt,
+              xbench_rtt_compare);
+
+        gchar *names = g_strjoinv(",", xbench_methods);
+        printf("%-16s %s\n", "methods:", names);
+        g_free(names);
+
+        printf("%-16s %d\n", "concurrency:", xbench_concurrency);
+        if( xbench_rate > 0 )
+                printf("%-16s %d calls/s\n", "rate limit:", xbench_rate);
+        else
+                printf("%-16s %s\n", "rate limit:", "none");
+        printf("%-16s %d\n", "calls:", xbench_done);
+        printf("%-16s %d\n", "errors:", xbench_errors);
+        printf("%-16s %.3f s\n", "duration:", (t_end - t_beg) * 1e-6);
+        printf("%-16s %.1f calls/s\n", "throughput:",
+               xbench_done * 1e6 / MAX(t_end - t_beg, 1));
+        printf("%-16s %.3f ms\n", "rtt min:", xbench_rtt_percentile(0));
+        printf("%-16s %.3f ms\n", "rtt p50:", xbench_rtt_percentile(50));
+        printf("%-16s %.3f ms\n", "rtt p95:", xbench_rtt_percentile(95));
+        printf("%-16s %.3f ms\n", "rtt p99:", xbench_rtt_percentile(99));
+        printf("%-16s %.3f ms\n", "rtt max:", xbench_rtt_percentile(100));
+
+        res = (xbench_errors == 0);
+
+EXIT:
+        /* Wait for replies to calls that are still in flight */
+        while( xbench_inflight > 0 &&
+               dbus_connection_read_write_dispatch(bus, -1) ) {
+                /* nop */
+        }
+
+        g_free(xbench_rtt), xbench_rtt = 0;
+
+        return res;
+}
+
+/* ========================================================================= *
+ * SIGNAL MONITOR
+ * ========================================================================= */
+
+/** Maximum time between causally related signals [us] */
+#define XMON_TRANSITION_MAX_US (5 * 1000 * 1000)
+
+/** Causally related pair of mce signals */
+typedef struct
+{
+        /** Human readable description */
+        const char *label;
+
+        /** Name of the signal that starts the transition */
+        const char *from_sig;
+
+        /** Required first string argument, or NULL for any */
+        const char *from_arg;
+
+        /** Name of the signal that ends the transition */
+        const char *to_sig;
+
+        /** Required first string argument, or NULL for any */
+        const char *to_arg;
+
+        /** Time when starting signal was seen [us, monotonic]; 0 = none */
+        int64_t     started;
+
+        /** Number of completed transitions */
+        int         count;
+
+        /** Minimum transition time [us] */
+        int64_t     min;
+
+        /** Maximum transition time [us] */
+        int64_t     max;
+
+        /** Sum of transition times [us] */
+        int64_t     sum;
+} xmon_transition_t;
+
+/** Transitions to measure when latency analysis is enabled
+ *
+ * Note that power button trigger signal is not sent on every power
+ * key press, only for power key actions configured to send it, home
+ * key presses and unlock requests redirected to the ui.
+ */
+static xmon_transition_t xmon_transitions[] =
+{
+        {
+                .label    = "power button trigger -> display on",
+                .from_sig = MCE_POWER_BUTTON_TRIGGER,
+                .to_sig   = MCE_DISPLAY_SIG,
+                .to_arg   = MCE_DISPLAY_ON_STRING,
+        },
+        {
+                .label    = "power button trigger -> display off",
+                .from_sig = MCE_POWER_BUTTON_TRIGGER,
+                .to_sig   = MCE_DISPLAY_SIG,
+                .to_arg   = MCE_DISPLAY_OFF_STRING,
+        },
+        {
+                .label    = "tklock locked -> display off",
+                .from_sig = MCE_TKLOCK_MODE_SIG,
+                .from_arg = MCE_TK_LOCKED,
+                .to_sig   = MCE_DISPLAY_SIG,
+                .to_arg   = MCE_DISPLAY_OFF_STRING,
+        },
+        {
+                .label    = "tklock unlocked -> display on",
+                .from_sig = MCE_TKLOCK_MODE_SIG,
+                .from_arg = MCE_TK_UNLOCKED,
+                .to_sig   = MCE_DISPLAY_SIG,
+                .to_arg   = MCE_DISPLAY_ON_STRING,
+        },
+        // sentinel
+        {
+                .label = 0,
+        }
+};
+
+/** Whether transition latencies should be reported */
+static bool xmon_latency = false;
+
+/** Time when the previous signal was received [us, monotonic] */
+static int64_t xmon_previous = 0;
+
+/** Helper for matching signal against transition end point
+ *
+ * @param sig      name of signal to match against
+ * @param arg      required first string argument, or NULL
+ * @param have_sig name of received signal
+ * @param have_arg first string argument of received signal, or NULL
+ *
+ * @return true if signal matches, false otherwise
+ */
+static bool xmon_signal_matches(const char *sig, const char *arg,
+                                const char *have_sig, const char *have_arg)
+{
+        if( strcmp(sig, have_sig) )
+                return false;
+
+        if( arg && (!have_arg || strcmp(arg, have_arg)) )
+                return false;
+
+        return true;
+}
+
+/** Update transition tracking and report completed transitions
+ *
+ * @param now time when signal was received [us, monotonic]
+ * @param sig name of the signal
+ * @param arg first string argument of the signal, or NULL
+ */
+static void xmon_transitions_update(int64_t now, const char *sig,
+                                    const char *arg)
+{
+        /* Evaluate completed transitions first */
+        for( xmon_transition_t *tr = xmon_transitions; tr->label; ++tr ) {
+                if( !tr->started )
+                        continue;
+
+                int64_t dur = now - tr->started;
+
+                if( dur > XMON_TRANSITION_MAX_US ) {
+                        tr->started = 0;
+                        continue;
+                }
+
+                if( !xmon_signal_matches(tr->to_sig, tr->to_arg, sig, arg) )
+                        continue;
+
+                if( tr->count == 0 || tr->min > dur )
+                        tr->min = dur;
+                if( tr->count == 0 || tr->max < dur )
+                        tr->max = dur;
+                tr->sum   += dur;
+                tr->count += 1;
+
+                printf(">> %s: %.3f ms (n=%d min=%.3f avg=%.3f max=%.3f)\n",
+                       tr->label, dur * 1e-3, tr->count,
+                       tr->min * 1e-3, tr->sum * 1e-3 / tr->count,
+                       tr->max * 1e-3);
+        }
+
+        /* The first change of the ending signal ends all transitions
+         * waiting for it, whether the argument matched or not */
+        for( xmon_transition_t *tr = xmon_transitions; tr->label; ++tr ) {
+                if( !strcmp(tr->to_sig, sig) )
+                        tr->started = 0;
+        }
 
-        return true;
+        /* Then start new transitions */
+        for( xmon_transition_t *tr = xmon_transitions; tr->label; ++tr ) {
+                if( xmon_signal_matches(tr->from_sig, tr->from_arg, sig, arg) )
+                        tr->started = now;
+        }
 }
 
-/* ------------------------------------------------------------------------- *
- * special
- * ------------------------------------------------------------------------- */
+/** Append basic type signal arguments to string
+ *
+ * @param msg D-Bus signal message
+ * @param out string to append to
+ *
+ * @return first string argument of the signal, or NULL
+ */
+static const char *xmon_format_args(DBusMessage *msg, GString *out)
+{
+        const char      *first = 0;
+        DBusMessageIter  iter;
+        int              type;
 
-/** Handle --block command line option
+        if( !dbus_message_iter_init(msg, &iter) )
+                goto EXIT;
+
+        for( ; (type = dbus_message_iter_get_arg_type(&iter)) != DBUS_TYPE_INVALID;
+             dbus_message_iter_next(&iter) ) {
+                switch( type ) {
+                case DBUS_TYPE_STRING:
+                case DBUS_TYPE_OBJECT_PATH:
+                case DBUS_TYPE_SIGNATURE: {
+                        const char *val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " \"%s\"", val);
+                        if( !first && type == DBUS_TYPE_STRING )
+                                first = val;
+                        break;
+                }
+                case DBUS_TYPE_BOOLEAN: {
+                        dbus_bool_t val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append(out, val ? " true" : " false");
+                        break;
+                }
+                case DBUS_TYPE_BYTE: {
+                        unsigned char val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " %u", val);
+                        break;
+                }
+                case DBUS_TYPE_INT32: {
+                        dbus_int32_t val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " %"PRId32, val);
+                        break;
+                }
+                case DBUS_TYPE_UINT32: {
+                        dbus_uint32_t val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " %"PRIu32, val);
+                        break;
+                }
+                case DBUS_TYPE_INT64: {
+                        dbus_int64_t val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " %"PRId64, (int64_t)val);
+                        break;
+                }
+                case DBUS_TYPE_UINT64: {
+                        dbus_uint64_t val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " %"PRIu64, (uint64_t)val);
+                        break;
+                }
+                case DBUS_TYPE_DOUBLE: {
+                        double val = 0;
+                        dbus_message_iter_get_basic(&iter, &val);
+                        g_string_append_printf(out, " %g", val);
+                        break;
+                }
+                default:
+                        g_string_append_printf(out, " <%s>",
+                                               dbushelper_get_type_name(type));
+                        break;
+                }
+        }
+
+EXIT:
+        return first;
+}
+
+/** D-Bus message filter for printing out mce signals
  *
- * @param args optarg from command line, or NULL
+ * @param con  D-Bus connection
+ * @param msg  received message
+ * @param aptr (unused)
+ *
+ * @return DBUS_HANDLER_RESULT_NOT_YET_HANDLED
  */
-static bool mcetool_block(const char *args)
+static DBusHandlerResult xmon_filter_cb(DBusConnection *con,
+                                        DBusMessage *msg, void *aptr)
 {
-        debugf("%s(%s)\n", __FUNCTION__, args ?: "inf");
-        struct timespec ts;
+        (void)con;
+        (void)aptr;
 
-        if( mcetool_parse_timspec(&ts, args) )
-                TEMP_FAILURE_RETRY(nanosleep(&ts, &ts));
-        else
-                pause();
+        int64_t     now  = g_get_monotonic_time();
+        const char *sig  = 0;
+        const char *arg  = 0;
+        GString    *text = 0;
 
-        return true;
+        if( dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_SIGNAL )
+                goto EXIT;
+
+        if( !dbus_message_has_interface(msg, MCE_SIGNAL_IF) )
+                goto EXIT;
+
+        if( !(sig = dbus_message_get_member(msg)) )
+                goto EXIT;
+
+        text = g_string_new(0);
+        arg = xmon_format_args(msg, text);
+
+        printf("%10.3f %+9.3f %s%s\n",
+               now * 1e-6,
+               xmon_previous ? (now - xmon_previous) * 1e-6 : 0.0,
+               sig, text->str);
+
+        xmon_previous = now;
+
+        if( xmon_latency )
+                xmon_transitions_update(now, sig, arg);
+
+        fflush(stdout);
+
+EXIT:
+        if( text )
+                g_string_free(text, TRUE);
+
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
-/** Handle --demo-mode command line option
+/** Handle --monitor-signals command line option
  *
- * @param args optarg from command line
+ * Prints out all mce signals with monotonic timestamps until
+ * the connection to system bus is lost.
+ *
+ * @param arg "latency" to enable transition latency reporting, or NULL
  */
-static bool xmce_set_demo_mode(const char *args)
+static bool xmce_monitor_signals(const char *arg)
 {
-        bool res = true;
-        debugf("%s(%s)\n", __FUNCTION__, args);
-        if( !strcmp(args, "on") ) {
-                // mcetool --unblank-screen
-                //         --set-inhibit-mode=stay-on
-                //         --set-tklock-mode=unlocked
-                //         --set-tklock-blank=disabled
-                xmce_set_display_state("on");
-                xmce_set_inhibit_mode("stay-on");
-                xmce_set_tklock_mode("unlocked");
-                xmce_set_tklock_blank("disabled");
+        bool            res = false;
+        DBusConnection *bus = xdbus_init();
+        DBusError       err = DBUS_ERROR_INIT;
+
+        if( arg ) {
+                if( strcmp(arg, "latency") ) {
+                        errorf("%s: invalid monitoring mode\n", arg);
+                        goto EXIT;
+                }
+                xmon_latency = true;
         }
-        else if( !strcmp(args, "dim")) {
-                // mcetool --dim-screen
-                //         --set-inhibit-mode=stay-dim
-                //         --set-tklock-mode=unlocked
-                //         --set-tklock-blank=disabled
-                xmce_set_display_state("dim");
-                xmce_set_inhibit_mode("stay-dim");
-                xmce_set_tklock_mode("unlocked");
-                xmce_set_tklock_blank("disabled");
+
+        dbus_bus_add_match(bus,
+                           "type='signal'"
+                           ",path='"MCE_SIGNAL_PATH"'"
+                           ",interface='"MCE_SIGNAL_IF"'",
+                           &err);
+
+        if( dbus_error_is_set(&err) ) {
+                errorf("failed to add match: %s: %s\n",
+                       err.name, err.message);
+                goto EXIT;
         }
-        else if( !strcmp(args, "off")) {
-                // mcetool --blank-screen
-                //         --set-inhibit-mode=disabled
-                //         --set-tklock-mode=locked
-                //         --set-tklock-blank=enabled
-                xmce_set_display_state("off");
-                xmce_set_inhibit_mode("disabled");
-                xmce_set_tklock_mode("locked");
-                xmce_set_tklock_blank("enabled");
+
+        if( !dbus_connection_add_filter(bus, xmon_filter_cb, 0, 0) ) {
+                errorf("failed to add message filter\n");
+                goto EXIT;
         }
-        else {
-                errorf("%s: invalid demo mode value\n", args);
-                res = false;
+
+        printf("%10s %9s %s\n", "time/s", "delta/s", "signal");
+        fflush(stdout);
+
+        while( dbus_connection_read_write_dispatch(bus, -1) ) {
+                /* nop */
         }
 
+        dbus_connection_remove_filter(bus, xmon_filter_cb, 0);
+
+        res = true;
+
+EXIT:
+        dbus_error_free(&err);
+
         return res;
 }
 
@@ -5671,6 +6817,8 @@ static bool xmce_set_demo_mode(const char *args)
 static bool mcetool_do_help(const char *arg);
 static bool mcetool_do_long_help(const char *arg);
 static bool mcetool_do_version(const char *arg);
+static bool mcetool_do_batch(const char *arg);
+static bool mcetool_do_batch_window(const char *arg);
 
 static bool mcetool_do_unblank_screen(const char *arg)
 {
@@ -5742,6 +6890,25 @@ static const mce_opt_t options[] =
                         "the currently running mce process gets accounted\n"
                         "as UNDEF.\n"
         },
+        {
+                .name        = "get-display-transition-stats",
+                .without_arg = xmce_get_display_transition_stats,
+                .with_arg    = xmce_get_display_transition_stats,
+                .values      = "human|machine",
+                .usage       =
+                        "get display state transition latency statistics\n"
+                        "\n"
+                        "Durations are given in milliseconds for each display\n"
+                        "state transition, and for the display state machine\n"
+                        "steps such as waiting for compositor or frame buffer\n"
+                        "power up within each transition. Percentiles are\n"
+                        "estimated from log2 histograms and are thus upper\n"
+                        "bounds.\n"
+                        "\n"
+                        "Machine readable output lists: name, count, min, max,\n"
+                        "total and histogram bucket counts, where bucket 0 is\n"
+                        "below 1 ms and bucket N is below 2^N ms.\n"
+        },
         {
                 .name        = "blank-prevent",
                 .flag        = 'P',
@@ -5845,6 +7012,14 @@ static const mce_opt_t options[] =
                         "set never blank mode; valid modes are:\n"
                         "'disabled', 'enabled'\n"
         },
+        {
+                .name        = "set-speculative-power-up",
+                .with_arg    = xmce_set_speculative_power_up,
+                .values      = "enabled|disabled",
+                .usage       =
+                        "start display power up already on power key press;\n"
+                        "valid modes are: 'enabled' and 'disabled'\n"
+        },
         {
                 .name        = "set-autolock-mode",
                 .flag        = 'K',
@@ -6235,6 +7410,34 @@ static const mce_opt_t options[] =
                 .usage       =
                         "get device uptime and time spent in suspend\n"
         },
+        {
+                .name        = "dump-datapipe-recording",
+                .without_arg = xmce_dump_datapipe_recording,
+                .usage       =
+                        "make mce write recently executed datapipe values\n"
+                        "to a file and print out the file path; the file\n"
+                        "can be replayed with mce --replay-datapipes\n"
+        },
+        {
+                .name        = "dispatch-profile",
+                .with_arg    = xmce_dispatch_profile,
+                .values      = "start|stop|show",
+                .usage       =
+                        "control mce main loop dispatch profiling\n"
+                        "\n"
+                        "start: clear statistics and start counting wakeups\n"
+                        "       and cpu time per io monitor, D-Bus message\n"
+                        "       and timer\n"
+                        "stop:  stop profiling, statistics are retained\n"
+                        "show:  print out collected statistics\n"
+        },
+        {
+                .name        = "get-startup-timeline",
+                .without_arg = xmce_get_startup_timeline,
+                .usage       =
+                        "print out duration of mce startup phases and\n"
+                        "module loading\n"
+        },
         {
                 .name        = "set-cpu-scaling-governor",
                 .flag        = 'S',
@@ -6818,6 +8021,32 @@ static const mce_opt_t options[] =
                 .usage       =
                         "set critical limit for active memory pages; zero=disabled\n"
         },
+        {
+                .name        = "set-memstall-warning",
+                .with_arg    = xmce_set_memnotify_warning_stall,
+                .values      = "msec",
+                .usage       =
+                        "set warning limit for time some tasks stall on memory\n"
+                        "within stall window; zero=disabled\n"
+                        "\n"
+                        "Used when kernel provides /proc/pressure/memory instead\n"
+                        "of /dev/memnotify.\n"
+        },
+        {
+                .name        = "set-memstall-critical",
+                .with_arg    = xmce_set_memnotify_critical_stall,
+                .values      = "msec",
+                .usage       =
+                        "set critical limit for time all tasks stall on memory\n"
+                        "within stall window; zero=disabled\n"
+        },
+        {
+                .name        = "set-memstall-window",
+                .with_arg    = xmce_set_memnotify_stall_window,
+                .values      = "msec",
+                .usage       =
+                        "set memory stall tracking window, 500 ... 10000 ms\n"
+        },
         {
                 .name        = "set-exception-length-call-in",
                 .with_arg    = xmce_set_exception_length_call_in,
@@ -6917,6 +8146,92 @@ static const mce_opt_t options[] =
                         "If no keyish is given, all settings are reset.\n"
         },
 
+        {
+                .name        = "monitor-signals",
+                .with_arg    = xmce_monitor_signals,
+                .without_arg = xmce_monitor_signals,
+                .values      = "latency",
+                .usage       =
+                        "print out mce signals with monotonic timestamps until\n"
+                        "interrupted.\n"
+                        "\n"
+                        "If 'latency' is given, time between related signals is\n"
+                        "reported too, e.g. from tklock getting locked to display\n"
+                        "off. Transitions starting from "MCE_POWER_BUTTON_TRIGGER"\n"
+                        "are seen only if power key actions are configured to\n"
+                        "send the signal (see --set-powerkey-dbus-action), or\n"
+                        "when the home key is used.\n"
+        },
+        {
+                .name        = "benchmark-ipc",
+                .with_arg    = xmce_benchmark_ipc,
+                .without_arg = xmce_benchmark_ipc,
+                .values      = "method[,method]...",
+                .usage       =
+                        "measure mce method call round trip latency; valid\n"
+                        "methods are:\n"
+                        "  "MCE_DISPLAY_STATUS_GET", "MCE_TKLOCK_MODE_GET",\n"
+                        "  "MCE_CONFIG_GET", "MCE_VERSION_GET",\n"
+                        "  "MCE_CALL_STATE_GET"\n"
+                        "\n"
+                        "Calls are made round robin from the given methods, or\n"
+                        "all of the above if none are given. Throughput and\n"
+                        "p50/p95/p99 latencies are printed out at the end.\n"
+        },
+        {
+                .name        = "benchmark-ipc-calls",
+                .with_arg    = xmce_benchmark_ipc_calls,
+                .values      = "count",
+                .usage       =
+                        "set number of method calls to make in IPC benchmark;\n"
+                        "default is "G_STRINGIFY(XBENCH_CALLS_DEFAULT)".\n"
+        },
+        {
+                .name        = "benchmark-ipc-concurrency",
+                .with_arg    = xmce_benchmark_ipc_concurrency,
+                .values      = "count",
+                .usage       =
+                        "set number of method calls to keep in flight in IPC\n"
+                        "benchmark; default is "G_STRINGIFY(XBENCH_CONCURRENCY_DEFAULT)".\n"
+        },
+        {
+                .name        = "benchmark-ipc-rate",
+                .with_arg    = xmce_benchmark_ipc_rate,
+                .values      = "calls/s",
+                .usage       =
+                        "limit method call rate in IPC benchmark; 0 means no\n"
+                        "limit, which is also the default.\n"
+        },
+        {
+                .name        = "batch",
+                .with_arg    = mcetool_do_batch,
+                .values      = "file|-",
+                .usage       =
+                        "execute commands read from file, or from stdin if '-'\n"
+                        "is given, over a single D-Bus connection.\n"
+                        "\n"
+                        "Each line can contain one or more options, written as\n"
+                        "they would be on the command line. Empty lines and lines\n"
+                        "starting with '#' are ignored. Setting changes are sent\n"
+                        "without waiting for replies, see --batch-window.\n"
+                        "\n"
+                        "Invalid option values fail only the command on that line,\n"
+                        "execution continues from the next line. Replies to calls\n"
+                        "already in flight are still collected.\n"
+                        "\n"
+                        "After all commands have been executed, success status\n"
+                        "and duration of each command is printed out.\n"
+        },
+        {
+                .name        = "batch-window",
+                .with_arg    = mcetool_do_batch_window,
+                .values      = "count",
+                .usage       =
+                        "set maximum number of setting changes that can be in\n"
+                        "flight in batch mode; 0 disables pipelining,\n"
+                        "default is "G_STRINGIFY(XBATCH_WINDOW_DEFAULT)".\n"
+        },
+
         // sentinel
         {
                 .name = 0
@@ -6972,6 +8287,172 @@ static bool mcetool_do_long_help(const char *arg)
         return mcetool_do_help(arg ?: "all");
 }
 
+/* ========================================================================= *
+ * BATCH MODE
+ * ========================================================================= */
+
+/** Batch input file given via --batch, or NULL */
+static const char *xbatch_input = 0;
+
+/** Handle --batch command line option
+ *
+ * @param arg path to batch file, or "-" for stdin
+ */
+static bool mcetool_do_batch(const char *arg)
+{
+        if( xbatch_cmd ) {
+                errorf("%s: nested batch files are not supported\n", arg);
+                return false;
+        }
+
+        xbatch_input = arg;
+        return true;
+}
+
+/** Handle --batch-window command line option
+ *
+ * @param arg number of calls to keep in flight
+ */
+static bool mcetool_do_batch_window(const char *arg)
+{
+        int val = xmce_parse_integer(arg);
+
+        if( val < 0 ) {
+                errorf("%s: invalid batch window\n", arg);
+                return false;
+        }
+
+        xbatch_window = val;
+        return true;
+}
+
+/** Execute one batch command line
+ *
+ * @param cmd batch command to execute
+ */
+static void xbatch_execute(xbatch_cmd_t *cmd)
+{
+        GError  *err  = 0;
+        gchar  **argv = 0;
+        gint     argc = 0;
+        gchar   *line = g_strdup_printf(PROG_NAME" %s", cmd->text);
+
+        xbatch_cmd = cmd;
+        cmd->ok = FALSE;
+        cmd->started = g_get_monotonic_time();
+
+        if( !g_shell_parse_argv(line, &argc, &argv, &err) ) {
+                errorf("line %d: %s\n", cmd->line, err->message);
+                goto EXIT;
+        }
+
+        /* Make getopt_long() start from scratch */
+        optind = 0;
+
+        cmd->ok = TRUE;
+
+        if( setjmp(xbatch_abort_env) ) {
+                /* Option handler rejected its input */
+                cmd->ok = FALSE;
+        }
+        else if( !mce_command_line_parse(options, argc, argv) ) {
+                cmd->ok = FALSE;
+        }
+        else if( optind < argc ) {
+                errorf("line %d: %s: unexpected argument\n",
+                       cmd->line, argv[optind]);
+                cmd->ok = FALSE;
+        }
+
+EXIT:
+        if( cmd->pending == 0 )
+                cmd->finished = g_get_monotonic_time();
+
+        xbatch_cmd = 0;
+
+        g_strfreev(argv);
+        g_clear_error(&err);
+        g_free(line);
+}
+
+/** Execute commands from batch input and report results
+ *
+ * @return true if all commands succeeded, false otherwise
+ */
+static bool xbatch_run(void)
+{
+        bool       res    = false;
+        FILE      *file   = 0;
+        GPtrArray *cmds   = g_ptr_array_new();
+        char      *buff   = 0;
+        size_t     size   = 0;
+        int        lineno = 0;
+        int        failed = 0;
+        int64_t    t_beg  = g_get_monotonic_time();
+
+        if( !strcmp(xbatch_input, "-") )
+                file = stdin;
+        else if( !(file = fopen(xbatch_input, "r")) ) {
+                errorf("%s: can't open: %m\n", xbatch_input);
+                goto EXIT;
+        }
+
+        /* Connect up front so that the first command does not pay for it */
+        xdbus_init();
+
+        while( getline(&buff, &size, file) >= 0 ) {
+                gchar *text = g_strstrip(buff);
+
+                ++lineno;
+
+                if( *text == 0 || *text == '#' )
+                        continue;
+
+                xbatch_cmd_t *cmd = g_malloc0(sizeof *cmd);
+                cmd->line = lineno;
+                cmd->text = g_strdup(text);
+                g_ptr_array_add(cmds, cmd);
+
+                xbatch_execute(cmd);
+        }
+
+        /* Collect replies that are still in flight */
+        xbatch_pipeline_flush();
+
+        printf("\n%-6s %-6s %10s  %s\n", "line", "status", "time/ms", "command");
+        for( guint i = 0; i < cmds->len; ++i ) {
+                xbatch_cmd_t *cmd = g_ptr_array_index(cmds, i);
+
+                if( !cmd->ok )
+                        ++failed;
+
+                printf("%-6d %-6s %10.3f  %s\n",
+                       cmd->line, cmd->ok ? "ok" : "FAILED",
+                       (cmd->finished - cmd->started) * 1e-3,
+                       cmd->text);
+        }
+        printf("%u commands, %d failed, %.3f ms total\n",
+               cmds->len, failed,
+               (g_get_monotonic_time() - t_beg) * 1e-3);
+
+        res = (failed == 0);
+
+EXIT:
+        for( guint i = 0; i < cmds->len; ++i ) {
+                xbatch_cmd_t *cmd = g_ptr_array_index(cmds, i);
+                g_free(cmd->text);
+                g_free(cmd);
+        }
+        g_ptr_array_free(cmds, TRUE);
+
+        free(buff);
+
+        if( file && file != stdin )
+                fclose(file);
+
+        return res;
+}
+
 /* ========================================================================= *
  * MCETOOL ENTRY POINT
  * ========================================================================= */
@@ -6999,6 +8480,14 @@ int main(int argc, char **argv)
                 mce_command_line_usage_keys(options, argv + optind);
         }
 
+        /* Execute batch commands after other options */
+        if( xbatch_input && !xbatch_run() )
+                goto EXIT;
+
+        /* Benchmark uses settings from all options */
+        if( xbench_methods && !xbench_run() )
+                goto EXIT;
+
         exitcode = EXIT_SUCCESS;
 
 EXIT: